@@ -1,12 +1,23 @@
 /**
  * Example implementation for bidirectional communication with openMSX.
  *
+ * Start it with '-latency [count] [command]' to measure the round-trip time
+ * of commands instead: the command (default "set power") is sent 'count'
+ * (default 1000) times, each time waiting for the reply before sending the
+ * next one, and statistics about the round-trip times are printed. Run it
+ * both with the emulation running and paused: when paused, commands used to
+ * wait for the (up to 20ms) sleep of the openMSX main loop to end.
+ *
  *  requires: libxml2
  *  compile:
  *    *nix:  g++ `xml2-config --cflags` `xml2-config --libs` openmsx-control-socket.cc
  *    win32: g++ `xml2-config --cflags` `xml2-config --libs` openmsx-control-socket.cc -lwsock32
  */
 
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <string>
 #include <deque>
 #include <vector>
@@ -92,6 +103,9 @@ public:
 	// main loop
 	void start(int sd);
 
+	// measure the round-trip time of a command
+	void latency(int sd, int count, const string& command);
+
 	// send a command to openmsx
 	void sendCommand(const string& command);
 
@@ -110,6 +124,9 @@ private:
 	void doLog();
 	void doUpdate();
 
+	void initParser(int sd);
+	bool receive();
+
 	// commands being executed
 	deque<string> commandStack;
 
@@ -141,6 +158,10 @@ private:
 	string updateType;
 	string updateName;
 
+	// when set, replies are counted instead of printed
+	bool quiet = false;
+	unsigned replies = 0;
+
 	// communication with openmsx process
 	int sd;
 };
@@ -257,6 +278,15 @@ void OpenMSXComm::cb_end_element(OpenMSXComm* comm, const xmlChar* name)
 
 void OpenMSXComm::doReply()
 {
+	++replies;
+	if (quiet) {
+		if (replyStatus != REPLY_OK) {
+			cout << "ERR: " << commandStack.front() << ": "
+			     << content << endl;
+		}
+		commandStack.pop_front();
+		return;
+	}
 	switch (replyStatus) {
 		case REPLY_OK:
 			cout << "OK: ";
@@ -312,7 +342,7 @@ void OpenMSXComm::sendCommand(const string& command)
 	commandStack.push_back(command);
 }
 
-void OpenMSXComm::start(int sd_)
+void OpenMSXComm::initParser(int sd_)
 {
 	sd = sd_;
 
@@ -326,6 +356,25 @@ void OpenMSXComm::start(int sd_)
 	parser_context = xmlCreatePushParserCtxt(&sax_handler, this, 0, 0, 0);
 
 	write(sd, "<openmsx-control>", 17);
+}
+
+// read and parse the data that is available from openMSX, returns false when
+// the connection was closed
+bool OpenMSXComm::receive()
+{
+	char buf[4096];
+	ssize_t size = read(sd, buf, 4096);
+	if (size <= 0) {
+		// openmsx process died
+		return false;
+	}
+	xmlParseChunk(parser_context, buf, size, 0);
+	return true;
+}
+
+void OpenMSXComm::start(int sd_)
+{
+	initParser(sd_);
 
 	// event loop
 	string command; // (partial) input from STDIN
@@ -338,12 +387,7 @@ void OpenMSXComm::start(int sd_)
 		select(sd + 1, &rdfs, NULL, NULL, NULL);
 		if (FD_ISSET(sd, &rdfs)) {
 			// data available from openMSX
-			ssize_t size = read(sd, buf, 4096);
-			if (size == 0) {
-				// openmsx process died
-				break;
-			}
-			xmlParseChunk(parser_context, buf, size, 0);
+			if (!receive()) break;
 		}
 		if (FD_ISSET(STDIN_FILENO, &rdfs)) {
 			// data available from STDIN
@@ -370,6 +414,43 @@ void OpenMSXComm::start(int sd_)
 	xmlFreeParserCtxt(parser_context);
 }
 
+void OpenMSXComm::latency(int sd_, int count, const string& command)
+{
+	initParser(sd_);
+	quiet = true;
+
+	vector<double> times; // in us
+	times.reserve(count);
+	for (int i = 0; i < count; ++i) {
+		unsigned expected = replies + 1;
+		auto start = std::chrono::steady_clock::now();
+		sendCommand(command);
+		while (replies != expected) {
+			if (!receive()) {
+				cout << "Connection closed." << endl;
+				xmlFreeParserCtxt(parser_context);
+				return;
+			}
+		}
+		std::chrono::duration<double, std::micro> d =
+			std::chrono::steady_clock::now() - start;
+		times.push_back(d.count());
+	}
+	xmlFreeParserCtxt(parser_context);
+	if (times.empty()) return;
+
+	std::sort(times.begin(), times.end());
+	double sum = 0.0;
+	for (double t : times) sum += t;
+	cout << "Round-trip time of '" << command << "' (" << count
+	     << " times):\n"
+	     << "  min    " << times.front() << "us\n"
+	     << "  avg    " << sum / times.size() << "us\n"
+	     << "  median " << times[times.size() / 2] << "us\n"
+	     << "  99%    " << times[times.size() * 99 / 100] << "us\n"
+	     << "  max    " << times.back() << "us" << endl;
+}
+
 
 static bool checkSocketDir(const string& dir)
 {
@@ -510,7 +591,7 @@ void collectServers(vector<string>& servers)
 }
 
 
-int main()
+int main(int argc, char** argv)
 {
 #ifdef _WIN32
 	WSAData wsaData;
@@ -528,6 +609,12 @@ int main()
 	int sd = openSocket(servers.front());
 
 	OpenMSXComm comm;
-	comm.start(sd);
+	if ((argc > 1) && (strcmp(argv[1], "-latency") == 0)) {
+		int count = (argc > 2) ? atoi(argv[2]) : 1000;
+		string command = (argc > 3) ? argv[3] : "set power";
+		comm.latency(sd, count, command);
+	} else {
+		comm.start(sd);
+	}
 	return 0;
 }
@@ -0,0 +1,11 @@
+# Configuration for "soundbench" flavour:
+# Build executable that runs the sound chip throughput benchmark
+# (see src/soundbench/SoundChipBench.cc).
+
+# Optimisation flags, like the "opt" flavour.
+CXXFLAGS+=-O3 -DNDEBUG
+
+# Strip executable?
+OPENMSX_STRIP:=false
+
+SOUNDBENCH:=true
@@ -196,6 +196,7 @@ TARGET_FLAGS+=$(shell $(PYTHON) build/cpu2flags.py $(OPENMSX_TARGET_CPU))
 include build/flavour-$(OPENMSX_FLAVOUR).mk
 
 UNITTEST?=false
+SOUNDBENCH?=false
 
 
 # Paths
@@ -306,6 +307,12 @@ else
 SOURCES_FULL:=$(filter-out src/unittest/%.cc,$(SOURCES_FULL))
 endif
 
+ifeq ($(SOUNDBENCH),true)
+SOURCES_FULL:=$(filter-out src/main.cc,$(SOURCES_FULL))
+else
+SOURCES_FULL:=$(filter-out src/soundbench/%.cc,$(SOURCES_FULL))
+endif
+
 # Apply subset to sources list.
 SOURCES_FULL:=$(filter $(SOURCES_PATH)/$(OPENMSX_SUBSET)%,$(SOURCES_FULL))
 ifeq ($(SOURCES_FULL),)
@@ -28,6 +28,7 @@ Some examples will make it much clearer:
       record_channels stop SCC 3,5   stop recording SCC channels 3 and 5
   - To show the current status
       record_channels list           shows which channels are being recorded
+                                     (and write errors or overruns, if any)
 }
 
 set mute_help_text \
@@ -110,6 +111,14 @@ proc get_recording_channels {} {
 		}
 		if {[llength $active]} {
 			lappend result "$device: $active"
+			# report channels for which the disk couldn't keep up
+			dict for {ch status} [machine_info sounddevice $device record] {
+				if {[dict exists $status error]} {
+					lappend result "  channel $ch: stopped, [dict get $status error]"
+				} elseif {[dict get $status overruns] > 0} {
+					lappend result "  channel $ch: [dict get $status overruns] overrun(s)"
+				}
+			}
 		}
 	}
 	return $result
@@ -0,0 +1,207 @@
+# Boot cache: skip the (always identical) boot sequence of a machine.
+#
+# When enabled, the state of a freshly powered up machine is stored a number
+# of emulated seconds after power up (or when the CPU reaches a configured
+# address). The next time the same machine is started, with the same
+# extensions and the same ROM images, that state is loaded instead of
+# emulating the boot sequence again.
+#
+# Media (disks and cassettes) are not part of the cached state: they're
+# removed at power up and inserted again once the cached point is reached
+# (or when the cached state is loaded). So the software on them is only seen
+# by the MSX after that point.
+#
+# Machines with persistent memory (SRAM, EEPROM, flash, which includes the
+# memory of a real time clock) are not cached: the cached state would bring
+# back old contents (and an old clock time), and these are saved to the
+# user's files again when the machine is deleted.
+
+namespace eval boot_cache {
+
+set_help_text clear_boot_cache \
+{clear_boot_cache
+
+Removes all machine states stored by the boot cache. See the 'boot_cache'
+setting.
+}
+
+user_setting create boolean boot_cache \
+{Whether to use the boot cache. When enabled, the state of a machine is
+stored when it reaches the point set with 'boot_cache_time' or 'boot_cache_pc'
+after power up, and that state is loaded on the next start of the same
+machine (same machine config, extensions and ROM images) instead of
+emulating its boot sequence again.
+Disks and cassettes are not part of the stored state, they are inserted after
+that point. Machines with a hard disk or CD-ROM, or with persistent memory
+(e.g. SRAM, or a real time clock) are not cached.
+} false
+
+user_setting create float boot_cache_time \
+{Number of emulated seconds after power up at which the boot cache stores the
+machine state. Not used when 'boot_cache_pc' is set.
+} 5.0 0.1 3600.0
+
+user_setting create string boot_cache_pc \
+{When not empty, the boot cache stores the machine state the first time the CPU
+reaches this address after power up (e.g. 0x4010), instead of after
+'boot_cache_time' seconds.
+} ""
+
+proc cache_dir {} {
+	return [file normalize $::env(OPENMSX_USER_DATA)/../bootcache]
+}
+
+# Everything that influences the boot sequence.
+proc cache_key {} {
+	set key [list [openmsx_info version] [machine_info config_name]]
+	lappend key [lsort [list_extensions]]
+	foreach device [lsort [machine_info device]] {
+		set info [machine_info device $device]
+		if {[dict exists $info actualSHA1]} {
+			lappend key $device [dict get $info actualSHA1]
+		}
+	}
+	if {$::boot_cache_pc ne ""} {
+		lappend key pc [expr {$::boot_cache_pc}]
+	} else {
+		lappend key time $::boot_cache_time
+	}
+	return $key
+}
+
+# FNV-1a, only used to pick a file name: the full key is stored next to the
+# state and checked before the state is used.
+proc key_hash {key} {
+	set h 2166136261
+	foreach c [split $key ""] {
+		set h [expr {(($h ^ [scan $c %c]) * 16777619) & 0xFFFFFFFF}]
+	}
+	return [format %08x $h]
+}
+
+proc read_file {filename} {
+	set f [open $filename "r"]
+	set data [read -nonewline $f]
+	close $f
+	return $data
+}
+
+# Returns the media of the given machine as a list of commands that insert
+# them again, and removes them from the machine.
+proc take_media {machine} {
+	set result [list]
+	foreach drive {diska diskb} {
+		if {[info commands ${machine}::${drive}] eq ""} continue
+		set state [${machine}::${drive}]
+		set options [lindex $state 2]
+		if {"empty" in $options} continue
+		if {"ramdsk" in $options} {
+			lappend result [list $drive ramdsk]
+		} else {
+			lappend result [list $drive insert [lindex $state 1]]
+		}
+		${machine}::${drive} eject
+	}
+	if {[info commands ${machine}::cassetteplayer] ne ""} {
+		set image [lindex [${machine}::cassetteplayer] 1]
+		if {$image ne ""} {
+			lappend result [list cassetteplayer insert $image]
+			${machine}::cassetteplayer eject
+		}
+	}
+	return $result
+}
+
+proc insert_media {machine media} {
+	foreach cmd $media {
+		if {[catch {${machine}::[lindex $cmd 0] {*}[lrange $cmd 1 end]} msg]} {
+			message "Boot cache: couldn't insert media: $msg" warning
+		}
+	}
+}
+
+proc cacheable {machine} {
+	# hard disks and CD-ROMs can't be changed on a running machine
+	foreach cmd {hda hdb hdc hdd cda cdb cdc cdd} {
+		if {[info commands ${machine}::${cmd}] ne ""} {return false}
+	}
+	# persistent memory, also in extensions (the RTC stores its
+	# registers in SRAM as well)
+	foreach debuggable [${machine}::debug list] {
+		if {[string match "* SRAM" $debuggable] ||
+		    [string match "* EEPROM" $debuggable] ||
+		    [${machine}::debug desc $debuggable] eq "flash rom"} {
+			return false
+		}
+	}
+	return true
+}
+
+proc on_boot {} {
+	after boot [namespace code on_boot]
+	if {!$::boot_cache} return
+	set machine [machine]
+	if {$machine eq ""} return
+	# only for a freshly created machine, not on reset
+	if {[machine_info time] != 0} return
+	if {![cacheable $machine]} return
+
+	set key [cache_key]
+	set base [file join [cache_dir] [key_hash $key]]
+	set media [take_media $machine]
+	if {[file exists ${base}.oms] && ![catch {read_file ${base}.key} stored] &&
+	    $stored eq $key} {
+		if {![catch {restore_machine ${base}.oms} newID]} {
+			activate_machine $newID
+			delete_machine $machine
+			insert_media $newID $media
+			return
+		}
+		message "Boot cache: couldn't load ${base}.oms: $newID" warning
+	}
+
+	if {$::boot_cache_pc ne ""} {
+		variable bp
+		set bp [debug set_bp $::boot_cache_pc {} \
+			[namespace code [list store $machine $key $base $media]]]
+	} else {
+		after time $::boot_cache_time \
+			[namespace code [list store $machine $key $base $media]]
+	}
+}
+
+proc store {machine key base media} {
+	variable bp
+	if {[info exists bp]} {
+		catch {debug remove_bp $bp}
+		unset bp
+	}
+	# the machine might have been replaced in the meantime
+	if {$machine ne [machine]} return
+	if {[catch {
+		file mkdir [cache_dir]
+		store_machine $machine ${base}.oms.tmp
+		file rename -force -- ${base}.oms.tmp ${base}.oms
+		set f [open ${base}.key "w"]
+		puts $f $key
+		close $f
+	} msg]} {
+		message "Boot cache: couldn't store machine state: $msg" warning
+		catch {file delete -- ${base}.oms.tmp}
+	}
+	insert_media $machine $media
+}
+
+proc clear_boot_cache {} {
+	foreach f [glob -nocomplain -directory [cache_dir] *.oms *.key] {
+		file delete -- $f
+	}
+}
+
+after boot [namespace code on_boot]
+
+namespace export clear_boot_cache
+
+} ;# namespace boot_cache
+
+namespace import boot_cache::*
@@ -29,6 +29,9 @@ GlobalSettings::GlobalSettings(GlobalCommandController& commandController_)
 		"invalid_psg_directions_callback",
 		"Tcl proc called when the MSX program has set invalid PSG port directions",
 		{})
+	, savestateCompressionSetting(commandController, "savestate_compression",
+		"compression level for savestates and replays: 1 is fastest, 9 gives the smallest files, 0 is no compression",
+		9, 0, 9)
 	, resampleSetting(commandController, "resampler", "Resample algorithm",
 #if PLATFORM_DINGUX
 		// For Dingux, LQ is good compromise between quality and performance
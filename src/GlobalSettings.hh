@@ -47,6 +47,9 @@ public:
 	StringSetting& getInvalidPsgDirectionsSetting() {
 		return invalidPsgDirectionsSetting;
 	}
+	IntegerSetting& getSavestateCompressionSetting() {
+		return savestateCompressionSetting;
+	}
 	EnumSetting<ResampledSoundDevice::ResampleType>& getResampleSetting() {
 		return resampleSetting;
 	}
@@ -70,6 +73,7 @@ private:
 	BooleanSetting pauseOnLostFocusSetting;
 	StringSetting  umrCallBackSetting;
 	StringSetting  invalidPsgDirectionsSetting;
+	IntegerSetting savestateCompressionSetting;
 	EnumSetting<ResampledSoundDevice::ResampleType> resampleSetting;
 	std::vector<std::unique_ptr<IntegerSetting>> deadzoneSettings;
 	ThrottleManager throttleManager;
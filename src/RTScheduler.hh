@@ -4,6 +4,7 @@
 #include "SchedulerQueue.hh"
 #include "Timer.hh"
 #include "likely.hh"
+#include <algorithm>
 #include <cstdint>
 
 namespace openmsx {
@@ -28,6 +29,17 @@ public:
 		}
 	}
 
+	/** Time (in us) until the first RTSchedulable expires, limited to
+	  * 'max'. Used to bound the time the main loop sleeps.
+	  */
+	uint64_t getTimeout(uint64_t max) const
+	{
+		if (queue.empty()) return max;
+		auto now = Timer::getTime();
+		auto t = queue.front().time;
+		return (t <= now) ? 0 : std::min(t - now, max);
+	}
+
 private:
 	// These are called by RTSchedulable
 	friend class RTSchedulable;
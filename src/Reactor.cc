@@ -188,11 +188,23 @@ private:
 	Reactor& reactor;
 };
 
+class StartupTimingInfo final : public InfoTopic
+{
+public:
+	StartupTimingInfo(InfoCommand& openMSXInfoCommand, Reactor& reactor);
+	void execute(span<const TclObject> tokens,
+	             TclObject& result) const override;
+	string help(const vector<string>& tokens) const override;
+private:
+	Reactor& reactor;
+};
+
 
 Reactor::Reactor() = default;
 
 void Reactor::init()
 {
+	initStartTime = Timer::getTime();
 	rtScheduler = make_unique<RTScheduler>();
 	eventDistributor = make_unique<EventDistributor>(*this);
 	globalCliComm = make_unique<GlobalCliComm>();
@@ -244,6 +256,8 @@ void Reactor::init()
 		getOpenMSXInfoCommand());
 	softwareInfoTopic = make_unique<SoftwareInfoTopic>(
 		getOpenMSXInfoCommand(), *this);
+	startupTimingInfo = make_unique<StartupTimingInfo>(
+		getOpenMSXInfoCommand(), *this);
 	tclCallbackMessages = make_unique<TclCallbackMessages>(
 		*globalCliComm, *globalCommandController);
 
@@ -412,10 +426,12 @@ void Reactor::switchMachine(const string& machine)
 	assert(Thread::isMainThread());
 	// Note: loadMachine can throw an exception and in that case the
 	//       motherboard must be considered as not created at all.
+	auto loadStart = Timer::getTime();
 	auto newBoard_ = createEmptyMotherBoard();
 	auto* newBoard = newBoard_.get();
 	newBoard->loadMachine(machine);
 	boards.push_back(move(newBoard_));
+	machineLoadTime = Timer::getTime() - loadStart;
 
 	auto* oldBoard = activeBoard;
 	switchBoard(newBoard);
@@ -529,6 +545,8 @@ void Reactor::run(CommandLineParser& parser)
 		}
 	}
 
+	startupTime = Timer::getTime() - initStartTime;
+
 	while (running) {
 		eventDistributor->deliverEvents();
 		assert(garbageBoards.empty());
@@ -541,7 +559,11 @@ void Reactor::run(CommandLineParser& parser)
 			// to also use a sleep/poll loop, with even shorter
 			// sleep periods as we use here. Maybe in future
 			// SDL implementations this will be improved.
-			eventDistributor->sleep(20 * 1000);
+			// Events from other threads (e.g. commands from
+			// CliConnection) wake us up immediately, and we don't
+			// sleep past the next realtime timer.
+			eventDistributor->sleep(unsigned(
+				rtScheduler->getTimeout(20 * 1000)));
 		}
 	}
 }
@@ -905,8 +927,10 @@ void StoreMachineCommand::execute(span<const TclObject> tokens, TclObject& resul
 
 	auto& board = reactor.getMachine(machineID);
 
-	XmlOutputArchive out(filename);
+	XmlOutputArchive out(filename, reactor.getGlobalSettings()
+		.getSavestateCompressionSetting().getInt());
 	out.serialize("machine", board);
+	out.close();
 	result = filename;
 }
 
@@ -1119,4 +1143,35 @@ string SoftwareInfoTopic::help(const vector<string>& /*tokens*/) const
 	       "given its sha1sum, in a paired list.";
 }
 
+
+// StartupTimingInfo
+
+StartupTimingInfo::StartupTimingInfo(InfoCommand& openMSXInfoCommand, Reactor& reactor_)
+	: InfoTopic(openMSXInfoCommand, "startup_timing")
+	, reactor(reactor_)
+{
+}
+
+void StartupTimingInfo::execute(
+	span<const TclObject> /*tokens*/, TclObject& result) const
+{
+	// all times in milliseconds
+	result.addDictKeyValues("startup",      reactor.startupTime     / 1000.0,
+	                        "machine_load", reactor.machineLoadTime / 1000.0);
+	// Don't load the software database just for this (it's only loaded
+	// when it's needed for the first time).
+	if (auto* db = reactor.softwareDatabase.get()) {
+		result.addDictKeyValues("software_db",        db->getLoadTime() / 1000.0,
+		                        "software_db_cached", db->isFromCache());
+	}
+}
+
+string StartupTimingInfo::help(const vector<string>& /*tokens*/) const
+{
+	return "Returns how long (in ms) the startup of openMSX took (till the "
+	       "main loop is entered), how long loading the last machine "
+	       "took, and (once it's loaded) how long loading the software "
+	       "database took and whether that came from the binary cache.";
+}
+
 } // namespace openmsx
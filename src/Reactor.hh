@@ -49,6 +49,7 @@ class AviRecorder;
 class ConfigInfo;
 class RealTimeInfo;
 class SoftwareInfoTopic;
+class StartupTimingInfo;
 template <typename T> class EnumSetting;
 
 extern int exitCode;
@@ -164,6 +165,7 @@ private:
 	std::unique_ptr<ConfigInfo> machineInfo;
 	std::unique_ptr<RealTimeInfo> realTimeInfo;
 	std::unique_ptr<SoftwareInfoTopic> softwareInfoTopic;
+	std::unique_ptr<StartupTimingInfo> startupTimingInfo;
 	std::unique_ptr<TclCallbackMessages> tclCallbackMessages;
 
 	// Locking rules for activeBoard access:
@@ -189,6 +191,11 @@ private:
 
 	bool isInit = false; // has the init() method been run successfully
 
+	// Timing information (in us), see StartupTimingInfo.
+	uint64_t initStartTime = 0;
+	uint64_t startupTime = 0;     // from init() till the main loop
+	uint64_t machineLoadTime = 0; // of the last switchMachine()
+
 	friend class MachineCommand;
 	friend class TestMachineCommand;
 	friend class CreateMachineCommand;
@@ -197,6 +204,7 @@ private:
 	friend class ActivateMachineCommand;
 	friend class StoreMachineCommand;
 	friend class RestoreMachineCommand;
+	friend class StartupTimingInfo;
 };
 
 } // namespace openmsx
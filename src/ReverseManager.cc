@@ -16,6 +16,7 @@
 #include "CliComm.hh"
 #include "Display.hh"
 #include "Reactor.hh"
+#include "GlobalSettings.hh"
 #include "CommandException.hh"
 #include "MemBuffer.hh"
 #include "ranges.hh"
@@ -639,9 +640,11 @@ void ReverseManager::saveReplay(
 			getCurrentTime()));
 	}
 	try {
-		XmlOutputArchive out(filename);
+		XmlOutputArchive out(filename, motherBoard.getReactor()
+			.getGlobalSettings().getSavestateCompressionSetting().getInt());
 		replay.events = &history.events;
 		out.serialize("replay", replay);
+		out.close();
 	} catch (MSXException&) {
 		if (addSentinel) {
 			history.events.pop_back();
@@ -5,8 +5,10 @@
 #include "CliComm.hh"
 #include "Clock.hh"
 #include "MSXException.hh"
+#include "ranges.hh"
 #include "stl.hh"
 #include "xrange.hh"
+#include <algorithm>
 #include <cstring> // for memcmp
 
 namespace openmsx {
@@ -34,6 +36,11 @@ static const unsigned OUTPUT_FREQUENCY = 4 * BAUDRATE; // 4 samples per bit
 // So every sample repeated 4 times.
 static const unsigned AUDIO_OVERSAMPLE = 4;
 
+// number of output bytes for one byte of data (see writeByte())
+static const unsigned BYTE_SAMPLES = 11 * 4;
+// number of output bytes for the start bit and the data bits of a byte
+static const unsigned DATA_SAMPLES = 9 * 4;
+
 // number of output bytes for silent parts
 static const unsigned SHORT_SILENCE = OUTPUT_FREQUENCY * 1; // 1 second
 static const unsigned LONG_SILENCE  = OUTPUT_FREQUENCY * 2; // 2 seconds
@@ -52,7 +59,27 @@ static const byte BASIC_HEADER [10] = { 0xD3,0xD3,0xD3,0xD3,0xD3,0xD3,0xD3,0xD3,
 CasImage::CasImage(const Filename& filename, FilePool& filePool, CliComm& cliComm)
 {
 	setFirstFileType(CassetteImage::UNKNOWN);
-	convert(filename, filePool, cliComm);
+	File file(filename);
+	bool issueWarning = false;
+	if (!convert(file.mmap(), issueWarning)) {
+		throw MSXException(filename.getOriginal(), ": not a valid CAS image");
+	}
+	if (issueWarning) {
+		 cliComm.printWarning("Skipped unhandled data in ",
+		                      filename.getOriginal());
+	}
+
+	// conversion successful, now calc sha1sum
+	setSha1Sum(filePool.getSha1Sum(file));
+}
+
+CasImage::CasImage(span<const byte> buf)
+{
+	setFirstFileType(CassetteImage::UNKNOWN);
+	bool issueWarning = false;
+	if (!convert(buf, issueWarning)) {
+		throw MSXException("Not a valid CAS image");
+	}
 }
 
 int16_t CasImage::getSampleAt(EmuTime::param time)
@@ -74,6 +101,47 @@ unsigned CasImage::getFrequency() const
 	return OUTPUT_FREQUENCY * AUDIO_OVERSAMPLE;
 }
 
+static size_t timeToPos(EmuTime::param time)
+{
+	static const Clock<OUTPUT_FREQUENCY> zero(EmuTime::zero);
+	return zero.getTicksTill(time);
+}
+
+static EmuTime posToTime(size_t pos)
+{
+	Clock<OUTPUT_FREQUENCY> clk(EmuTime::zero);
+	clk += unsigned(pos);
+	return clk.getTime();
+}
+
+bool CasImage::seekBlock(EmuTime& time) const
+{
+	size_t pos = timeToPos(time);
+	auto it = ranges::find_if(blocks, [&](auto& b) { return b.start >= pos; });
+	if (it == end(blocks)) return false;
+	time = posToTime(it->start);
+	return true;
+}
+
+bool CasImage::readByte(EmuTime& time, byte& value) const
+{
+	size_t pos = timeToPos(time);
+	// last block that starts at or before 'pos'
+	auto it = std::upper_bound(begin(blocks), end(blocks), pos,
+		[](size_t p, const Block& b) { return p < b.start; });
+	if (it == begin(blocks)) return false;
+	--it;
+	// The BIOS syncs on the start bit, so a byte can still be read up to
+	// the end of its data bits; during the stop bits it's the next byte.
+	// Returning the position right after the data bits (instead of after
+	// the stop bits) leaves one full byte of slack for the next call.
+	size_t i = (pos - it->start + BYTE_SAMPLES - DATA_SAMPLES) / BYTE_SAMPLES;
+	if (i >= it->size) return false;
+	value = data[it->offset + i];
+	time = posToTime(it->start + i * BYTE_SAMPLES + DATA_SAMPLES);
+	return true;
+}
+
 void CasImage::fillBuffer(unsigned pos, int** bufs, unsigned num) const
 {
 	size_t nbSamples = output.size();
@@ -131,11 +199,20 @@ void CasImage::writeByte(byte b)
 }
 
 // write data until a header is detected
-bool CasImage::writeData(span<byte> buf, size_t& pos)
+bool CasImage::writeData(span<const byte> buf, size_t& pos)
 {
+	// also remember the data itself, for the fast-load mode
+	auto startPos = pos;
+	blocks.push_back({output.size(), data.size(), 0});
+	auto finish = [&] {
+		data.insert(end(data), buf.data() + startPos, buf.data() + pos);
+		blocks.back().size = pos - startPos;
+	};
+
 	bool eof = false;
 	while ((pos + 8) <= buf.size()) {
 		if (memcmp(&buf[pos], CAS_HEADER, 8) == 0) {
+			finish();
 			return eof;
 		}
 		writeByte(buf[pos]);
@@ -147,16 +224,13 @@ bool CasImage::writeData(span<byte> buf, size_t& pos)
 	while (pos < buf.size()) {
 		writeByte(buf[pos++]);
 	}
+	finish();
 	return false;
 }
 
-void CasImage::convert(const Filename& filename, FilePool& filePool, CliComm& cliComm)
+bool CasImage::convert(span<const byte> buf, bool& issueWarning)
 {
-	File file(filename);
-	auto buf = file.mmap();
-
 	// search for a header in the .cas file
-	bool issueWarning = false;
 	bool headerFound = false;
 	bool firstFile = true;
 	size_t pos = 0;
@@ -215,16 +289,7 @@ void CasImage::convert(const Filename& filename, FilePool& filePool, CliComm& cl
 			issueWarning = true;
 		}
 	}
-	if (!headerFound) {
-		throw MSXException(filename.getOriginal(), ": not a valid CAS image");
-	}
-	if (issueWarning) {
-		 cliComm.printWarning("Skipped unhandled data in ",
-		                      filename.getOriginal());
-	}
-
-	// conversion successful, now calc sha1sum
-	setSha1Sum(filePool.getSha1Sum(file));
+	return headerFound;
 }
 
 } // namespace openmsx
@@ -19,6 +19,8 @@ class CasImage final : public CassetteImage
 {
 public:
 	CasImage(const Filename& fileName, FilePool& filePool, CliComm& cliComm);
+	/** Convert CAS data that is already in memory (no sha1sum). */
+	explicit CasImage(span<const byte> buf);
 
 	// CassetteImage
 	int16_t getSampleAt(EmuTime::param time) override;
@@ -26,16 +28,37 @@ public:
 	unsigned getFrequency() const override;
 	void fillBuffer(unsigned pos, int** bufs, unsigned num) const override;
 
+	// Fast-load support (see CassettePlayer). These work on the position
+	// in the generated signal, 'time' is updated to the start of the
+	// block, or to the position right after the data bits of the byte
+	// that was read (so the two stop bits are left as slack).
+
+	/** Find the next block whose data starts at or after the given
+	  * position. Returns false if there is none. */
+	bool seekBlock(EmuTime& time) const;
+	/** Read the data byte whose start or data bits contain the given
+	  * position (during the stop bits: the next byte). Returns false if
+	  * the position is not inside the data of a block. */
+	bool readByte(EmuTime& time, byte& value) const;
+
 private:
 	void write0();
 	void write1();
 	void writeHeader(int s);
 	void writeSilence(int s);
 	void writeByte(byte b);
-	bool writeData(span<byte> buf, size_t& pos);
-	void convert(const Filename& filename, FilePool& filePool, CliComm& cliComm);
+	bool writeData(span<const byte> buf, size_t& pos);
+	bool convert(span<const byte> buf, bool& issueWarning);
 
 	std::vector<signed char> output;
+
+	struct Block {
+		size_t start;  // position of the first data byte in 'output'
+		size_t offset; // position of the first data byte in 'data'
+		size_t size;
+	};
+	std::vector<Block> blocks;
+	std::vector<byte> data; // the data bytes of all blocks
 };
 
 } // namespace openmsx
@@ -31,9 +31,13 @@
 #include "FilePool.hh"
 #include "File.hh"
 #include "WavImage.hh"
+#include "WavStreamImage.hh"
 #include "CasImage.hh"
 #include "CliComm.hh"
 #include "MSXMotherBoard.hh"
+#include "MSXCPU.hh"
+#include "MSXCPUInterface.hh"
+#include "CPURegs.hh"
 #include "Reactor.hh"
 #include "GlobalSettings.hh"
 #include "CommandException.hh"
@@ -43,6 +47,7 @@
 #include "TclObject.hh"
 #include "DynamicClock.hh"
 #include "EmuDuration.hh"
+#include "StringOp.hh"
 #include "serialize.hh"
 #include "unreachable.hh"
 #include <algorithm>
@@ -57,6 +62,11 @@ namespace openmsx {
 static const unsigned RECORD_FREQ = 44100;
 static const double OUTPUT_AMP = 60.0;
 
+// BIOS jump table entries of the tape routines
+static const word TAPION = 0x00E1;
+static const word TAPIN  = 0x00E4;
+static const word TAPIOF = 0x00E7;
+
 static XMLElement createXML()
 {
 	XMLElement xml("cassetteplayer");
@@ -81,11 +91,18 @@ CassettePlayer::CassettePlayer(const HardwareConfig& hwConf)
 	, autoRunSetting(
 		motherBoard.getCommandController(),
 		"autoruncassettes", "automatically try to run cassettes", true)
+	, fastLoadSetting(
+		motherBoard.getCommandController(),
+		"fastloadcassettes", "load CAS images instantly by intercepting "
+		"the BIOS tape routines", false)
 	, sampcnt(0)
 	, state(STOP)
 	, lastOutput(false)
 	, motor(false), motorControl(true)
 	, syncScheduled(false)
+	, tapionAddr(0), tapinAddr(0), tapiofAddr(0)
+	, trapsInstalled(false)
+	, fastLoading(false)
 {
 	setInputRate(44100); // Initialize with dummy value
 
@@ -97,10 +114,15 @@ CassettePlayer::CassettePlayer(const HardwareConfig& hwConf)
 	motherBoard.getReactor().getEventDistributor().registerEventListener(
 		OPENMSX_BOOT_EVENT, *this);
 	motherBoard.getMSXCliComm().update(CliComm::HARDWARE, getName(), "add");
+	fastLoadSetting.attach(*this);
 }
 
 CassettePlayer::~CassettePlayer()
 {
+	fastLoadSetting.detach(*this);
+	if (trapsInstalled) {
+		motherBoard.getCPUInterface().removeTraps(*this);
+	}
 	unregisterSound();
 	if (auto* c = getConnector()) {
 		c->unplug(getCurrentTime());
@@ -284,6 +306,7 @@ void CassettePlayer::setState(State newState, const Filename& newImage,
 		CliComm::STATUS, "cassetteplayer", getStateString());
 
 	updateLoadingState(time); // sets SP for tape-end detection
+	updateTraps(time);
 
 	checkInvariants();
 }
@@ -301,6 +324,115 @@ void CassettePlayer::updateLoadingState(EmuTime::param time)
 	}
 }
 
+void CassettePlayer::updateTraps(EmuTime::param time)
+{
+	// Only CAS images contain the data as bytes, WAV images must always
+	// be loaded via the emulated signal. SVI and ColecoVision machines
+	// have a different BIOS.
+	bool enable = (getState() == PLAY) &&
+	              fastLoadSetting.getBoolean() &&
+	              dynamic_cast<CasImage*>(playImage.get()) &&
+	              StringOp::startsWith(motherBoard.getMachineType(), "MSX");
+	if (enable == trapsInstalled) return;
+	trapsInstalled = enable;
+
+	auto& interface = motherBoard.getCPUInterface();
+	if (!enable) {
+		interface.removeTraps(*this);
+		fastLoading = false;
+		return;
+	}
+
+	// Like the cashandler script, trap the routines the jump table
+	// entries point to. Machines with a patched jump table (e.g. disk
+	// ROMs or other extensions hooking it) are left alone.
+	auto target = [&](word entry) -> word {
+		if (interface.peekSlottedMem(entry, time) != 0xC3) return 0; // JP
+		return interface.peekSlottedMem(entry + 1, time) |
+		      (interface.peekSlottedMem(entry + 2, time) << 8);
+	};
+	tapionAddr = target(TAPION);
+	tapinAddr  = target(TAPIN);
+	tapiofAddr = target(TAPIOF);
+	if (!tapionAddr || !tapinAddr || !tapiofAddr) return;
+	interface.setTrap(tapionAddr, 0, 0, *this);
+	interface.setTrap(tapinAddr,  0, 0, *this);
+	interface.setTrap(tapiofAddr, 0, 0, *this);
+}
+
+void CassettePlayer::trapped(word address, EmuTime::param time)
+{
+	auto* cas = dynamic_cast<CasImage*>(playImage.get());
+	if (!cas || (getState() != PLAY)) return;
+	sync(time);
+
+	auto& regs = motherBoard.getCPU().getRegisters();
+	if (address == tapionAddr) {
+		// Like the BIOS routine: switch the motor on (PPI port C bit 4
+		// reset) and disable interrupts until TAPIOF.
+		motherBoard.getCPUInterface().writeIO(0xAB, 0x08, time);
+		regs.setIFF1(false);
+		regs.setIFF2(false);
+		// Search the next block. A program with its own loader will
+		// not come back to TAPIN, but because the tape position is
+		// now at the start of that block, the emulated signal still
+		// works for it.
+		EmuTime pos = tapePos;
+		if (cas->seekBlock(pos)) {
+			tapePos = pos;
+			fastLoading = true;
+			regs.setF(0x40); // carry reset: success
+		} else {
+			fastLoading = false;
+			regs.setF(0x01); // carry set: error
+		}
+	} else if (address == tapinAddr) {
+		// TAPIN without a preceding (trapped) TAPION: run the real
+		// routine on the emulated signal
+		if (!fastLoading) return;
+		EmuTime pos = tapePos;
+		byte value;
+		if (cas->readByte(pos, value)) {
+			tapePos = pos;
+			regs.setA(value);
+			regs.setF(0x40);
+		} else {
+			regs.setF(0x01);
+		}
+	} else if (address == tapiofAddr) {
+		// Let the real routine switch the motor off and enable
+		// interrupts again.
+		fastLoading = false;
+		return;
+	} else {
+		return;
+	}
+	returnFromTrap(time);
+	updateLoadingState(time); // tapePos has changed
+}
+
+void CassettePlayer::returnFromTrap(EmuTime::param time)
+{
+	// emulate a RET instruction
+	auto& interface = motherBoard.getCPUInterface();
+	auto& regs = motherBoard.getCPU().getRegisters();
+	word sp = regs.getSP();
+	regs.setPC(interface.peekMem(sp, time) |
+	          (interface.peekMem(word(sp + 1), time) << 8));
+	regs.setSP(word(sp + 2));
+}
+
+void CassettePlayer::update(const Setting& setting)
+{
+	if (&setting == &fastLoadSetting) {
+		auto time = getCurrentTime();
+		sync(time);
+		updateTraps(time);
+	} else {
+		ResampledSoundDevice::update(setting);
+	}
+}
+
 void CassettePlayer::setImageName(const Filename& newImage)
 {
 	casImage = newImage;
@@ -308,13 +440,30 @@ void CassettePlayer::setImageName(const Filename& newImage)
 		CliComm::MEDIA, "cassetteplayer", casImage.getResolved());
 }
 
+static std::unique_ptr<CassetteImage> createWavImage(
+	const Filename& filename, FilePool& filePool)
+{
+	// Long recordings are read from disk on demand, instead of completely
+	// loading (and converting) them in memory.
+	try {
+		File file(filename);
+		if (file.getSize() >= WavStreamImage::MIN_FILE_SIZE) {
+			return std::make_unique<WavStreamImage>(
+				std::move(file), filePool);
+		}
+	} catch (MSXException&) {
+		// e.g. an encoding that only SDL can decode, try WavImage
+	}
+	return std::make_unique<WavImage>(filename, filePool);
+}
+
 void CassettePlayer::insertTape(const Filename& filename)
 {
 	if (!filename.empty()) {
 		FilePool& filePool = motherBoard.getReactor().getFilePool();
 		try {
 			// first try WAV
-			playImage = std::make_unique<WavImage>(filename, filePool);
+			playImage = createWavImage(filename, filePool);
 		} catch (MSXException& e) {
 			try {
 				// if that fails use CAS
@@ -833,6 +982,7 @@ SERIALIZE_ENUM(CassettePlayer::State, stateInfo);
 
 // version 1: initial version
 // version 2: added checksum
+// version 3: added fastLoading
 template<typename Archive>
 void CassettePlayer::serialize(Archive& ar, unsigned version)
 {
@@ -913,6 +1063,12 @@ void CassettePlayer::serialize(Archive& ar, unsigned version)
 	ar.serialize("lastOutput", lastOutput);
 	ar.serialize("motor", motor);
 	ar.serialize("motorControl", motorControl);
+	if (ar.versionAtLeast(version, 3)) {
+		ar.serialize("fastLoading", fastLoading);
+	} else {
+		assert(ar.isLoader());
+		fastLoading = false;
+	}
 
 	if (ar.isLoader()) {
 		auto time = getCurrentTime();
@@ -940,6 +1096,7 @@ void CassettePlayer::serialize(Archive& ar, unsigned version)
 		}
 		sync(time);
 		updateLoadingState(time);
+		updateTraps(time);
 	}
 }
 INSTANTIATE_SERIALIZE_METHODS(CassettePlayer);
@@ -4,6 +4,7 @@
 #include "EventListener.hh"
 #include "CassetteDevice.hh"
 #include "ResampledSoundDevice.hh"
+#include "CPUTrapHandler.hh"
 #include "RecordedCommand.hh"
 #include "Schedulable.hh"
 #include "ThrottleManager.hh"
@@ -23,7 +24,7 @@ class MSXMotherBoard;
 class Wav8Writer;
 
 class CassettePlayer final : public CassetteDevice, public ResampledSoundDevice
-                           , private EventListener
+                           , private EventListener, private CPUTrapHandler
 {
 public:
 	explicit CassettePlayer(const HardwareConfig& hwConf);
@@ -110,9 +111,21 @@ private:
 	void flushOutput();
 	void autoRun();
 
+	/** (Un)install the traps on the BIOS tape routines, depending on the
+	  * fastload setting, the current state and the type of the image.
+	  */
+	void updateTraps(EmuTime::param time);
+	void returnFromTrap(EmuTime::param time);
+
 	// EventListener
 	int signalEvent(const std::shared_ptr<const Event>& event) override;
 
+	// CPUTrapHandler
+	void trapped(word address, EmuTime::param time) override;
+
+	// Observer<Setting>
+	void update(const Setting& setting) override;
+
 	// Schedulable
 	struct SyncEndOfTape final : Schedulable {
 		friend class CassettePlayer;
@@ -169,6 +182,7 @@ private:
 
 	LoadingIndicator loadingIndicator;
 	BooleanSetting autoRunSetting;
+	BooleanSetting fastLoadSetting;
 	std::unique_ptr<Wav8Writer> recordImage;
 	std::unique_ptr<CassetteImage> playImage;
 
@@ -177,8 +191,13 @@ private:
 	bool lastOutput;
 	bool motor, motorControl;
 	bool syncScheduled;
+
+	// fast loading: addresses of the trapped BIOS routines
+	word tapionAddr, tapinAddr, tapiofAddr;
+	bool trapsInstalled;
+	bool fastLoading; // TAPION was handled natively, until TAPIOF
 };
-SERIALIZE_CLASS_VERSION(CassettePlayer, 2);
+SERIALIZE_CLASS_VERSION(CassettePlayer, 3);
 
 } // namespace openmsx
 
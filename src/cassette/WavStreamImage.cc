@@ -0,0 +1,216 @@
+#include "WavStreamImage.hh"
+#include "FilePool.hh"
+#include "FileException.hh"
+#include "MSXException.hh"
+#include "Math.hh"
+#include "endian.hh"
+#include "ranges.hh"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace openmsx {
+
+// The DC-removal filter of WavImage needs the preceding samples. When a
+// chunk is read, the filter first runs over this many samples before the
+// start of the chunk. That's plenty for the filter state to converge, and
+// it makes the result independent of the order in which chunks are read.
+static const unsigned WARMUP = 1024;
+
+static const uint16_t FORMAT_PCM        = 0x0001;
+static const uint16_t FORMAT_FLOAT      = 0x0003;
+static const uint16_t FORMAT_EXTENSIBLE = 0xFFFE;
+
+WavStreamImage::WavStreamImage(File file_, FilePool& filePool)
+	: file(std::move(file_))
+	, clock(EmuTime::zero)
+{
+	setSha1Sum(filePool.getSha1Sum(file));
+	parseHeader();
+	for (auto& c : chunks) c.samples.resize(CHUNK_SIZE);
+}
+
+void WavStreamImage::parseHeader()
+{
+	size_t fileSize = file.getSize();
+	uint8_t header[12];
+	if (fileSize < sizeof(header)) {
+		throw MSXException("Not a WAV file");
+	}
+	file.seek(0);
+	file.read(header, sizeof(header));
+	if ((memcmp(header + 0, "RIFF", 4) != 0) ||
+	    (memcmp(header + 8, "WAVE", 4) != 0)) {
+		throw MSXException("Not a WAV file");
+	}
+
+	bool fmtFound = false;
+	size_t pos = sizeof(header);
+	while (true) {
+		if (pos + 8 > fileSize) {
+			throw MSXException("No data in WAV file");
+		}
+		uint8_t chunk[8];
+		file.seek(pos);
+		file.read(chunk, sizeof(chunk));
+		size_t size = Endian::read_UA_L32(chunk + 4);
+		pos += 8;
+
+		if (memcmp(chunk, "fmt ", 4) == 0) {
+			uint8_t fmt[40] = {};
+			file.read(fmt, std::min(size, sizeof(fmt)));
+			uint16_t format = Endian::read_UA_L16(fmt + 0);
+			channels        = Endian::read_UA_L16(fmt + 2);
+			unsigned freq   = Endian::read_UA_L32(fmt + 4);
+			unsigned bits   = Endian::read_UA_L16(fmt + 14);
+			if ((format == FORMAT_EXTENSIBLE) && (size >= 26)) {
+				// first two bytes of the SubFormat GUID
+				format = Endian::read_UA_L16(fmt + 24);
+			}
+			isFloat = format == FORMAT_FLOAT;
+			if (!(((format == FORMAT_PCM) &&
+			       ((bits == 8) || (bits == 16) || (bits == 24) || (bits == 32))) ||
+			      (isFloat && (bits == 32)))) {
+				throw MSXException("Unsupported WAV encoding");
+			}
+			if ((channels == 0) || (freq == 0)) {
+				throw MSXException("Invalid WAV header");
+			}
+			bytesPerSample = bits / 8;
+			clock.setFreq(freq);
+			fmtFound = true;
+		} else if (memcmp(chunk, "data", 4) == 0) {
+			if (!fmtFound) {
+				throw MSXException("Invalid WAV header");
+			}
+			// Recordings that weren't properly closed can have a
+			// wrong size here, so also limit to the file size.
+			size = std::min(size, fileSize - pos);
+			dataOffset = pos;
+			length = unsigned(size / (channels * bytesPerSample));
+			return;
+		}
+		pos += size + (size & 1); // chunks are word aligned
+	}
+}
+
+int16_t WavStreamImage::decode(const uint8_t* frame) const
+{
+	// convert to 16 bit and mix all channels to mono (like WavData does)
+	int sum = 0;
+	for (unsigned ch = 0; ch < channels; ++ch) {
+		const uint8_t* p = frame + ch * bytesPerSample;
+		int s;
+		if (isFloat) {
+			uint32_t i = Endian::read_UA_L32(p);
+			float f;
+			memcpy(&f, &i, sizeof(f));
+			s = int(std::max(-1.0f, std::min(1.0f, f)) * 32767.0f);
+		} else {
+			switch (bytesPerSample) {
+			case 1:  s = (p[0] - 128) << 8; break;
+			case 2:  s = int16_t(Endian::read_UA_L16(p)); break;
+			case 3:  s = int16_t(Endian::read_UA_L16(p + 1)); break;
+			default: s = int16_t(Endian::read_UA_L16(p + 2)); break;
+			}
+		}
+		sum += s;
+	}
+	return int16_t(sum / int(channels));
+}
+
+void WavStreamImage::readChunk(unsigned index, int16_t* out) const
+{
+	unsigned start = index * CHUNK_SIZE;
+	assert(start < length);
+	unsigned num = std::min(CHUNK_SIZE, length - start);
+	unsigned warm = std::min(start, WARMUP);
+	unsigned total = warm + num;
+	size_t frameSize = channels * bytesPerSample;
+
+	rawBuf.resize(total * frameSize);
+	try {
+		file.seek(dataOffset + (start - warm) * frameSize);
+		file.read(rawBuf.data(), total * frameSize);
+	} catch (FileException&) {
+		// e.g. the file was removed, play silence rather than abort
+		std::fill_n(out, num, 0);
+		return;
+	}
+
+	// same filter as in WavImage
+	const float cuttOffFreq = 800.0f; // trial-and-error
+	float R = 1.0f - ((float(2 * M_PI) * cuttOffFreq) / getFrequency());
+	float t0 = 0.0f;
+	for (unsigned i = 0; i < total; ++i) {
+		float t1 = R * t0 + decode(&rawBuf[i * frameSize]);
+		if (i >= warm) {
+			out[i - warm] = Math::clipIntToShort(t1 - t0);
+		}
+		t0 = t1;
+	}
+}
+
+const int16_t* WavStreamImage::getChunk(unsigned index) const
+{
+	++useCounter;
+	auto it = ranges::find_if(chunks, [&](auto& c) { return c.index == index; });
+	if (it == std::end(chunks)) {
+		// replace the least recently used chunk
+		it = std::min_element(std::begin(chunks), std::end(chunks),
+			[](auto& a, auto& b) { return a.lastUse < b.lastUse; });
+		readChunk(index, it->samples.data());
+		it->index = index;
+	}
+	it->lastUse = useCounter;
+	return it->samples.data();
+}
+
+int16_t WavStreamImage::getSample(unsigned pos) const
+{
+	if (pos < length) {
+		return getChunk(pos / CHUNK_SIZE)[pos % CHUNK_SIZE];
+	}
+	return 0;
+}
+
+int16_t WavStreamImage::getSampleAt(EmuTime::param time)
+{
+	return getSample(clock.getTicksTill(time));
+}
+
+EmuTime WavStreamImage::getEndTime() const
+{
+	DynamicClock clk(clock);
+	clk += length;
+	return clk.getTime();
+}
+
+unsigned WavStreamImage::getFrequency() const
+{
+	return clock.getFreq();
+}
+
+void WavStreamImage::fillBuffer(unsigned pos, int** bufs, unsigned num) const
+{
+	if (pos >= length) {
+		bufs[0] = nullptr;
+		return;
+	}
+	int* out = bufs[0];
+	while (num) {
+		if (pos >= length) {
+			std::fill_n(out, num, 0);
+			return;
+		}
+		unsigned offset = pos % CHUNK_SIZE;
+		unsigned n = std::min({num, CHUNK_SIZE - offset, length - pos});
+		const int16_t* samples = getChunk(pos / CHUNK_SIZE) + offset;
+		std::copy_n(samples, n, out);
+		out += n;
+		pos += n;
+		num -= n;
+	}
+}
+
+} // namespace openmsx
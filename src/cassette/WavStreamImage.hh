@@ -0,0 +1,63 @@
+#ifndef WAVSTREAMIMAGE_HH
+#define WAVSTREAMIMAGE_HH
+
+#include "CassetteImage.hh"
+#include "DynamicClock.hh"
+#include "File.hh"
+#include "MemBuffer.hh"
+#include <cstdint>
+
+namespace openmsx {
+
+class FilePool;
+
+/** Cassette image for (long) WAV recordings. Unlike WavImage, this doesn't
+  * load the whole file in memory: the samples are read from disk on demand,
+  * in chunks of a fixed size, and only a few of those chunks are kept. Only
+  * uncompressed PCM (8/16/24/32 bit integer or 32 bit float) is supported,
+  * other encodings must go via WavImage.
+  */
+class WavStreamImage final : public CassetteImage
+{
+public:
+	/** WAV files smaller than this are loaded in memory (WavImage). */
+	static const size_t MIN_FILE_SIZE = 32 * 1024 * 1024;
+
+	WavStreamImage(File file, FilePool& filePool);
+
+	int16_t getSampleAt(EmuTime::param time) override;
+	EmuTime getEndTime() const override;
+	unsigned getFrequency() const override;
+	void fillBuffer(unsigned pos, int** bufs, unsigned num) const override;
+
+private:
+	static const unsigned CHUNK_SIZE = 32768; // in samples
+	static const unsigned NUM_CHUNKS = 4;
+
+	void parseHeader();
+	int16_t getSample(unsigned pos) const;
+	const int16_t* getChunk(unsigned index) const;
+	void readChunk(unsigned index, int16_t* out) const;
+	int16_t decode(const uint8_t* frame) const;
+
+	mutable File file;
+	DynamicClock clock;
+	size_t dataOffset;
+	unsigned length; // in samples
+	unsigned channels;
+	unsigned bytesPerSample;
+	bool isFloat;
+
+	struct Chunk {
+		MemBuffer<int16_t> samples;
+		unsigned index = unsigned(-1);
+		unsigned lastUse = 0;
+	};
+	mutable Chunk chunks[NUM_CHUNKS];
+	mutable MemBuffer<uint8_t> rawBuf;
+	mutable unsigned useCounter = 0;
+};
+
+} // namespace openmsx
+
+#endif
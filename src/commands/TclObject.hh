@@ -145,6 +145,9 @@ public:
 	bool getBoolean (Interpreter& interp) const;
 	double getDouble(Interpreter& interp) const;
 	span<const uint8_t> getBinary() const;
+	/** Is this a Tcl binary string (byte array) that has no string
+	  * representation (yet)? E.g. the result of 'debug read_block'. */
+	bool isByteArray() const;
 	unsigned getListLength(Interpreter& interp) const;
 	TclObject getListIndex(Interpreter& interp, unsigned index) const;
 	TclObject getDictValue(Interpreter& interp, const TclObject& key) const;
@@ -33,6 +33,18 @@ unique_ptr<HardwareConfig> HardwareConfig::createMachineConfig(
 	return result;
 }
 
+unique_ptr<HardwareConfig> HardwareConfig::createEmptyMachineConfig(
+	MSXMotherBoard& motherBoard)
+{
+	auto result = std::make_unique<HardwareConfig>(motherBoard, "empty");
+	XMLElement config("msxconfig");
+	config.addChild("info").addChild("type", "MSX");
+	config.addChild("devices");
+	result->setConfig(std::move(config));
+	result->setFileContext(systemFileContext());
+	return result;
+}
+
 unique_ptr<HardwareConfig> HardwareConfig::createExtensionConfig(
 	MSXMotherBoard& motherBoard, string_view extensionName, string_view slotname)
 {
@@ -28,6 +28,12 @@ public:
 
 	static std::unique_ptr<HardwareConfig> createMachineConfig(
 		MSXMotherBoard& motherBoard, const std::string& machineName);
+	/** A machine without any devices (only the CPU, which is part of
+	  * every machine). For tools that need the infrastructure of a
+	  * motherboard (scheduler, debugger, mixer, ...) but not an MSX.
+	  */
+	static std::unique_ptr<HardwareConfig> createEmptyMachineConfig(
+		MSXMotherBoard& motherBoard);
 	static std::unique_ptr<HardwareConfig> createExtensionConfig(
 		MSXMotherBoard& motherBoard, string_view extensionName, string_view slotname);
 	static std::unique_ptr<HardwareConfig> createRomConfig(
@@ -2591,9 +2591,10 @@ template<class T> void CPUCore<T>::execute2(bool fastForward)
 	// Note: we call scheduler _after_ executing the instruction and before
 	// deciding between executeFast() and executeSlow() (because a
 	// SyncPoint could set an IRQ and then we must choose executeSlow())
-	if (fastForward ||
-	    (!interface->anyBreakPoints() && !tracingEnabled)) {
-		// fast path, no breakpoints, no tracing
+	if (!interface->anyTraps() &&
+	    (fastForward ||
+	     (!interface->anyBreakPoints() && !tracingEnabled))) {
+		// fast path, no breakpoints, no tracing, no traps
 		while (!needExitCPULoop()) {
 			if (slowInstructions) {
 				--slowInstructions;
@@ -2616,7 +2617,9 @@ template<class T> void CPUCore<T>::execute2(bool fastForward)
 		}
 	} else {
 		while (!needExitCPULoop()) {
-			if (interface->checkBreakPoints(getPC(), motherboard)) {
+			interface->checkTraps(getPC(), T::getTime());
+			if (!fastForward &&
+			    interface->checkBreakPoints(getPC(), motherboard)) {
 				assert(interface->isBreaked());
 				break;
 			}
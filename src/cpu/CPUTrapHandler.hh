@@ -0,0 +1,27 @@
+#ifndef CPUTRAPHANDLER_HH
+#define CPUTRAPHANDLER_HH
+
+#include "EmuTime.hh"
+#include "openmsx.hh"
+
+namespace openmsx {
+
+/** Native (C++) replacement for a ROM routine, see MSXCPUInterface::setTrap().
+  */
+class CPUTrapHandler
+{
+public:
+	/** Called right before the CPU executes the instruction at the
+	  * trapped address. The handler can emulate the routine (and return
+	  * from it) by changing the CPU registers, or do nothing to let the
+	  * original routine run.
+	  */
+	virtual void trapped(word address, EmuTime::param time) = 0;
+
+protected:
+	~CPUTrapHandler() = default;
+};
+
+} // namespace openmsx
+
+#endif
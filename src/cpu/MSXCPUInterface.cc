@@ -26,6 +26,7 @@
 #include "ranges.hh"
 #include "stl.hh"
 #include "unreachable.hh"
+#include <algorithm>
 #include <cstring>
 #include <iomanip>
 #include <iostream>
@@ -728,6 +729,35 @@ void MSXCPUInterface::writeSlottedMem(unsigned address, byte value,
 	}
 }
 
+void MSXCPUInterface::setTrap(word address, byte ps, byte ss,
+                              CPUTrapHandler& handler)
+{
+	traps.push_back({address, ps, ss, &handler});
+	// the CPU must leave its fast loop to see the new trap
+	msxcpu.exitCPULoopSync();
+}
+
+void MSXCPUInterface::removeTraps(CPUTrapHandler& handler)
+{
+	traps.erase(std::remove_if(begin(traps), end(traps),
+	                           [&](auto& t) { return t.handler == &handler; }),
+	            end(traps));
+}
+
+void MSXCPUInterface::checkTrapsSlow(word pc, EmuTime::param time)
+{
+	int page = pc >> 14;
+	for (auto& t : traps) {
+		if ((t.address == pc) &&
+		    (primarySlotState[page] == t.ps) &&
+		    (!isExpanded(t.ps) || (secondarySlotState[page] == t.ss))) {
+			// the handler may change 'traps', so stop iterating
+			t.handler->trapped(pc, time);
+			return;
+		}
+	}
+}
+
 void MSXCPUInterface::insertBreakPoint(const BreakPoint& bp)
 {
 	auto it = ranges::upper_bound(breakPoints, bp, CompareBreakpoints());
@@ -993,6 +1023,36 @@ void MSXCPUInterface::MemoryDebug::write(unsigned address, byte value,
 	return interface.writeMem(address, value, time);
 }
 
+void MSXCPUInterface::MemoryDebug::readBlock(unsigned start, span<byte> output)
+{
+	// Copy directly from the devices where they're cacheable for reading,
+	// use peekMem() for the rest.
+	auto& interface = OUTER(MSXCPUInterface, memoryDebug);
+	auto time = getMotherBoard().getCurrentTime();
+	unsigned address = start;
+	size_t done = 0;
+	while (done < output.size()) {
+		unsigned lineStart = address & CacheLine::HIGH;
+		unsigned num = std::min<unsigned>(
+			CacheLine::SIZE - (address - lineStart),
+			unsigned(output.size() - done));
+		// the last line can contain the sub-slot register
+		bool special = (lineStart == CacheLine::HIGH) &&
+		               interface.isExpanded(interface.primarySlotState[3]);
+		const byte* line = special ? nullptr :
+			interface.visibleDevices[address >> 14]->getReadCacheLine(lineStart);
+		if (line) {
+			memcpy(&output[done], line + (address - lineStart), num);
+		} else {
+			for (unsigned i = 0; i < num; ++i) {
+				output[done + i] = interface.peekMem(address + i, time);
+			}
+		}
+		address += num;
+		done += num;
+	}
+}
+
 
 // class SlottedMemoryDebug
 
@@ -4,6 +4,7 @@
 #include "SimpleDebuggable.hh"
 #include "InfoTopic.hh"
 #include "CacheLine.hh"
+#include "CPUTrapHandler.hh"
 #include "MSXDevice.hh"
 #include "BreakPoint.hh"
 #include "WatchPoint.hh"
@@ -213,6 +214,24 @@ public:
 
 	DummyDevice& getDummyDevice() { return *dummyDevice; }
 
+	/** Install a native handler for the routine at the given address. It
+	  * only triggers while the given slot is selected in the page that
+	  * contains the address (the subslot is ignored for non-expanded
+	  * slots). Unlike breakpoints, traps are part of the emulation, so
+	  * they also trigger during fast-forward. While any trap is installed
+	  * the CPU can't use its fast execution loop.
+	  */
+	void setTrap(word address, byte ps, byte ss, CPUTrapHandler& handler);
+	void removeTraps(CPUTrapHandler& handler);
+
+	// trap methods used by CPUCore
+	bool anyTraps() const { return !traps.empty(); }
+	void checkTraps(word pc, EmuTime::param time)
+	{
+		if (likely(traps.empty())) return;
+		checkTrapsSlow(pc, time);
+	}
+
 	static void insertBreakPoint(const BreakPoint& bp);
 	static void removeBreakPoint(const BreakPoint& bp);
 	using BreakPoints = std::vector<BreakPoint>;
@@ -285,6 +304,8 @@ private:
 	                    int ps, int ss, int base, int size);
 
 
+	void checkTrapsSlow(word pc, EmuTime::param time);
+
 	static void checkBreakPoints(std::pair<BreakPoints::const_iterator,
 	                                       BreakPoints::const_iterator> range,
 	                             MSXMotherBoard& motherBoard);
@@ -302,6 +323,7 @@ private:
 		explicit MemoryDebug(MSXMotherBoard& motherBoard);
 		byte read(unsigned address, EmuTime::param time) override;
 		void write(unsigned address, byte value, EmuTime::param time) override;
+		void readBlock(unsigned start, span<byte> output) override;
 	} memoryDebug;
 
 	struct SlottedMemoryDebug final : SimpleDebuggable {
@@ -403,6 +425,13 @@ private:
 
 	bool fastForward; // no need to serialize
 
+	struct Trap {
+		word address;
+		byte ps, ss;
+		CPUTrapHandler* handler;
+	};
+	std::vector<Trap> traps; // owners re-install them after loadstate
+
 	//  All CPUs (Z80 and R800) of all MSX machines share this state.
 	static BreakPoints breakPoints; // sorted on address
 	WatchPoints watchPoints; // ordered in creation order,  TODO must also be static
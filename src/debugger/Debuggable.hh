@@ -2,6 +2,7 @@
 #define DEBUGGABLE_HH
 
 #include "openmsx.hh"
+#include "span.hh"
 #include <string>
 
 namespace openmsx {
@@ -14,6 +15,22 @@ public:
 	virtual byte read(unsigned address) = 0;
 	virtual void write(unsigned address, byte value) = 0;
 
+	/** Read or write a block of consecutive bytes. The range must lie
+	  * within the debuggable. The default implementations call read() or
+	  * write() for each byte, debuggables that are backed by a memory
+	  * buffer can override them with a plain copy.
+	  */
+	virtual void readBlock(unsigned start, span<byte> output) {
+		for (size_t i = 0; i < output.size(); ++i) {
+			output[i] = read(unsigned(start + i));
+		}
+	}
+	virtual void writeBlock(unsigned start, span<const byte> input) {
+		for (size_t i = 0; i < input.size(); ++i) {
+			write(unsigned(start + i), input[i]);
+		}
+	}
+
 protected:
 	Debuggable() = default;
 	~Debuggable() = default;
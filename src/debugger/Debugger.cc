@@ -14,7 +14,6 @@
 #include "stl.hh"
 #include "unreachable.hh"
 #include "view.hh"
-#include "xrange.hh"
 #include <cassert>
 #include <memory>
 #include <stdexcept>
@@ -53,12 +52,19 @@ void Debugger::unregisterDebuggable(string_view name, Debuggable& debuggable)
 	assert(debuggables.contains(name));
 	assert(debuggables[name.str()] == &debuggable); (void)debuggable;
 	debuggables.erase(name);
+	lastDebuggable = nullptr;
 }
 
 Debuggable* Debugger::findDebuggable(string_view name)
 {
+	if (lastDebuggable && (name == lastDebuggableName)) {
+		return lastDebuggable;
+	}
 	auto v = lookup(debuggables, name);
-	return v ? *v : nullptr;
+	if (!v) return nullptr;
+	lastDebuggableName.assign(name.data(), name.size());
+	lastDebuggable = *v;
+	return lastDebuggable;
 }
 
 Debuggable& Debugger::getDebuggable(string_view name)
@@ -271,6 +277,8 @@ void Debugger::Cmd::execute(
 		listConditions(tokens, result);
 	} else if (subCmd == "probe") {
 		probe(tokens, result);
+	} else if (subCmd == "search") {
+		search(tokens, result);
 	} else {
 		throw SyntaxError();
 	}
@@ -330,9 +338,7 @@ void Debugger::Cmd::readBlock(span<const TclObject> tokens, TclObject& result)
 	}
 
 	MemBuffer<byte> buf(num);
-	for (unsigned i = 0; i < num; ++i) {
-		buf[i] = device.read(addr + i);
-	}
+	device.readBlock(addr, span<byte>{buf.data(), num});
 	result = span<byte>{buf.data(), num};
 }
 
@@ -371,9 +377,7 @@ void Debugger::Cmd::writeBlock(span<const TclObject> tokens, TclObject& /*result
 		throw CommandException("Invalid size");
 	}
 
-	for (auto i : xrange(buf.size())) {
-		device.write(unsigned(addr + i), buf[i]);
-	}
+	device.writeBlock(addr, buf);
 }
 
 void Debugger::Cmd::setBreakPoint(span<const TclObject> tokens, TclObject& result)
@@ -747,6 +751,116 @@ void Debugger::Cmd::probeListBreakPoints(
 	result = res;
 }
 
+static MemorySearch::Op parseSearchOp(string_view op)
+{
+	if ((op == "eq") || (op == "==")) return MemorySearch::EQUAL;
+	if ((op == "ne") || (op == "!=")) return MemorySearch::NOT_EQUAL;
+	if ((op == "lt") || (op == "<" )) return MemorySearch::LESS;
+	if ((op == "gt") || (op == ">" )) return MemorySearch::GREATER;
+	if ((op == "le") || (op == "<=")) return MemorySearch::LESS_EQUAL;
+	if ((op == "ge") || (op == ">=")) return MemorySearch::GREATER_EQUAL;
+	throw CommandException("Invalid comparison operator: ", op);
+}
+
+void Debugger::Cmd::search(span<const TclObject> tokens, TclObject& result)
+{
+	if (tokens.size() < 3) {
+		throw CommandException("Missing argument");
+	}
+	auto& memSearch = debugger().memSearch;
+	string_view subCmd = tokens[2].getString();
+	if (subCmd == "start") {
+		searchStart(tokens, result);
+		return;
+	} else if (subCmd == "stop") {
+		memSearch.clear();
+		debugger().searchDebuggable.clear();
+		return;
+	}
+	if (!memSearch.isActive()) {
+		throw CommandException("No search in progress");
+	}
+	if (subCmd == "results") {
+		searchResults(tokens, result);
+		return;
+	} else if (subCmd == "count") {
+		if (tokens.size() != 3) throw SyntaxError();
+	} else if (subCmd == "value") {
+		if (tokens.size() != 5) throw SyntaxError();
+		auto op = parseSearchOp(tokens[3].getString());
+		int value = tokens[4].getInt(getInterpreter());
+		if (value < 0) {
+			throw CommandException("Invalid value");
+		}
+		memSearch.filterValue(searchSnapshot(), op, value);
+	} else if (subCmd == "delta") {
+		if (tokens.size() != 4) throw SyntaxError();
+		int delta = tokens[3].getInt(getInterpreter());
+		memSearch.filterOld(searchSnapshot(), MemorySearch::EQUAL, delta);
+	} else if (subCmd == "changed") {
+		if (tokens.size() != 3) throw SyntaxError();
+		memSearch.filterOld(searchSnapshot(), MemorySearch::NOT_EQUAL, 0);
+	} else if (subCmd == "unchanged") {
+		if (tokens.size() != 3) throw SyntaxError();
+		memSearch.filterOld(searchSnapshot(), MemorySearch::EQUAL, 0);
+	} else if (subCmd == "increased") {
+		if (tokens.size() != 3) throw SyntaxError();
+		memSearch.filterOld(searchSnapshot(), MemorySearch::GREATER, 0);
+	} else if (subCmd == "decreased") {
+		if (tokens.size() != 3) throw SyntaxError();
+		memSearch.filterOld(searchSnapshot(), MemorySearch::LESS, 0);
+	} else {
+		throw SyntaxError();
+	}
+	result = int(memSearch.count());
+}
+void Debugger::Cmd::searchStart(span<const TclObject> tokens, TclObject& result)
+{
+	bool wordSize = false;
+	if (tokens.size() == 5) {
+		if (tokens[4] != "-16") throw SyntaxError();
+		wordSize = true;
+	} else if (tokens.size() != 4) {
+		throw SyntaxError();
+	}
+	auto& d = debugger();
+	d.getDebuggable(tokens[3].getString()); // check existence
+	d.memSearch.clear();
+	d.searchDebuggable = tokens[3].getString().str();
+	d.memSearch.start(searchSnapshot(), wordSize);
+	result = int(d.memSearch.count());
+}
+void Debugger::Cmd::searchResults(span<const TclObject> tokens, TclObject& result)
+{
+	unsigned max = unsigned(-1);
+	if (tokens.size() == 4) {
+		max = tokens[3].getInt(getInterpreter());
+	} else if (tokens.size() != 3) {
+		throw SyntaxError();
+	}
+	debugger().memSearch.forEachCandidate(max,
+		[&](unsigned addr, unsigned oldVal, unsigned newVal) {
+			result.addListElement(makeTclList(addr, oldVal, newVal));
+		});
+}
+vector<byte> Debugger::Cmd::searchSnapshot()
+{
+	auto& d = debugger();
+	auto* device = d.findDebuggable(d.searchDebuggable);
+	if (!device) {
+		throw CommandException("Debuggable ", d.searchDebuggable,
+		                       " no longer exists");
+	}
+	unsigned size = device->getSize();
+	if (d.memSearch.isActive() && (size != d.memSearch.size())) {
+		throw CommandException("Size of debuggable ", d.searchDebuggable,
+		                       " has changed");
+	}
+	vector<byte> buf(size);
+	device->readBlock(0, span<byte>{buf.data(), size});
+	return buf;
+}
+
 string Debugger::Cmd::help(const vector<string>& tokens) const
 {
 	static const string generalHelp =
@@ -769,6 +883,7 @@ string Debugger::Cmd::help(const vector<string>& tokens) const
 		"    remove_condition  remove a certain condition\n"
 		"    list_conditions   list the active conditions\n"
 		"    probe             probe related subcommands\n"
+		"    search            search memory for changing values (cheats)\n"
 		"    cont              continue execution after break\n"
 		"    step              execute one instruction\n"
 		"    break             break CPU at current position\n"
@@ -907,6 +1022,25 @@ string Debugger::Cmd::help(const vector<string>& tokens) const
 		"    set_bp <probe> [<cond>] [<cmd>]  set a breakpoint on the given probe\n"
 		"    remove_bp <id>                   remove the given breakpoint\n"
 		"    list_bp                          returns a list of breakpoints that are set on probes\n";
+	static const string searchHelp =
+		"debug search <subcommand> [<arguments>]\n"
+		"  Search the addresses in a debuggable that hold a certain "
+		"(changing) value, e.g. to find the number of lives in a game.\n"
+		"  Possible subcommands are:\n"
+		"    start <name> [-16]   start a new search, all addresses are candidates\n"
+		"    value <op> <value>   keep candidates for which 'new <op> value' holds\n"
+		"    changed              keep candidates that changed since the previous step\n"
+		"    unchanged            keep candidates that didn't change\n"
+		"    increased            keep candidates that increased\n"
+		"    decreased            keep candidates that decreased\n"
+		"    delta <d>            keep candidates that changed by exactly <d> (wraps)\n"
+		"    count                returns the number of candidates\n"
+		"    results [<max>]      returns a list of {addr old new} triplets\n"
+		"    stop                 end the search and release its memory\n"
+		"  <op> is one of eq ne lt gt le ge (or == != < > <= >=). With "
+		"'-16' values are 16-bit little endian words instead of bytes. "
+		"All values are unsigned. Each filter step takes a new snapshot "
+		"of the debuggable and returns the number of remaining candidates.\n";
 	static const string contHelp =
 		"debug cont\n"
 		"  Continue execution after CPU was breaked.\n";
@@ -972,6 +1106,8 @@ string Debugger::Cmd::help(const vector<string>& tokens) const
 		return listCondHelp;
 	} else if (tokens[1] == "probe") {
 		return probeHelp;
+	} else if (tokens[1] == "search") {
+		return searchHelp;
 	} else if (tokens[1] == "cont") {
 		return contHelp;
 	} else if (tokens[1] == "step") {
@@ -1019,7 +1155,7 @@ void Debugger::Cmd::tabCompletion(vector<string>& tokens) const
 	static const char* const otherCmds[] = {
 		"disasm", "set_bp", "remove_bp", "set_watchpoint",
 		"remove_watchpoint", "set_condition", "remove_condition",
-		"probe",
+		"probe", "search",
 	};
 	switch (tokens.size()) {
 	case 2: {
@@ -1053,6 +1189,13 @@ void Debugger::Cmd::tabCompletion(vector<string>& tokens) const
 					"remove_bp", "list_bp",
 				};
 				completeString(tokens, subCmds);
+			} else if (tokens[1] == "search") {
+				static const char* const subCmds[] = {
+					"start", "value", "changed", "unchanged",
+					"increased", "decreased", "delta", "count",
+					"results", "stop",
+				};
+				completeString(tokens, subCmds);
 			}
 		}
 		break;
@@ -1064,6 +1207,8 @@ void Debugger::Cmd::tabCompletion(vector<string>& tokens) const
 				debugger().probes,
 				[](auto* p) { return p->getName(); }));
 			completeString(tokens, probeNames);
+		} else if ((tokens[1] == "search") && (tokens[2] == "start")) {
+			completeString(tokens, view::keys(debugger().debuggables));
 		}
 		break;
 	}
@@ -1,6 +1,7 @@
 #ifndef DEBUGGER_HH
 #define DEBUGGER_HH
 
+#include "MemorySearch.hh"
 #include "Probe.hh"
 #include "RecordedCommand.hh"
 #include "WatchPoint.hh"
@@ -99,6 +100,10 @@ private:
 		void probeSetBreakPoint(span<const TclObject> tokens, TclObject& result);
 		void probeRemoveBreakPoint(span<const TclObject> tokens, TclObject& result);
 		void probeListBreakPoints(span<const TclObject> tokens, TclObject& result);
+		void search(span<const TclObject> tokens, TclObject& result);
+		void searchStart(span<const TclObject> tokens, TclObject& result);
+		void searchResults(span<const TclObject> tokens, TclObject& result);
+		std::vector<byte> searchSnapshot();
 	} cmd;
 
 	struct NameFromProbe {
@@ -108,10 +113,18 @@ private:
 	};
 
 	hash_map<std::string, Debuggable*, XXHasher> debuggables;
+	// Scripts tend to access the same debuggable over and over (e.g.
+	// 'peek' and 'poke' on "memory"), remember the last lookup.
+	std::string lastDebuggableName;
+	Debuggable* lastDebuggable = nullptr;
 	hash_set<ProbeBase*, NameFromProbe, XXHasher>  probes;
 	using ProbeBreakPoints = std::vector<std::unique_ptr<ProbeBreakPoint>>;
 	ProbeBreakPoints probeBreakPoints; // unordered
 	MSXCPU* cpu;
+
+	// state of the 'debug search' subcommand
+	MemorySearch memSearch;
+	std::string searchDebuggable;
 };
 
 } // namespace openmsx
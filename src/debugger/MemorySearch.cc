@@ -0,0 +1,168 @@
+#include "MemorySearch.hh"
+#include <cassert>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace openmsx {
+
+static bool compare(int n, int b, MemorySearch::Op op)
+{
+	switch (op) {
+	case MemorySearch::EQUAL:         return n == b;
+	case MemorySearch::NOT_EQUAL:     return n != b;
+	case MemorySearch::LESS:          return n <  b;
+	case MemorySearch::GREATER:       return n >  b;
+	case MemorySearch::LESS_EQUAL:    return n <= b;
+	case MemorySearch::GREATER_EQUAL: return n >= b;
+	}
+	return false;
+}
+
+#ifdef __SSE2__
+// Returns a 16-bit mask with a bit set for each byte where 'n <op> b' holds
+// (unsigned comparison).
+static unsigned compare16(__m128i n, __m128i b, MemorySearch::Op op)
+{
+	__m128i r;
+	bool invert = false;
+	switch (op) {
+	case MemorySearch::EQUAL:
+		r = _mm_cmpeq_epi8(n, b); break;
+	case MemorySearch::NOT_EQUAL:
+		r = _mm_cmpeq_epi8(n, b); invert = true; break;
+	case MemorySearch::LESS_EQUAL:
+		r = _mm_cmpeq_epi8(_mm_min_epu8(n, b), n); break;
+	case MemorySearch::GREATER:
+		r = _mm_cmpeq_epi8(_mm_min_epu8(n, b), n); invert = true; break;
+	case MemorySearch::GREATER_EQUAL:
+		r = _mm_cmpeq_epi8(_mm_max_epu8(n, b), n); break;
+	case MemorySearch::LESS:
+		r = _mm_cmpeq_epi8(_mm_max_epu8(n, b), n); invert = true; break;
+	default:
+		r = _mm_setzero_si128();
+	}
+	unsigned mask = _mm_movemask_epi8(r);
+	return invert ? (~mask & 0xFFFF) : mask;
+}
+#endif
+
+void MemorySearch::start(std::vector<byte> snapshot, bool wordSize_)
+{
+	wordSize = wordSize_;
+	current = std::move(snapshot);
+	previous = current;
+	size_t num = current.size();
+	if (wordSize) num = num ? num - 1 : 0;
+	bitmap.assign((num + 63) / 64, ~uint64_t(0));
+	if (num % 64) bitmap.back() = (uint64_t(1) << (num % 64)) - 1;
+}
+
+void MemorySearch::clear()
+{
+	previous.clear();
+	current.clear();
+	bitmap.clear();
+}
+
+size_t MemorySearch::count() const
+{
+	size_t result = 0;
+	for (auto w : bitmap) result += Math::popcount64(w);
+	return result;
+}
+
+void MemorySearch::next(std::vector<byte>&& snapshot)
+{
+	assert(snapshot.size() == current.size());
+	previous = std::move(current);
+	current = std::move(snapshot);
+}
+
+template<typename Pred> void MemorySearch::filterScalar(Pred pred)
+{
+	for (size_t w = 0; w < bitmap.size(); ++w) {
+		uint64_t bits = bitmap[w];
+		uint64_t keep = 0;
+		while (bits) {
+			unsigned bit = Math::countTrailingZeros64(bits);
+			bits &= bits - 1;
+			if (pred(unsigned(64 * w + bit))) keep |= uint64_t(1) << bit;
+		}
+		bitmap[w] = keep;
+	}
+}
+
+// Compares 8-bit values: 'new <op> ref[addr] + value' when useRef is set,
+// otherwise 'new <op> value'. Additions wrap.
+void MemorySearch::filterSSE(const byte* ref, bool useRef, byte value, Op op)
+{
+	assert(!wordSize);
+	const byte* cur = current.data();
+	size_t fullWords = current.size() / 64;
+	size_t w = 0;
+#ifdef __SSE2__
+	__m128i vValue = _mm_set1_epi8(char(value));
+	for (/**/; w < fullWords; ++w) {
+		if (!bitmap[w]) continue; // nothing left to test
+		uint64_t mask = 0;
+		for (unsigned i = 0; i < 4; ++i) {
+			size_t offset = 64 * w + 16 * i;
+			__m128i n = _mm_loadu_si128(
+				reinterpret_cast<const __m128i*>(cur + offset));
+			__m128i b = vValue;
+			if (useRef) {
+				b = _mm_add_epi8(b, _mm_loadu_si128(
+					reinterpret_cast<const __m128i*>(ref + offset)));
+			}
+			mask |= uint64_t(compare16(n, b, op)) << (16 * i);
+		}
+		bitmap[w] &= mask;
+	}
+#else
+	(void)fullWords;
+#endif
+	// remaining part (or everything without SSE2)
+	for (/**/; w < bitmap.size(); ++w) {
+		uint64_t bits = bitmap[w];
+		uint64_t keep = 0;
+		while (bits) {
+			unsigned bit = Math::countTrailingZeros64(bits);
+			bits &= bits - 1;
+			size_t addr = 64 * w + bit;
+			byte b = useRef ? byte(ref[addr] + value) : value;
+			if (compare(cur[addr], b, op)) keep |= uint64_t(1) << bit;
+		}
+		bitmap[w] = keep;
+	}
+}
+
+void MemorySearch::filterValue(std::vector<byte> snapshot, Op op, unsigned value)
+{
+	next(std::move(snapshot));
+	if (!wordSize && (value < 256)) {
+		filterSSE(nullptr, false, byte(value), op);
+	} else {
+		filterScalar([&](unsigned addr) {
+			return compare(getValue(current, addr), value, op);
+		});
+	}
+}
+
+void MemorySearch::filterOld(std::vector<byte> snapshot, Op op, int delta)
+{
+	next(std::move(snapshot));
+	bool wrap = (op == EQUAL) || (op == NOT_EQUAL);
+	if (!wordSize && (wrap || (delta == 0))) {
+		filterSSE(previous.data(), true, byte(delta), op);
+	} else {
+		unsigned mask = wordSize ? 0xFFFF : 0xFF;
+		filterScalar([&](unsigned addr) {
+			int b = int(getValue(previous, addr)) + delta;
+			if (wrap) b &= mask;
+			return compare(getValue(current, addr), b, op);
+		});
+	}
+}
+
+} // namespace openmsx
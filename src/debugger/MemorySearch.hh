@@ -0,0 +1,79 @@
+#ifndef MEMORYSEARCH_HH
+#define MEMORYSEARCH_HH
+
+#include "Math.hh"
+#include "openmsx.hh"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace openmsx {
+
+/** Narrows down a set of addresses in a block of memory (a snapshot of a
+  * Debuggable) by repeatedly comparing a new snapshot with a value or with
+  * the previous snapshot, like a cheat finder does. Values are 8-bit or
+  * 16-bit (little endian) and compared unsigned.
+  *
+  * The remaining candidates are kept as a bitmap, so the first (dense)
+  * filter steps are done 16 addresses at a time (SSE2), later (sparse)
+  * steps skip over the addresses that were already eliminated.
+  */
+class MemorySearch
+{
+public:
+	enum Op { EQUAL, NOT_EQUAL, LESS, GREATER, LESS_EQUAL, GREATER_EQUAL };
+
+	/** Start a new search: all addresses are candidates. */
+	void start(std::vector<byte> snapshot, bool wordSize);
+
+	/** Keep the candidates for which 'new <op> value' holds. */
+	void filterValue(std::vector<byte> snapshot, Op op, unsigned value);
+
+	/** Keep the candidates for which 'new <op> old + delta' holds, where
+	  * 'old' is the value in the previous snapshot. For EQUAL and
+	  * NOT_EQUAL the addition wraps (e.g. 0 - 1 == 255 for 8-bit values).
+	  */
+	void filterOld(std::vector<byte> snapshot, Op op, int delta);
+
+	bool isActive() const { return !current.empty(); }
+	bool isWordSize() const { return wordSize; }
+	size_t size() const { return current.size(); }
+	size_t count() const;
+
+	/** Call f(address, oldValue, newValue) for the first 'max' candidates
+	  * (in increasing address order). Before the first filter step old
+	  * and new are equal.
+	  */
+	template<typename F> void forEachCandidate(size_t max, F f) const
+	{
+		for (size_t w = 0; w < bitmap.size(); ++w) {
+			uint64_t bits = bitmap[w];
+			while (bits) {
+				if (max-- == 0) return;
+				unsigned addr = unsigned(64 * w + Math::countTrailingZeros64(bits));
+				bits &= bits - 1;
+				f(addr, getValue(previous, addr), getValue(current, addr));
+			}
+		}
+	}
+
+	void clear();
+
+private:
+	unsigned getValue(const std::vector<byte>& data, unsigned addr) const {
+		return wordSize ? (data[addr] | (data[addr + 1] << 8))
+		                : data[addr];
+	}
+	template<typename Pred> void filterScalar(Pred pred);
+	void filterSSE(const byte* ref, bool useRef, byte value, Op op);
+	void next(std::vector<byte>&& snapshot);
+
+	std::vector<byte> previous;
+	std::vector<byte> current;
+	std::vector<uint64_t> bitmap; // 1 bit per address
+	bool wordSize = false;
+};
+
+} // namespace openmsx
+
+#endif
@@ -0,0 +1,68 @@
+#include "BinaryCliCommParser.hh"
+
+static uint32_t readU32(const char* p)
+{
+	auto* q = reinterpret_cast<const unsigned char*>(p);
+	return uint32_t(q[0] <<  0) | uint32_t(q[1] <<  8) |
+	       uint32_t(q[2] << 16) | (uint32_t(q[3]) << 24);
+}
+
+BinaryCliCommParser::BinaryCliCommParser(std::function<void(Batch&&)> callback_)
+	: callback(std::move(callback_))
+{
+}
+
+bool BinaryCliCommParser::parse(const char* buf, size_t n)
+{
+	buffer.append(buf, n);
+	size_t pos = 0;
+	while ((buffer.size() - pos) >= 4) {
+		uint32_t size = readU32(&buffer[pos]);
+		if (size > MAX_REQUEST_SIZE) return false;
+		if ((buffer.size() - pos - 4) < size) break; // incomplete
+
+		const char* p = &buffer[pos + 4];
+		const char* end = p + size;
+		if (size < 4) return false;
+		uint32_t count = readU32(p); p += 4;
+		Batch batch;
+		batch.reserve(count < size ? count : size);
+		for (uint32_t i = 0; i < count; ++i) {
+			if ((end - p) < 4) return false;
+			uint32_t len = readU32(p); p += 4;
+			if (uint32_t(end - p) < len) return false;
+			batch.emplace_back(p, len);
+			p += len;
+		}
+		if (p != end) return false;
+		pos += 4 + size;
+		callback(std::move(batch));
+	}
+	buffer.erase(0, pos);
+	return true;
+}
+
+void BinaryCliCommParser::appendU32(std::string& out, uint32_t value)
+{
+	char tmp[4] = {
+		char(value >>  0), char(value >>  8),
+		char(value >> 16), char(value >> 24),
+	};
+	out.append(tmp, 4);
+}
+
+void BinaryCliCommParser::appendString(std::string& out, const char* data, size_t size)
+{
+	appendU32(out, uint32_t(size));
+	out.append(data, size);
+}
+
+std::string BinaryCliCommParser::frame(FrameType type, const std::string& payload)
+{
+	std::string result;
+	result.reserve(5 + payload.size());
+	appendU32(result, uint32_t(1 + payload.size()));
+	result += char(type);
+	result += payload;
+	return result;
+}
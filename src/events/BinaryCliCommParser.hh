@@ -0,0 +1,57 @@
+#ifndef BINARYCLICOMMPARSER_HH
+#define BINARYCLICOMMPARSER_HH
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+/** Parser for the binary (length-prefixed) framing of the CLI protocol.
+  *
+  * A connection switches to this framing by sending MAGIC as its very first
+  * bytes (instead of '<openmsx-control>'). openMSX answers by sending MAGIC
+  * too: everything it sent before that (the '<openmsx-output>' tag and
+  * possibly some log messages) is still XML, everything after it is binary.
+  * The client sends requests, all integers are 32-bit little endian:
+  *   request: <size> <count> (<length> <command bytes>)*count
+  * where <size> is the number of bytes that follow it. All commands of one
+  * request are executed in one go and answered with a single reply, so many
+  * commands (e.g. 'debug read' or 'peek') only cost one round trip.
+  *
+  * openMSX sends frames: <size> <type byte> <payload>
+  *   REPLY:  <count> (<status byte> <length> <result bytes>)*count
+  *   LOG:    <level byte> <message bytes>
+  *   UPDATE: <type byte> (<length> <bytes>)*3  (machine, name, value)
+  * A result is sent as-is: UTF-8 for RESULT_OK and RESULT_ERROR, raw bytes
+  * for RESULT_BINARY (a Tcl binary string, like the result of
+  * 'debug read_block').
+  */
+class BinaryCliCommParser
+{
+public:
+	static constexpr const char* const MAGIC = "<openmsx-binary>";
+	static const uint32_t MAX_REQUEST_SIZE = 64 * 1024 * 1024;
+
+	enum FrameType : uint8_t { REPLY, LOG, UPDATE };
+	enum ResultStatus : uint8_t { RESULT_OK, RESULT_ERROR, RESULT_BINARY };
+
+	using Batch = std::vector<std::string>;
+
+	explicit BinaryCliCommParser(std::function<void(Batch&&)> callback);
+
+	/** Feed received data. Returns false when the data is malformed, the
+	  * connection should then be closed.
+	  */
+	bool parse(const char* buf, size_t n);
+
+	/** Helpers to build frames. */
+	static void appendU32(std::string& out, uint32_t value);
+	static void appendString(std::string& out, const char* data, size_t size);
+	static std::string frame(FrameType type, const std::string& payload);
+
+private:
+	std::function<void(Batch&&)> callback;
+	std::string buffer; // received data that isn't a complete request yet
+};
+
+#endif
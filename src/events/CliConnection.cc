@@ -17,6 +17,7 @@
 #include "openmsx.hh"
 #include "ranges.hh"
 #include "unistdp.hh"
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 
@@ -31,34 +32,48 @@ namespace openmsx {
 
 // class CliCommandEvent
 
+// A command from the XML protocol, or a batch of commands from the binary
+// protocol (executed in one go, the results are sent back in a single reply).
+// A 'SWITCH' event (without commands) makes the main thread start using the
+// binary protocol for this connection.
 class CliCommandEvent final : public Event
 {
 public:
-	CliCommandEvent(string command_, const CliConnection* id_)
+	enum Kind { XML, BATCH, SWITCH };
+
+	CliCommandEvent(std::vector<string> commands_, const CliConnection* id_,
+	                Kind kind_)
 		: Event(OPENMSX_CLICOMMAND_EVENT)
-		, command(std::move(command_)), id(id_)
+		, commands(std::move(commands_)), id(id_), kind(kind_)
 	{
 	}
-	const string& getCommand() const
+	const std::vector<string>& getCommands() const
 	{
-		return command;
+		return commands;
 	}
 	const CliConnection* getId() const
 	{
 		return id;
 	}
+	Kind getKind() const
+	{
+		return kind;
+	}
 	TclObject toTclList() const override
 	{
-		return makeTclList("CliCmd", getCommand());
+		TclObject result = makeTclList("CliCmd");
+		result.addListElements(getCommands());
+		return result;
 	}
 	bool lessImpl(const Event& other) const override
 	{
 		auto& otherCmdEvent = checked_cast<const CliCommandEvent&>(other);
-		return getCommand() < otherCmdEvent.getCommand();
+		return getCommands() < otherCmdEvent.getCommands();
 	}
 private:
-	const string command;
+	const std::vector<string> commands;
 	const CliConnection* id;
+	const Kind kind;
 };
 
 
@@ -66,7 +81,10 @@ private:
 
 CliConnection::CliConnection(CommandController& commandController_,
                              EventDistributor& eventDistributor_)
-	: parser([this](const std::string& cmd) { execute(cmd); })
+	: parser([this](const std::string& cmd) {
+		execute({cmd}, CliCommandEvent::XML); })
+	, binaryParser([this](BinaryCliCommParser::Batch&& batch) {
+		execute(std::move(batch), CliCommandEvent::BATCH); })
 	, commandController(commandController_)
 	, eventDistributor(eventDistributor_)
 {
@@ -82,6 +100,13 @@ CliConnection::~CliConnection()
 
 void CliConnection::log(CliComm::LogLevel level, string_view message)
 {
+	if (binary) {
+		string payload;
+		payload += char(level);
+		payload.append(message.data(), message.size());
+		output(BinaryCliCommParser::frame(BinaryCliCommParser::LOG, payload));
+		return;
+	}
 	auto levelStr = CliComm::getLevelStrings();
 	output(strCat("<log level=\"", levelStr[level], "\">",
 	              XMLElement::XMLEscape(message.str()), "</log>\n"));
@@ -92,6 +117,16 @@ void CliConnection::update(CliComm::UpdateType type, string_view machine,
 {
 	if (!getUpdateEnable(type)) return;
 
+	if (binary) {
+		string payload;
+		payload += char(type);
+		for (auto& s : {machine, name, value}) {
+			BinaryCliCommParser::appendString(payload, s.data(), s.size());
+		}
+		output(BinaryCliCommParser::frame(BinaryCliCommParser::UPDATE, payload));
+		return;
+	}
+
 	auto updateStr = CliComm::getUpdateStrings();
 	string tmp = strCat("<update type=\"", updateStr[type], '\"');
 	if (!machine.empty()) {
@@ -117,7 +152,7 @@ void CliConnection::start()
 
 void CliConnection::end()
 {
-	output("</openmsx-output>\n");
+	if (!binary) output("</openmsx-output>\n");
 	close();
 
 	poller.abort();
@@ -127,10 +162,42 @@ void CliConnection::end()
 	}
 }
 
-void CliConnection::execute(const string& command)
+bool CliConnection::received(const char* buf, size_t n)
+{
+	// runs in helper thread
+	if (detecting) {
+		string_view magic = BinaryCliCommParser::MAGIC;
+		detectBuf.append(buf, n);
+		auto len = std::min(detectBuf.size(), magic.size());
+		if (string_view(detectBuf).substr(0, len) == magic.substr(0, len)) {
+			if (detectBuf.size() < magic.size()) {
+				return true; // can't decide yet
+			}
+			detecting = false;
+			receivingBinary = true;
+			execute({}, CliCommandEvent::SWITCH);
+			bool ok = binaryParser.parse(
+				detectBuf.data() + magic.size(),
+				detectBuf.size() - magic.size());
+			detectBuf = string();
+			return ok;
+		}
+		detecting = false;
+		parser.parse(detectBuf.data(), detectBuf.size());
+		detectBuf = string();
+		return true;
+	}
+	if (receivingBinary) {
+		return binaryParser.parse(buf, n);
+	}
+	parser.parse(buf, n);
+	return true;
+}
+
+void CliConnection::execute(std::vector<string> commands, int kind)
 {
-	eventDistributor.distributeEvent(
-		std::make_shared<CliCommandEvent>(command, this));
+	eventDistributor.distributeEvent(std::make_shared<CliCommandEvent>(
+		std::move(commands), this, CliCommandEvent::Kind(kind)));
 }
 
 static string reply(const string& message, bool status)
@@ -142,16 +209,52 @@ static string reply(const string& message, bool status)
 int CliConnection::signalEvent(const std::shared_ptr<const Event>& event)
 {
 	auto& commandEvent = checked_cast<const CliCommandEvent&>(*event);
-	if (commandEvent.getId() == this) {
+	if (commandEvent.getId() != this) return 0;
+
+	if (commandEvent.getKind() == CliCommandEvent::SWITCH) {
+		// From now on all output is binary. The echoed magic string
+		// tells the client where that starts.
+		output(BinaryCliCommParser::MAGIC);
+		binary = true;
+		return 0;
+	}
+	if (commandEvent.getKind() == CliCommandEvent::XML) {
+		assert(commandEvent.getCommands().size() == 1);
 		try {
 			string result = commandController.executeCommand(
-				commandEvent.getCommand(), this).getString().str();
+				commandEvent.getCommands().front(), this).getString().str();
 			output(reply(result, true));
 		} catch (CommandException& e) {
 			string result = std::move(e).getMessage() + '\n';
 			output(reply(result, false));
 		}
+		return 0;
+	}
+
+	using Parser = BinaryCliCommParser;
+	auto& commands = commandEvent.getCommands();
+	string payload;
+	Parser::appendU32(payload, uint32_t(commands.size()));
+	for (auto& command : commands) {
+		try {
+			TclObject result = commandController.executeCommand(command, this);
+			if (result.isByteArray()) {
+				auto data = result.getBinary();
+				payload += char(Parser::RESULT_BINARY);
+				Parser::appendString(payload,
+					reinterpret_cast<const char*>(data.data()), data.size());
+			} else {
+				auto str = result.getString();
+				payload += char(Parser::RESULT_OK);
+				Parser::appendString(payload, str.data(), str.size());
+			}
+		} catch (CommandException& e) {
+			const auto& message = e.getMessage();
+			payload += char(Parser::RESULT_ERROR);
+			Parser::appendString(payload, message.data(), message.size());
+		}
 	}
+	output(Parser::frame(Parser::REPLY, payload));
 	return 0;
 }
 
@@ -183,7 +286,7 @@ void StdioConnection::run()
 		char buf[BUF_SIZE];
 		int n = read(STDIN_FILENO, buf, sizeof(buf));
 		if (n > 0) {
-			parser.parse(buf, n);
+			if (!received(buf, n)) break;
 		} else if (n < 0) {
 			break;
 		}
@@ -273,7 +376,7 @@ void PipeConnection::run()
 			if (!GetOverlappedResult(pipeHandle, &overlapped, &bytesRead, TRUE)) {
 				break; // Pipe broke
 			}
-			parser.parse(buf, bytesRead);
+			if (!received(buf, bytesRead)) break;
 		} else if (wait == WAIT_OBJECT_0) {
 			break; // Shutdown
 		} else {
@@ -352,7 +455,7 @@ void SocketConnection::run()
 		char buf[BUF_SIZE];
 		int n = sock_recv(sd, buf, BUF_SIZE);
 		if (n > 0) {
-			parser.parse(buf, n);
+			if (!received(buf, n)) break;
 		} else if (n < 0) {
 			break;
 		}
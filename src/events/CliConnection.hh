@@ -6,6 +6,7 @@
 #include "Socket.hh"
 #include "CliComm.hh"
 #include "AdhocCliCommParser.hh"
+#include "BinaryCliCommParser.hh"
 #include "Poller.hh"
 #include <mutex>
 #include <string>
@@ -58,13 +59,22 @@ protected:
 	  */
 	void startOutput();
 
+	/** Process data received from the client (called from the helper
+	  * thread). The first bytes select the framing: XML (the default) or
+	  * binary (see BinaryCliCommParser).
+	  * @result false when the data is malformed, the connection should
+	  *         then be closed.
+	  */
+	bool received(const char* buf, size_t n);
+
 	AdhocCliCommParser parser;
+	BinaryCliCommParser binaryParser;
 	Poller poller;
 
 private:
 	virtual void run() = 0;
 
-	void execute(const std::string& command);
+	void execute(std::vector<std::string> commands, int kind);
 
 	// CliListener
 	void log(CliComm::LogLevel level, string_view message) override;
@@ -79,6 +89,13 @@ private:
 
 	std::thread thread;
 
+	// helper thread
+	std::string detectBuf; // start of the stream, while framing is unknown
+	bool detecting = true;
+	bool receivingBinary = false;
+	// main thread
+	bool binary = false; // send binary frames
+
 	bool updateEnabled[CliComm::NUM_UPDATES];
 };
 
@@ -58,8 +58,15 @@ void EventDistributor::distributeEvent(const EventPtr& event)
 		//             EventDistributor::unregisterEventListener()
 		//   thread 2: EventDistributor::distributeEvent()
 		//             Reactor::enterMainLoop()
-		condition.notify_all();
 		lock.unlock();
+		{
+			// Set the flag while holding cvMutex: otherwise the
+			// notification is lost when the main thread is between
+			// deliverEvents() and the wait in sleep().
+			std::lock_guard<std::mutex> cvLock(cvMutex);
+			newEvents = true;
+		}
+		condition.notify_all();
 		reactor.enterMainLoop();
 	}
 }
@@ -116,7 +123,9 @@ bool EventDistributor::sleep(unsigned us)
 {
 	std::chrono::microseconds duration(us);
 	std::unique_lock<std::mutex> lock(cvMutex);
-	return condition.wait_for(lock, duration) == std::cv_status::timeout;
+	bool woken = condition.wait_for(lock, duration, [&] { return newEvents; });
+	newEvents = false;
+	return !woken;
 }
 
 } // namespace openmsx
@@ -60,7 +60,10 @@ public:
 	void deliverEvents();
 
 	/** Sleep for the specified amount of time, but return early when
-	  * (another thread) called the distributeEvent() method.
+	  * (another thread) called the distributeEvent() method. Events that
+	  * were distributed since the previous call to this method (e.g. while
+	  * the main thread was still busy delivering events) also make it
+	  * return immediately, so a wake-up is never lost.
 	  * @param us Amount of time to sleep, in micro seconds.
 	  * @result true  if we return because time has passed
 	  *         false if we return because distributeEvent() was called
@@ -79,6 +82,7 @@ private:
 	std::mutex mutex; // lock datastructures
 	std::mutex cvMutex; // lock condition_variable
 	std::condition_variable condition;
+	bool newEvents = false; // protected by cvMutex
 };
 
 } // namespace openmsx
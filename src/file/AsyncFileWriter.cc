@@ -0,0 +1,185 @@
+#include "AsyncFileWriter.hh"
+#include "FileException.hh"
+#include <algorithm>
+#include <cassert>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace openmsx {
+
+/** The background thread shared by all AsyncFileWriters. Blocks are written
+  * in the order they were queued, so per writer they stay in order.
+  */
+class AsyncFileWriter::Worker
+{
+public:
+	static constexpr size_t MAX_QUEUED = 16;
+
+	static Worker& instance()
+	{
+		static Worker oneInstance;
+		return oneInstance;
+	}
+
+	/** The thread is started for the first writer and stopped (joined)
+	  * when the last writer is gone, so it never outlives the writers. */
+	void addWriter();
+	void removeWriter();
+
+	std::mutex mutex;
+	std::condition_variable cond;     // signals the background thread
+	std::condition_variable idleCond; // signals the producers
+	std::deque<std::pair<AsyncFileWriter*, std::vector<char>>> queue;
+	std::vector<std::vector<char>> freeBlocks;
+
+private:
+	void run();
+
+	std::thread thread;
+	unsigned writers = 0;
+	bool stop = false;
+};
+
+void AsyncFileWriter::Worker::addWriter()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (writers++ == 0) {
+		assert(!thread.joinable());
+		stop = false;
+		thread = std::thread([this]() { run(); });
+	}
+}
+
+void AsyncFileWriter::Worker::removeWriter()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		assert(writers > 0);
+		if (--writers) return;
+		stop = true;
+	}
+	cond.notify_one();
+	thread.join();
+	freeBlocks.clear();
+}
+
+void AsyncFileWriter::Worker::run()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true) {
+		cond.wait(lock, [&] { return !queue.empty() || stop; });
+		if (queue.empty()) break; // stop requested and all data written
+
+		auto* writer = queue.front().first;
+		auto data = std::move(queue.front().second);
+		queue.pop_front();
+		idleCond.notify_all(); // there's room in the queue
+		lock.unlock();
+
+		std::string err;
+		try {
+			writer->file.write(data.data(), data.size());
+		} catch (FileException& e) {
+			err = e.getMessage();
+		}
+
+		lock.lock();
+		if (!err.empty() && writer->error.empty()) {
+			writer->error = std::move(err);
+		}
+		--writer->pending;
+		if (freeBlocks.size() < MAX_QUEUED) {
+			data.clear();
+			freeBlocks.push_back(std::move(data));
+		}
+		idleCond.notify_all();
+	}
+}
+
+
+AsyncFileWriter::AsyncFileWriter(File file_, size_t blockSize_)
+	: file(std::move(file_))
+	, worker(Worker::instance())
+	, blockSize(blockSize_)
+{
+	block.reserve(blockSize);
+	worker.addWriter();
+}
+
+AsyncFileWriter::~AsyncFileWriter()
+{
+	if (!block.empty()) queueBlock();
+	{
+		// the background thread must be done with this object
+		std::unique_lock<std::mutex> lock(worker.mutex);
+		worker.idleCond.wait(lock, [&] { return pending == 0; });
+	}
+	worker.removeWriter();
+}
+
+void AsyncFileWriter::write(const void* data, size_t num)
+{
+	total += num;
+	auto* p = static_cast<const char*>(data);
+	while (num) {
+		size_t n = std::min(num, blockSize - block.size());
+		block.insert(block.end(), p, p + n);
+		p += n;
+		num -= n;
+		if (block.size() == blockSize) {
+			checkError();
+			queueBlock();
+		}
+	}
+}
+
+void AsyncFileWriter::queueBlock()
+{
+	std::vector<char> next;
+	{
+		std::unique_lock<std::mutex> lock(worker.mutex);
+		auto& queue = worker.queue;
+		if (queue.size() >= Worker::MAX_QUEUED) {
+			// disk can't keep up, limit the memory usage
+			++overruns;
+			worker.idleCond.wait(lock, [&] {
+				return queue.size() < Worker::MAX_QUEUED;
+			});
+		}
+		queue.emplace_back(this, std::move(block));
+		++pending;
+		if (!worker.freeBlocks.empty()) {
+			next = std::move(worker.freeBlocks.back());
+			worker.freeBlocks.pop_back();
+		}
+	}
+	worker.cond.notify_one();
+	block = std::move(next);
+	block.clear();
+	block.reserve(blockSize);
+}
+
+void AsyncFileWriter::flush()
+{
+	if (!block.empty()) queueBlock();
+	std::unique_lock<std::mutex> lock(worker.mutex);
+	worker.idleCond.wait(lock, [&] { return pending == 0; });
+	lock.unlock();
+	checkError();
+}
+
+void AsyncFileWriter::checkError()
+{
+	std::string err;
+	{
+		std::lock_guard<std::mutex> lock(worker.mutex);
+		err = std::move(error);
+		error.clear();
+	}
+	if (!err.empty()) throw FileException(err);
+}
+
+} // namespace openmsx
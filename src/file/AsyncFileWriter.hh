@@ -0,0 +1,68 @@
+#ifndef ASYNCFILEWRITER_HH
+#define ASYNCFILEWRITER_HH
+
+#include "File.hh"
+#include <string>
+#include <vector>
+
+namespace openmsx {
+
+/** Writes data to a file from a background thread, so that the thread
+  * producing the data (usually the emulation) never waits for the disk.
+  *
+  * Data is collected in blocks. Full blocks are passed to the background
+  * thread, which writes them in order. Write errors are reported (as a
+  * FileException) by a later call to write() or flush().
+  *
+  * All writers share one background thread, which only runs while there
+  * are writers. At most 16 blocks (of all writers together) are waiting to
+  * be written. When the disk can't keep up and that limit is reached,
+  * write() does wait for the background thread (this is counted as an
+  * overrun). Writers must be created and destroyed from the main thread.
+  */
+class AsyncFileWriter
+{
+public:
+	explicit AsyncFileWriter(File file, size_t blockSize = 64 * 1024);
+	/** Writes the remaining data (errors are ignored). */
+	~AsyncFileWriter();
+
+	void write(const void* data, size_t num);
+
+	/** Wait till all data written so far has reached the file.
+	  * @throw FileException
+	  */
+	void flush();
+
+	/** Direct access to the file, e.g. to rewrite a header. Only allowed
+	  * right after flush() (the background thread doesn't use the file
+	  * then). */
+	File& getFile() { return file; }
+
+	/** Total number of bytes passed to write(). */
+	size_t getSize() const { return total; }
+
+	/** The number of times write() had to wait for the disk. */
+	unsigned getOverruns() const { return overruns; }
+
+private:
+	class Worker;
+
+	void queueBlock();
+	void checkError();
+
+	File file;
+	Worker& worker;
+	const size_t blockSize;
+	std::vector<char> block; // being filled (only used by the producer)
+	size_t total = 0;
+	unsigned overruns = 0;
+
+	// shared with the background thread, protected by the worker's mutex
+	std::string error;
+	unsigned pending = 0; // number of blocks queued or being written
+};
+
+} // namespace openmsx
+
+#endif
@@ -3,6 +3,7 @@
 #include "hash_set.hh"
 #include "xxhash.hh"
 #include <cstring>
+#include <mutex>
 
 using std::string;
 
@@ -15,6 +16,8 @@ struct GetURLFromDecompressed {
 };
 static hash_set<std::shared_ptr<CompressedFileAdapter::Decompressed>,
                 GetURLFromDecompressed, XXHasher> decompressCache;
+// Files are also opened (and decompressed) from the FilePool worker threads.
+static std::mutex decompressCacheMutex;
 
 
 CompressedFileAdapter::CompressedFileAdapter(std::unique_ptr<FileBase> file_)
@@ -24,6 +27,7 @@ CompressedFileAdapter::CompressedFileAdapter(std::unique_ptr<FileBase> file_)
 
 CompressedFileAdapter::~CompressedFileAdapter()
 {
+	std::lock_guard<std::mutex> lock(decompressCacheMutex);
 	auto it = decompressCache.find(getURL());
 	decompressed.reset();
 	if (it != end(decompressCache) && it->unique()) {
@@ -37,15 +41,29 @@ void CompressedFileAdapter::decompress()
 	if (decompressed) return;
 
 	string url = getURL();
-	auto it = decompressCache.find(url);
-	if (it != end(decompressCache)) {
-		decompressed = *it;
-	} else {
-		decompressed = std::make_shared<Decompressed>();
-		decompress(*file, *decompressed);
-		decompressed->cachedModificationDate = getModificationDate();
-		decompressed->cachedURL = std::move(url);
-		decompressCache.insert_noDuplicateCheck(decompressed);
+	{
+		std::lock_guard<std::mutex> lock(decompressCacheMutex);
+		auto it = decompressCache.find(url);
+		if (it != end(decompressCache)) {
+			decompressed = *it;
+		}
+	}
+	if (!decompressed) {
+		// decompress without holding the lock
+		auto result = std::make_shared<Decompressed>();
+		decompress(*file, *result);
+		result->cachedModificationDate = getModificationDate();
+		result->cachedURL = url;
+
+		std::lock_guard<std::mutex> lock(decompressCacheMutex);
+		auto it = decompressCache.find(url);
+		if (it != end(decompressCache)) {
+			// another thread was faster
+			decompressed = *it;
+		} else {
+			decompressed = std::move(result);
+			decompressCache.insert_noDuplicateCheck(decompressed);
+		}
 	}
 
 	// close original file after succesful decompress
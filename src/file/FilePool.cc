@@ -11,9 +11,15 @@
 #include "EventDistributor.hh"
 #include "CliComm.hh"
 #include "Reactor.hh"
+#include "ThreadPool.hh"
 #include "Timer.hh"
+#include "hash_map.hh"
 #include "ranges.hh"
 #include "sha1.hh"
+#include "xxhash.hh"
+#include <algorithm>
+#include <chrono>
+#include <deque>
 #include <fstream>
 #include <memory>
 
@@ -319,7 +325,9 @@ File FilePool::getFile(FileType fileType, const Sha1Sum& sha1sum)
 	for (auto& d : directories) {
 		if (d.types & fileType) {
 			string path = FileOperations::expandTilde(d.path);
-			result = scanDirectory(sha1sum, path, d.path, progress);
+			vector<ScanEntry> files;
+			collectFiles(sha1sum, path, d.path, files, progress);
+			result = scanFiles(sha1sum, files, d.path, progress);
 			if (result.is_open()) return result;
 		}
 	}
@@ -423,96 +431,187 @@ File FilePool::getFromPool(const Sha1Sum& sha1sum)
 	return File(); // not found
 }
 
-File FilePool::scanDirectory(
-	const Sha1Sum& sha1sum, const string& directory, const string& poolPath,
+void FilePool::reportScanProgress(
+	const Sha1Sum& sha1sum, const string& poolPath, const string& filename,
 	ScanProgress& progress)
+{
+	// Periodically send a progress message with the current filename
+	auto now = Timer::getTime();
+	if (now > (progress.lastTime + 250000)) { // 4Hz
+		progress.lastTime = now;
+		reactor.getCliComm().printProgress(
+			"Searching for file with sha1sum ",
+			sha1sum.toString(), "...\nIndexing filepool ", poolPath,
+			": [", progress.amountScanned, "]: ",
+			string_view(filename).substr(poolPath.size()));
+	}
+
+	// deliverEvents() is relatively cheap when there are no events to
+	// deliver, so it's ok to call on each file.
+	reactor.getEventDistributor().deliverEvents();
+}
+
+void FilePool::collectFiles(
+	const Sha1Sum& sha1sum, const string& directory, const string& poolPath,
+	vector<ScanEntry>& files, ScanProgress& progress)
 {
 	ReadDir dir(directory);
 	while (dirent* d = dir.getEntry()) {
-		if (quit) {
-			// Scanning can take a long time. Allow to exit
-			// openmsx when it takes too long. Stop scanning
-			// by pretending we didn't find the file.
-			return File();
-		}
+		if (quit) return;
 		string file = d->d_name;
 		string path = strCat(directory, '/', file);
 		FileOperations::Stat st;
 		if (FileOperations::getStat(path, st)) {
-			File result;
 			if (FileOperations::isRegularFile(st)) {
-				result = scanFile(sha1sum, path, st, poolPath, progress);
+				reportScanProgress(sha1sum, poolPath, path, progress);
+				auto time = FileOperations::getModificationDate(st);
+				files.push_back({std::move(path), time});
 			} else if (FileOperations::isDirectory(st)) {
 				if ((file != ".") && (file != "..")) {
-					result = scanDirectory(sha1sum, path, poolPath, progress);
+					collectFiles(sha1sum, path, poolPath, files, progress);
 				}
 			}
-			if (result.is_open()) return result;
 		}
 	}
-	return File(); // not found
 }
 
-File FilePool::scanFile(const Sha1Sum& sha1sum, const string& filename,
-                        const FileOperations::Stat& st, const string& poolPath,
-                        ScanProgress& progress)
+// Like calcSha1sum() but without progress messages, so that it can run on a
+// worker thread.
+static Sha1Sum calcSha1sum(const string& filename)
 {
-	++progress.amountScanned;
-	// Periodically send a progress message with the current filename
-	auto now = Timer::getTime();
-	if (now > (progress.lastTime + 250000)) { // 4Hz
-		progress.lastTime = now;
-		reactor.getCliComm().printProgress(
-                        "Searching for file with sha1sum ",
-			sha1sum.toString(), "...\nIndexing filepool ", poolPath,
-			": [", progress.amountScanned, "]: ",
-			string_view(filename).substr(poolPath.size()));
-	}
+	File file(filename);
+	auto data = file.mmap();
+	return SHA1::calc(data.data(), data.size());
+}
 
-	// deliverEvents() is relatively cheap when there are no events to
-	// deliver, so it's ok to call on each file.
-	reactor.getEventDistributor().deliverEvents();
+File FilePool::scanFiles(
+	const Sha1Sum& sha1sum, vector<ScanEntry>& files, const string& poolPath,
+	ScanProgress& progress)
+{
+	// Look up the database entries for all scanned files with a single pass
+	// over the pool (instead of a linear search per file).
+	enum State : uint8_t { NEW, INVALID, KNOWN, HASHED, FAILED };
+	vector<State> state(files.size(), NEW);
+	vector<Sha1Sum> sums(files.size(), Sha1Sum(Sha1Sum::UninitializedTag{}));
+	vector<time_t> times(files.size());
+	hash_map<string_view, size_t, XXHasher> fileIdx;
+	for (size_t i = 0; i < files.size(); ++i) {
+		fileIdx[files[i].path] = i;
+	}
+	for (auto& p : pool) {
+		if (auto* f = lookup(fileIdx, string_view(p.filename))) {
+			if (p.getTime() == time_t(-1)) {
+				state[*f] = INVALID;
+			} else {
+				state[*f] = KNOWN;
+				sums[*f] = p.sum;
+				times[*f] = p.time;
+			}
+		}
+	}
 
-	auto it = findInDatabase(filename);
-	if (it == end(pool)) {
-		// not in pool
-		try {
-			File file(filename);
-			auto sum = calcSha1sum(file, reactor);
-			auto time = FileOperations::getModificationDate(st);
-			insert(sum, time, filename);
-			if (sum == sha1sum) {
-				return file;
+	// Only the local copies are updated while scanning (deliverEvents()
+	// might execute commands that also use the pool). The results are
+	// merged into the pool at the end, followed by a single sort.
+	bool changed = ranges::any_of(state, [](State s) { return s == INVALID; });
+	auto commit = [&] {
+		if (!changed) return;
+		for (auto& p : pool) {
+			auto* f = lookup(fileIdx, string_view(p.filename));
+			if (!f) continue;
+			switch (state[*f]) {
+			case INVALID:
+			case FAILED:
+				p.filename = nullptr; // remove below
+				break;
+			case HASHED:
+				p.setTime(files[*f].time);
+				p.sum = sums[*f];
+				state[*f] = KNOWN;
+				break;
+			default:
+				break;
 			}
-		} catch (FileException&) {
-			// ignore
 		}
-	} else {
-		// already in pool
-		assert(filename == it->filename);
-		assert(it->time != time_t(-1));
+		pool.erase(std::remove_if(begin(pool), end(pool),
+		                          [](const PoolEntry& e) { return e.filename == nullptr; }),
+		           end(pool));
+		for (size_t i = 0; i < files.size(); ++i) {
+			if (state[i] != HASHED) continue; // not yet in pool
+			stringBuffer.push_back(files[i].path);
+			pool.emplace_back(sums[i], files[i].time, stringBuffer.back().c_str());
+		}
+		ranges::sort(pool, ComparePool());
+		// Store the result right away: indexing a large filepool can
+		// take long, don't redo it when openMSX doesn't exit normally.
+		writeSha1sums();
+		needWrite = false;
+	};
+
+	// Files that are new or modified are hashed on worker threads. The
+	// results are processed in the order of the files, and only a limited
+	// number of jobs is queued, so that scanning stops soon after the file
+	// is found.
+	struct Pending {
+		size_t file;
+		std::future<Sha1Sum> sum;
+	};
+	std::deque<Pending> pending;
+	ThreadPool workers;
+	const size_t MAX_PENDING = 4 * std::max(1u, std::thread::hardware_concurrency());
+
+	// returns true when the file matches
+	auto processFirstPending = [&] {
+		auto& p = pending.front();
+		size_t f = p.file;
+		while (p.sum.wait_for(std::chrono::milliseconds(20)) !=
+		       std::future_status::ready) {
+			reportScanProgress(sha1sum, poolPath, files[f].path, progress);
+		}
 		try {
-			auto time = FileOperations::getModificationDate(st);
-			if (it->time == time) {
-				// db is still up to date
-				if (it->sum == sha1sum) {
-					return File(filename);
-				}
-			} else {
-				// db outdated
-				File file(filename);
-				auto sum = calcSha1sum(file, reactor);
-				it->setTime(time);
-				adjust(it, sum);
-				if (sum == sha1sum) {
-					return file;
-				}
-			}
-		} catch (FileException&) {
+			sums[f] = p.sum.get();
+			state[f] = HASHED;
+		} catch (MSXException&) {
 			// error reading file, remove from db
-			remove(it);
+			state[f] = FAILED;
+		}
+		changed = true;
+		pending.pop_front();
+		return (state[f] == HASHED) && (sums[f] == sha1sum);
+	};
+	auto found = [&](size_t f) {
+		commit();
+		return File(files[f].path);
+	};
+
+	for (size_t i = 0; i < files.size(); ++i) {
+		if (quit) {
+			// Scanning can take a long time. Allow to exit
+			// openmsx when it takes too long. Stop scanning
+			// by pretending we didn't find the file.
+			commit();
+			return File();
 		}
+		++progress.amountScanned;
+		reportScanProgress(sha1sum, poolPath, files[i].path, progress);
+
+		if ((state[i] == KNOWN) && (times[i] == files[i].time)) {
+			// db is still up to date
+			if (sums[i] == sha1sum) return found(i);
+			continue;
+		}
+		pending.push_back({i, workers.enqueue(
+			[filename = files[i].path] { return calcSha1sum(filename); })});
+		if (pending.size() == MAX_PENDING) {
+			size_t f = pending.front().file;
+			if (processFirstPending()) return found(f);
+		}
+	}
+	while (!pending.empty() && !quit) {
+		size_t f = pending.front().file;
+		if (processFirstPending()) return found(f);
 	}
+	commit();
 	return File(); // not found
 }
 
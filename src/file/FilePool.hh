@@ -48,6 +48,10 @@ private:
 		uint64_t lastTime;
 		unsigned amountScanned;
 	};
+	struct ScanEntry {
+		std::string path;
+		time_t time;
+	};
 	struct Entry {
 		std::string path;
 		int types;
@@ -97,15 +101,17 @@ private:
 	void writeSha1sums();
 
 	File getFromPool(const Sha1Sum& sha1sum);
-	File scanDirectory(const Sha1Sum& sha1sum,
-	                   const std::string& directory,
-	                   const std::string& poolPath,
-	                   ScanProgress& progress);
-	File scanFile(const Sha1Sum& sha1sum,
-	              const std::string& filename,
-	              const FileOperations::Stat& st,
-	              const std::string& poolPath,
-	              ScanProgress& progress);
+	void collectFiles(const Sha1Sum& sha1sum,
+	                  const std::string& directory,
+	                  const std::string& poolPath,
+	                  std::vector<ScanEntry>& files,
+	                  ScanProgress& progress);
+	File scanFiles(const Sha1Sum& sha1sum,
+	               std::vector<ScanEntry>& files,
+	               const std::string& poolPath,
+	               ScanProgress& progress);
+	void reportScanProgress(const Sha1Sum& sha1sum, const std::string& poolPath,
+	                        const std::string& filename, ScanProgress& progress);
 	Pool::iterator findInDatabase(const std::string& filename);
 
 	Directories getDirectories() const;
@@ -3,15 +3,21 @@
 #include "yuv2rgb.hh"
 #include "likely.hh"
 #include "CliComm.hh"
+#include "Filename.hh"
 #include "MemoryOps.hh"
+#include "RawFrame.hh"
+#include "endian.hh"
 #include "ranges.hh"
 #include "stl.hh"
+#include "strCat.hh"
 #include "stringsp.hh" // for strncasecmp
 #include "view.hh"
+#include <SDL.h>
 #include <cstring> // for memcpy, memcmp
 #include <cstdlib> // for atoi
 #include <cctype> // for isspace
 #include <memory>
+#include <algorithm>
 
 // TODO
 // - Improve error handling
@@ -19,7 +25,12 @@
 // - Clean up this mess!
 namespace openmsx {
 
+// Number of decoded frames and audio fragments the decoder thread reads ahead
+static const size_t PREFETCH_FRAMES = 8;
+static const size_t PREFETCH_AUDIO = 64;
+
 Frame::Frame(const th_ycbcr_buffer& yuv)
+	: rgbValid(false)
 {
 	unsigned y_size  = yuv[0].height * yuv[0].stride;
 	unsigned uv_size = yuv[1].height * yuv[1].stride;
@@ -43,6 +54,47 @@ Frame::~Frame()
 }
 
 
+/** Gives the emulation thread exclusive access to the decoder. The decoder
+ * thread backs off (between two packets) as soon as such a request is made.
+ */
+class OggReader::DecoderLock
+{
+public:
+	explicit DecoderLock(OggReader& reader_)
+		: reader(reader_)
+	{
+		++reader.requests;
+		lock = std::unique_lock<std::mutex>(reader.mutex);
+		--reader.requests;
+	}
+
+	~DecoderLock()
+	{
+		reader.flushWarnings();
+		lock.unlock();
+		reader.cond.notify_one();
+	}
+
+private:
+	OggReader& reader;
+	std::unique_lock<std::mutex> lock;
+};
+
+template<typename... Args>
+void OggReader::warning(Args&&... args)
+{
+	warnings.push_back(strCat(std::forward<Args>(args)...));
+}
+
+void OggReader::flushWarnings()
+{
+	for (auto& w : warnings) {
+		cli.printWarning(w);
+	}
+	warnings.clear();
+}
+
+
 OggReader::OggReader(const Filename& filename, CliComm& cli_)
 	: cli(cli_)
 	, file(filename)
@@ -55,6 +107,11 @@ OggReader::OggReader(const Filename& filename, CliComm& cli_)
 	currentSample = 0;
 	currentFrame = 1;
 	vorbisPos = 0;
+	requests = 0;
+	stopDecoder = false;
+	endOfStream = false;
+	stopIndexer = false;
+	indexReady = false;
 
 	th_info ti;
 	th_comment tc;
@@ -201,6 +258,9 @@ OggReader::OggReader(const Filename& filename, CliComm& cli_)
 	th_setup_free(tsi);
 	th_info_clear(&ti);
 	th_comment_clear(&tc);
+
+	flushWarnings();
+	startThreads(filename.getResolved());
 }
 
 void OggReader::cleanup()
@@ -227,9 +287,93 @@ void OggReader::cleanup()
 
 OggReader::~OggReader()
 {
+	stopThreads();
 	cleanup();
 }
 
+void OggReader::startThreads(const std::string& filename)
+{
+	decoder = std::thread([this]() { decoderLoop(); });
+	indexer = std::thread([this, filename]() { buildIndex(filename); });
+}
+
+void OggReader::stopThreads()
+{
+	stopIndexer = true;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopDecoder = true;
+	}
+	cond.notify_one();
+	decoder.join();
+	indexer.join();
+}
+
+bool OggReader::needPrefetch() const
+{
+	if (pixelFormat && ranges::any_of(frameList,
+			[](auto& f) { return !f->rgbValid; })) {
+		return true;
+	}
+	return !endOfStream &&
+	       (frameList.size() < PREFETCH_FRAMES) &&
+	       (audioList.size() < PREFETCH_AUDIO);
+}
+
+void OggReader::decoderLoop()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true) {
+		cond.wait(lock, [&] {
+			return stopDecoder || ((requests == 0) && needPrefetch());
+		});
+		if (stopDecoder) break;
+
+		// First convert the frames we already have, then decode more.
+		auto it = ranges::find_if(frameList,
+			[](auto& f) { return !f->rgbValid; });
+		if (pixelFormat && (it != end(frameList))) {
+			convertFrame(**it);
+		} else if (!nextPacket()) {
+			endOfStream = true;
+		}
+	}
+}
+
+void OggReader::convertFrame(Frame& frame)
+{
+	if (!frame.rgb) {
+		frame.rgb = std::make_unique<RawFrame>(
+			*pixelFormat, frame.buffer[0].width,
+			frame.buffer[0].height);
+	}
+	yuv2rgb::convert(frame.buffer, *frame.rgb);
+	frame.rgbValid = true;
+}
+
+void OggReader::setPixelFormat(const SDL_PixelFormat& format)
+{
+	if (pixelFormat &&
+	    (pixelFormat->BytesPerPixel == format.BytesPerPixel) &&
+	    (pixelFormat->Rmask == format.Rmask) &&
+	    (pixelFormat->Gmask == format.Gmask) &&
+	    (pixelFormat->Bmask == format.Bmask) &&
+	    (pixelFormat->Amask == format.Amask)) {
+		return;
+	}
+
+	// The converted frames refer to the old format, drop them.
+	for (auto& f : frameList) {
+		f->rgb.reset();
+		f->rgbValid = false;
+	}
+	for (auto& f : recycleFrameList) {
+		f->rgb.reset();
+		f->rgbValid = false;
+	}
+	pixelFormat = std::make_unique<SDL_PixelFormat>(format);
+}
+
 /** Vorbis only records the ogg position (in no. of samples) once per ogg
  * page. After seeking we have already decoded some audio before we encounter
  * the exact position we are at. Fixup the positions and discard any unwanted
@@ -245,7 +389,7 @@ void OggReader::vorbisFoundPosition()
 
 	// last is now the first vorbis audio decoded
 	if (last > currentSample) {
-		cli.printWarning("missing part of audio stream");
+		warning("missing part of audio stream");
 	}
 
 	if (vorbisPos > currentSample) {
@@ -408,9 +552,8 @@ void OggReader::readVorbis(ogg_packet* packet)
 			vorbisFoundPosition();
 		} else {
 			if (vorbisPos != size_t(packet->granulepos)) {
-				cli.printWarning(
-                                        "vorbis audio out of sync, expected ",
-					vorbisPos, ", got ", packet->granulepos);
+				warning("vorbis audio out of sync, expected ",
+				        vorbisPos, ", got ", packet->granulepos);
 				vorbisPos = packet->granulepos;
 			}
 		}
@@ -529,25 +672,25 @@ void OggReader::readTheora(ogg_packet* packet)
 	switch (rc) {
 	case TH_DUPFRAME:
 		if (frameList.empty()) {
-			cli.printWarning("Theora error: dup frame encountered "
-					 "without preceding frame");
+			warning("Theora error: dup frame encountered "
+			        "without preceding frame");
 		} else {
 			frameList.back()->length++;
 		}
 		break;
 	case TH_EIMPL:
-		cli.printWarning("Theora error: not capable of reading this");
+		warning("Theora error: not capable of reading this");
 		break;
 	case TH_EFAULT:
-		cli.printWarning("Theora error: API not used correctly");
+		warning("Theora error: API not used correctly");
 		break;
 	case TH_EBADPACKET:
-		cli.printWarning("Theora error: bad packet");
+		warning("Theora error: bad packet");
 		break;
 	case 0:
 		break;
 	default:
-		cli.printWarning("Theora error: unknown error ", rc);
+		warning("Theora error: unknown error ", rc);
 		break;
 	}
 
@@ -574,6 +717,7 @@ void OggReader::readTheora(ogg_packet* packet)
 		frame = std::move(recycleFrameList.back());
 		recycleFrameList.pop_back();
 	}
+	frame->rgbValid = false;
 
 	int y_size  = yuv[0].height * yuv[0].stride;
 	int uv_size = yuv[1].height * yuv[1].stride;
@@ -588,7 +732,7 @@ void OggReader::readTheora(ogg_packet* packet)
 	if (last && (last->no != size_t(-1))) {
 		if ((frameno != size_t(-1)) &&
 		    (frameno != last->no + last->length)) {
-			cli.printWarning("Theora frame sequence wrong");
+			warning("Theora frame sequence wrong");
 		} else {
 			frameno = last->no + last->length;
 		}
@@ -613,6 +757,8 @@ void OggReader::readTheora(ogg_packet* packet)
 
 void OggReader::getFrameNo(RawFrame& rawFrame, size_t frameno)
 {
+	DecoderLock lock(*this);
+
 	Frame* frame;
 	while (true) {
 		// If there are no frames or the frames we have read
@@ -635,8 +781,7 @@ void OggReader::getFrameNo(RawFrame& rawFrame, size_t frameno)
 		if (!frameList.empty() && frameList[0]->no > frameno) {
 			// we're missing frames!
 			frame = frameList[0].get();
-			cli.printWarning(
-                                "Cannot find frame ", frameno, " using ",
+			warning("Cannot find frame ", frameno, " using ",
 			        frame->no, " instead");
 			break;
 		}
@@ -659,7 +804,7 @@ void OggReader::getFrameNo(RawFrame& rawFrame, size_t frameno)
 		if (frameList.size() > (size_t(2) << granuleShift)) {
 			// We've got more than twice as many frames
 			// as the maximum distance between key frames.
-			cli.printWarning("Cannot find frame ", frameno);
+			warning("Cannot find frame ", frameno);
 			return;
 		}
 
@@ -669,7 +814,20 @@ void OggReader::getFrameNo(RawFrame& rawFrame, size_t frameno)
 		}
 	}
 
-	yuv2rgb::convert(frame->buffer, rawFrame);
+	setPixelFormat(rawFrame.getSDLPixelFormat());
+	if (frame->rgbValid) {
+		// already converted by the decoder thread
+		unsigned bpp = pixelFormat->BytesPerPixel;
+		for (unsigned y = 0; y < frame->rgb->getHeight(); ++y) {
+			unsigned width = frame->rgb->getLineWidthDirect(y);
+			memcpy(rawFrame.getLinePtrDirect<char>(y),
+			       frame->rgb->getLinePtrDirect<char>(y),
+			       width * bpp);
+			rawFrame.setLineWidth(y, width);
+		}
+	} else {
+		yuv2rgb::convert(frame->buffer, rawFrame);
+	}
 }
 
 void OggReader::recycleAudio(std::unique_ptr<AudioFragment> audio)
@@ -680,6 +838,10 @@ void OggReader::recycleAudio(std::unique_ptr<AudioFragment> audio)
 
 const AudioFragment* OggReader::getAudio(size_t sample)
 {
+	// The returned fragment stays valid after the lock is released: the
+	// decoder thread only appends to audioList.
+	DecoderLock lock(*this);
+
 	// Read while position is unknown
 	while (audioList.empty() ||
 	       audioList.front()->position == AudioFragment::UNKNOWN_POS) {
@@ -752,15 +914,15 @@ bool OggReader::nextPacket()
 		int serial = ogg_page_serialno(&page);
 		if (serial == audioSerial) {
 			if (ogg_stream_pagein(&vorbisStream, &page)) {
-				cli.printWarning("Failed to submit vorbis page");
+				warning("Failed to submit vorbis page");
 			}
 		} else if (serial == videoSerial) {
 			if (ogg_stream_pagein(&theoraStream, &page)) {
-				cli.printWarning("Failed to submit theora page");
+				warning("Failed to submit theora page");
 			}
 		} else if (serial != skeletonSerial) {
-			cli.printWarning("Unexpected stream with serial ",
-			                 serial, " in ogg file");
+			warning("Unexpected stream with serial ",
+			        serial, " in ogg file");
 		}
 	}
 }
@@ -790,7 +952,7 @@ bool OggReader::nextPage(ogg_page* page)
 		fileOffset += chunk;
 
 		if (ogg_sync_wrote(&sync, long(chunk)) == -1) {
-			cli.printWarning("Internal error: ogg_sync_wrote failed");
+			warning("Internal error: ogg_sync_wrote failed");
 		}
 	}
 
@@ -853,10 +1015,225 @@ size_t OggReader::bisection(
 	}
 }
 
+// Seek index file: a header of 64-bit little endian words (see below),
+// followed by the keyframe and then the audio entries (two words each).
+static const char INDEX_MAGIC[8] = { 'o','M','S','X','o','g','g','1' };
+static const size_t INDEX_HEADER = 7 * 8;
+
+static bool loadIndex(const std::string& name, time_t date,
+                      OggSeekIndex& index)
+{
+	std::vector<uint8_t> buf;
+	try {
+		File file(name);
+		buf.resize(file.getSize());
+		file.read(buf.data(), buf.size());
+	} catch (MSXException&) {
+		return false;
+	}
+	if ((buf.size() < INDEX_HEADER) ||
+	    (memcmp(buf.data(), INDEX_MAGIC, 8) != 0)) {
+		return false;
+	}
+	auto get = [&](size_t i) { return Endian::read_UA_L64(&buf[8 * i]); };
+	if ((get(1) != index.fileSize) || (get(2) != uint64_t(date))) {
+		return false; // ogg file has changed
+	}
+	auto numKeys  = get(5);
+	auto numAudio = get(6);
+	auto maxEntries = (buf.size() - INDEX_HEADER) / 16;
+	if ((numKeys > maxEntries) || (numAudio > maxEntries) ||
+	    ((numKeys + numAudio) != maxEntries)) {
+		return false;
+	}
+	index.totalFrames  = get(3);
+	index.totalSamples = get(4);
+	size_t i = INDEX_HEADER / 8;
+	index.keyFrames.resize(numKeys);
+	for (auto& e : index.keyFrames) {
+		e.pos = get(i++); e.offset = get(i++);
+	}
+	index.audio.resize(numAudio);
+	for (auto& e : index.audio) {
+		e.pos = get(i++); e.offset = get(i++);
+	}
+	return true;
+}
+
+static void saveIndex(const std::string& name, time_t date,
+                      const OggSeekIndex& index)
+{
+	std::vector<uint8_t> buf;
+	buf.reserve(INDEX_HEADER +
+	            16 * (index.keyFrames.size() + index.audio.size()));
+	buf.insert(end(buf), INDEX_MAGIC, INDEX_MAGIC + 8);
+	auto put = [&](uint64_t w) {
+		uint8_t tmp[8];
+		Endian::write_UA_L64(tmp, w);
+		buf.insert(end(buf), tmp, tmp + 8);
+	};
+	put(index.fileSize);
+	put(uint64_t(date));
+	put(index.totalFrames);
+	put(index.totalSamples);
+	put(index.keyFrames.size());
+	put(index.audio.size());
+	for (auto& e : index.keyFrames) { put(e.pos); put(e.offset); }
+	for (auto& e : index.audio)     { put(e.pos); put(e.offset); }
+	try {
+		File file(name, File::TRUNCATE);
+		file.write(buf.data(), buf.size());
+	} catch (MSXException&) {
+		// e.g. read-only directory, we'll just build it again next time
+	}
+}
+
+/** Walk over all ogg pages, only looking at the page headers. Returns false
+ * when interrupted.
+ */
+static bool scanIndex(File& file, int videoSerial, int audioSerial,
+                      int granuleShift, const std::atomic<bool>& stop,
+                      OggSeekIndex& index)
+{
+	static const size_t BUF_SIZE = 64 * 1024;
+	std::vector<uint8_t> buf(BUF_SIZE);
+	size_t bufStart = 0;
+	size_t bufLen = 0;
+	// Returns a pointer to the data at [offset, offset + num), or nullptr
+	// when that's beyond the end of the file.
+	auto fetch = [&](size_t offset, size_t num) -> const uint8_t* {
+		if ((offset < bufStart) || ((offset + num) > (bufStart + bufLen))) {
+			if ((offset + num) > index.fileSize) return nullptr;
+			bufStart = offset;
+			bufLen = std::min<size_t>(BUF_SIZE, index.fileSize - offset);
+			file.seek(offset);
+			file.read(buf.data(), bufLen);
+		}
+		return &buf[offset - bufStart];
+	};
+
+	const uint64_t intraMask = (uint64_t(1) << granuleShift) - 1;
+	uint64_t lastKey = 0;
+	uint64_t lastVideoOffset = 0;
+	size_t offset = 0;
+	while (!stop) {
+		const uint8_t* header = fetch(offset, 27);
+		if (!header) break;
+		if (memcmp(header, "OggS", 4) != 0) {
+			// not at a page boundary (damaged file?), resync
+			++offset;
+			continue;
+		}
+		unsigned segments = header[26];
+		header = fetch(offset, 27 + segments);
+		if (!header) break;
+
+		uint64_t granule = Endian::read_UA_L64(header + 6);
+		int serial = int(Endian::read_UA_L32(header + 14));
+		size_t bodySize = 0;
+		for (unsigned i = 0; i < segments; ++i) {
+			bodySize += header[27 + i];
+		}
+
+		if (granule != uint64_t(-1)) {
+			if (serial == videoSerial) {
+				uint64_t key = granule >> granuleShift;
+				uint64_t frame = key + (granule & intraMask);
+				if (key > lastKey) {
+					// The keyframe packet starts after the
+					// last packet of the previous video page.
+					index.keyFrames.push_back({key, lastVideoOffset});
+					lastKey = key;
+				}
+				lastVideoOffset = offset;
+				index.totalFrames = std::max(index.totalFrames, frame);
+			} else if (serial == audioSerial) {
+				index.audio.push_back({granule, offset});
+				index.totalSamples = std::max(index.totalSamples, granule);
+			}
+		}
+		offset += 27 + segments + bodySize;
+	}
+	return !stop;
+}
+
+void OggReader::buildIndex(const std::string& filename)
+{
+	auto indexName = filename + ".seekindex";
+	try {
+		OggSeekIndex result;
+		File ogg(filename);
+		result.fileSize = ogg.getSize();
+		time_t date = ogg.getModificationDate();
+		if (!loadIndex(indexName, date, result)) {
+			if (!scanIndex(ogg, videoSerial, audioSerial,
+			               granuleShift, stopIndexer, result)) {
+				return;
+			}
+			saveIndex(indexName, date, result);
+		}
+		index = std::move(result);
+		indexReady.store(true, std::memory_order_release);
+	} catch (MSXException&) {
+		// no index, seeking falls back to bisection
+	}
+}
+
+bool OggReader::lookupIndex(size_t frame, size_t sample, size_t& offset)
+{
+	if (!indexReady.load(std::memory_order_acquire)) return false;
+
+	fileSize = file.getSize();
+	if (fileSize != index.fileSize) return false;
+
+	totalFrames = index.totalFrames;
+
+	// see findOffset()
+	if (sample < getSampleRate() || frame <= 30) {
+		keyFrame = 1;
+		offset = 0;
+		return true;
+	}
+	if ((sample > index.totalSamples) || (frame > index.totalFrames)) {
+		sample = index.totalSamples;
+		frame = index.totalFrames;
+	}
+
+	// last keyframe at or before the requested frame
+	auto k = std::upper_bound(begin(index.keyFrames), end(index.keyFrames),
+		frame, [](size_t f, const OggSeekIndex::Entry& e) {
+			return f < e.pos; });
+	if (k == begin(index.keyFrames)) {
+		keyFrame = 1;
+		offset = 0;
+		return true;
+	}
+	--k;
+	keyFrame = k->pos;
+
+	// Last audio page that ends before the requested sample. Go back one
+	// more page, vorbis needs the preceding packet to decode.
+	auto a = std::lower_bound(begin(index.audio), end(index.audio),
+		sample, [](const OggSeekIndex::Entry& e, size_t s) {
+			return e.pos < s; });
+	size_t audioOffset = 0;
+	if ((a - begin(index.audio)) >= 2) {
+		audioOffset = (a - 2)->offset;
+	}
+
+	offset = std::min<size_t>(k->offset, audioOffset);
+	return true;
+}
+
 size_t OggReader::findOffset(size_t frame, size_t sample)
 {
 	static const size_t STEP = 32 * 1024;
 
+	size_t indexOffset;
+	if (lookupIndex(frame, sample, indexOffset)) {
+		return indexOffset;
+	}
+
 	// first calculate total length in bytes, samples and frames
 
 	// The file might have changed since we last requested its size,
@@ -935,6 +1312,8 @@ size_t OggReader::findOffset(size_t frame, size_t sample)
 
 bool OggReader::seek(size_t frame, size_t samples)
 {
+	DecoderLock lock(*this);
+
 	// Remove all queued frames
 	recycleFrameList.insert(end(recycleFrameList),
 		make_move_iterator(begin(frameList)),
@@ -958,6 +1337,7 @@ bool OggReader::seek(size_t frame, size_t samples)
 	vorbisPos = AudioFragment::UNKNOWN_POS;
 	currentFrame = frame;
 	currentSample = samples;
+	endOfStream = false;
 
 	vorbis_synthesis_restart(&vd);
 
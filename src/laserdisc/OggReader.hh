@@ -6,11 +6,19 @@
 #include <ogg/ogg.h>
 #include <vorbis/codec.h>
 #include <theora/theoradec.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
 #include <memory>
+#include <mutex>
 #include <list>
+#include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
+struct SDL_PixelFormat;
+
 namespace openmsx {
 
 class CliComm;
@@ -34,6 +42,27 @@ struct Frame
 	th_ycbcr_buffer buffer;
 	size_t no;
 	int length;
+
+	// RGB version of this frame, filled in by the decoder thread
+	std::unique_ptr<RawFrame> rgb;
+	bool rgbValid;
+};
+
+/** Maps frame and sample numbers to file offsets, so that seeking doesn't
+ * require searching through the file. It's built once, in a background
+ * thread, and stored next to the ogg file.
+ */
+struct OggSeekIndex
+{
+	struct Entry {
+		uint64_t pos;    // keyframe or sample number
+		uint64_t offset; // file offset from where to start reading
+	};
+	std::vector<Entry> keyFrames; // offset of last video page before keyframe
+	std::vector<Entry> audio;     // offset of each vorbis page with a granule
+	uint64_t fileSize = 0;
+	uint64_t totalFrames = 0;
+	uint64_t totalSamples = 0;
 };
 
 class OggReader
@@ -57,7 +86,19 @@ public:
 	size_t getChapter(int chapterNo) const;
 
 private:
+	class DecoderLock;
+
 	void cleanup();
+	void startThreads(const std::string& filename);
+	void stopThreads();
+	void decoderLoop();
+	bool needPrefetch() const;
+	void convertFrame(Frame& frame);
+	void setPixelFormat(const SDL_PixelFormat& format);
+	void flushWarnings();
+	template<typename... Args> void warning(Args&&... args);
+	void buildIndex(const std::string& filename);
+	bool lookupIndex(size_t frame, size_t sample, size_t& offset);
 	void readTheora(ogg_packet* packet);
 	void theoraHeaderPage(ogg_page* page, th_info& ti, th_comment& tc,
 	                      th_setup_info*& tsi);
@@ -119,6 +160,25 @@ private:
 	// Metadata
 	std::vector<size_t> stopFrames;
 	std::vector<std::pair<int, size_t>> chapters;
+
+	// Decoder thread. It decodes ahead (and converts the frames to RGB)
+	// while the emulation thread isn't using the decoder. All decoder
+	// state above is protected by 'mutex'.
+	std::thread decoder;
+	std::mutex mutex;
+	std::condition_variable cond;
+	std::atomic<int> requests;
+	bool stopDecoder;
+	bool endOfStream;
+	std::unique_ptr<SDL_PixelFormat> pixelFormat;
+	// CliComm may only be used from the main thread
+	std::vector<std::string> warnings;
+
+	// Seek index, only used once 'indexReady' is set
+	std::thread indexer;
+	std::atomic<bool> stopIndexer;
+	std::atomic<bool> indexReady;
+	OggSeekIndex index;
 };
 
 } // namespace openmsx
@@ -37,6 +37,8 @@ public:
 	const std::string& getDescription() const override;
 	byte read(unsigned address) override;
 	void write(unsigned address, byte value) override;
+	void readBlock(unsigned start, span<byte> output) override;
+	void writeBlock(unsigned start, span<const byte> input) override;
 	void moved(Rom& r);
 private:
 	Debugger& debugger;
@@ -415,6 +417,17 @@ void RomDebuggable::write(unsigned /*address*/, byte /*value*/)
 	// ignore
 }
 
+void RomDebuggable::readBlock(unsigned start, span<byte> output)
+{
+	assert((start + output.size()) <= getSize());
+	memcpy(output.data(), &(*rom)[start], output.size());
+}
+
+void RomDebuggable::writeBlock(unsigned /*start*/, span<const byte> /*input*/)
+{
+	// ignore
+}
+
 void RomDebuggable::moved(Rom& r)
 {
 	rom = &r;
@@ -6,16 +6,22 @@
 #include "CliComm.hh"
 #include "MSXException.hh"
 #include "StringOp.hh"
+#include "Timer.hh"
+#include "Version.hh"
 #include "String32.hh"
 #include "hash_map.hh"
 #include "ranges.hh"
 #include "rapidsax.hh"
+#include "random.hh"
 #include "unreachable.hh"
 #include "stl.hh"
 #include "view.hh"
 #include "xxhash.hh"
 #include <cassert>
+#include <cstdio>
+#include <cstring>
 #include <stdexcept>
+#include <type_traits>
 
 using std::string;
 using std::vector;
@@ -28,10 +34,11 @@ class DBParser : public rapidsax::NullHandler
 {
 public:
 	DBParser(RomDatabase::RomDB& db_, UnknownTypes& unknownTypes_,
-	         CliComm& cliComm_, char* bufStart_)
+	         CliComm& cliComm_, unsigned& numWarnings_, char* bufStart_)
 		: db(db_)
 		, unknownTypes(unknownTypes_)
 		, cliComm(cliComm_)
+		, numWarnings(numWarnings_)
 		, bufStart(bufStart_)
 		, state(BEGIN)
 		, unknownLevel(0)
@@ -85,6 +92,7 @@ private:
 	RomDatabase::RomDB& db;
 	UnknownTypes& unknownTypes;
 	CliComm& cliComm;
+	unsigned& numWarnings;
 	char* bufStart;
 
 	string_view systemID;
@@ -327,6 +335,7 @@ void DBParser::text(string_view txt)
 		try {
 			genMSXid = fast_stou(txt);
 		} catch (std::invalid_argument&) {
+			++numWarnings;
 			cliComm.printWarning(
 				"Ignoring bad Generation MSX id (genmsxid) "
 				"in entry with title '", title,
@@ -409,6 +418,7 @@ void DBParser::addAllEntries()
 	// move non-duplicates up
 	while (it2 != last) {
 		if (it1->first == it2->first) {
+			++numWarnings;
 			cliComm.printWarning(
 				"duplicate softwaredb entry SHA1: ",
 				it2->first.toString());
@@ -546,10 +556,11 @@ void DBParser::doctype(string_view txt)
 	systemID = t.substr(0, pos2);
 }
 
-static void parseDB(CliComm& cliComm, char* buf, char* bufStart,
-                    RomDatabase::RomDB& db, UnknownTypes& unknownTypes)
+static void parseDB(CliComm& cliComm, unsigned& numWarnings, char* buf,
+                    char* bufStart, RomDatabase::RomDB& db,
+                    UnknownTypes& unknownTypes)
 {
-	DBParser handler(db, unknownTypes, cliComm, bufStart);
+	DBParser handler(db, unknownTypes, cliComm, numWarnings, bufStart);
 	rapidsax::parse<rapidsax::trimWhitespace>(handler, buf);
 
 	if (handler.getSystemID() != "softwaredb1.dtd") {
@@ -560,18 +571,123 @@ static void parseDB(CliComm& cliComm, char* buf, char* bufStart,
 	}
 }
 
+// Parsing the database takes a noticeable part of the startup time. So the
+// parsed result (the modified text buffer plus the sorted table, which only
+// refers to the buffer via offsets) is stored in a binary cache file. It's
+// only used when the key (which files, their size and modification time)
+// still matches. The cache is only specific to this build (the layout of
+// RomInfo, the numbering of RomType), so it's stored in the user data
+// directory and the key also contains the exact openMSX version.
+static const char* const DB_CACHE = "/.softwaredb.cache";
+static const char DB_CACHE_MAGIC[16] = "openMSX swdb v2";
+// Offsets (instead of pointers) are needed to be able to reuse the buffer.
+static const bool DB_CACHE_ENABLED = std::is_same<String32, uint32_t>::value;
+
+struct DBCacheHeader
+{
+	char magic[16];
+	uint32_t entrySize;
+	uint32_t keySize;
+	uint64_t bufferSize;
+	uint64_t numEntries;
+	// followed by the key, the buffer and the entries
+};
+
+static string cacheKey(vector<std::pair<string, File>>& files)
+{
+	string result = strCat(Version::full(), ' ', Version::BUILD_FLAVOUR,
+	                       ' ', sizeof(RomInfo), ' ', int(ROM_END_OF_UNORDERED_LIST), '\n');
+	for (auto& f : files) {
+		strAppend(result, f.first, ' ', f.second.getSize(), ' ',
+		          uint64_t(f.second.getModificationDate()), '\n');
+	}
+	return result;
+}
+
+bool RomDatabase::loadCache(const string& key)
+{
+	File file(FileOperations::getUserDataDir() + DB_CACHE);
+	auto mem = file.mmap();
+	DBCacheHeader header;
+	if (mem.size() < sizeof(header)) return false;
+	memcpy(&header, mem.data(), sizeof(header));
+	if ((memcmp(header.magic, DB_CACHE_MAGIC, sizeof(header.magic)) != 0) ||
+	    (header.entrySize != sizeof(RomDB::value_type)) ||
+	    (mem.size() != (sizeof(header) + header.keySize + header.bufferSize +
+	                    header.numEntries * header.entrySize))) {
+		return false;
+	}
+	auto* p = mem.data() + sizeof(header);
+	if (string_view(reinterpret_cast<const char*>(p), header.keySize) != key) {
+		return false;
+	}
+	p += header.keySize;
+	const char* buf = reinterpret_cast<const char*>(p);
+	p += header.bufferSize;
+	db.resize(header.numEntries, RomDB::value_type(
+		Sha1Sum(), RomInfo({}, {}, {}, {}, false, {}, {}, ROM_UNKNOWN, 0)));
+	static_assert(std::is_trivially_copyable<Sha1Sum>::value &&
+	              std::is_trivially_copyable<RomInfo>::value,
+	              "entries are stored as raw bytes");
+	memcpy(static_cast<void*>(db.data()), p,
+	       header.numEntries * header.entrySize);
+
+	// keep the file mapped, the entries refer to the buffer in it
+	cacheFile = std::move(file);
+	bufferStart = buf;
+	return true;
+}
+
+void RomDatabase::storeCache(const string& key, size_t bufferSize) const
+{
+	// Several openMSX processes may start at the same time, so write a
+	// temporary file and (atomically) rename it afterwards.
+	string filename = FileOperations::getUserDataDir() + DB_CACHE;
+	string tmpName = strCat(filename, '.', random_32bit());
+	try {
+		DBCacheHeader header;
+		memcpy(header.magic, DB_CACHE_MAGIC, sizeof(header.magic));
+		header.entrySize = sizeof(RomDB::value_type);
+		header.keySize = uint32_t(key.size());
+		header.bufferSize = bufferSize;
+		header.numEntries = db.size();
+		{
+			FileOperations::mkdirp(FileOperations::getUserDataDir());
+			File file(tmpName, File::TRUNCATE);
+			file.write(&header, sizeof(header));
+			file.write(key.data(), key.size());
+			file.write(buffer.data(), bufferSize);
+			file.write(db.data(), db.size() * sizeof(RomDB::value_type));
+		}
+		if (std::rename(tmpName.c_str(), filename.c_str()) != 0) {
+			// On windows rename() fails when the destination exists.
+			FileOperations::unlink(filename);
+			if (std::rename(tmpName.c_str(), filename.c_str()) != 0) {
+				FileOperations::unlink(tmpName);
+			}
+		}
+	} catch (MSXException&) {
+		// Ignore, the cache is only an optimization.
+		FileOperations::unlink(tmpName);
+	}
+}
+
 RomDatabase::RomDatabase(CliComm& cliComm)
+	: bufferStart(nullptr)
 {
+	auto startTime = Timer::getTime();
 	db.reserve(3500);
 	UnknownTypes unknownTypes;
 	// first user- then system-directory
 	vector<string> paths = systemFileContext().getPaths();
-	vector<File> files;
+	vector<std::pair<string, File>> files;
 	size_t bufferSize = 0;
 	for (auto& p : paths) {
 		try {
-			files.emplace_back(FileOperations::join(p, "softwaredb.xml"));
-			bufferSize += files.back().getSize() + rapidsax::EXTRA_BUFFER_SPACE;
+			auto filename = FileOperations::join(p, "softwaredb.xml");
+			File file(filename);
+			bufferSize += file.getSize() + rapidsax::EXTRA_BUFFER_SPACE;
+			files.emplace_back(std::move(filename), std::move(file));
 		} catch (MSXException& /*e*/) {
 			// Ignore. It's not unusual the DB in the user
 			// directory is not found. In case there's an error
@@ -579,9 +695,26 @@ RomDatabase::RomDatabase(CliComm& cliComm)
 			// warning, but that's done below.
 		}
 	}
+	string key;
+	if (DB_CACHE_ENABLED && !files.empty()) {
+		try {
+			key = cacheKey(files);
+			if (loadCache(key)) {
+				loadTime = Timer::getTime() - startTime;
+				fromCache = true;
+				return;
+			}
+		} catch (MSXException& /*e*/) {
+			// Ignore, probably there's no cache yet.
+		}
+	}
+
 	buffer.resize(bufferSize);
 	size_t bufferOffset = 0;
-	for (auto& file : files) {
+	bool parseOk = true;
+	unsigned numWarnings = 0;
+	for (auto& f : files) {
+		auto& file = f.second;
 		try {
 			auto size = file.getSize();
 			auto* buf = &buffer[bufferOffset];
@@ -589,15 +722,19 @@ RomDatabase::RomDatabase(CliComm& cliComm)
 			file.read(buf, size);
 			buf[size] = 0;
 
-			parseDB(cliComm, buf, buffer.data(), db, unknownTypes);
+			parseDB(cliComm, numWarnings, buf, buffer.data(), db,
+			        unknownTypes);
 		} catch (rapidsax::ParseError& e) {
 			cliComm.printWarning(
 				"Rom database parsing failed: ", e.what());
+			parseOk = false;
 		} catch (MSXException& /*e*/) {
 			// Ignore, see above
+			parseOk = false;
 		}
 	}
 	if (bufferSize) buffer[0] = 0;
+	bufferStart = buffer.data();
 	if (db.empty()) {
 		cliComm.printWarning(
 			"Couldn't load software database.\n"
@@ -610,6 +747,14 @@ RomDatabase::RomDatabase(CliComm& cliComm)
 		}
 		cliComm.printWarning(output);
 	}
+	// Don't cache a database that gives warnings, those should be shown
+	// again the next time.
+	if (DB_CACHE_ENABLED && !key.empty() && parseOk && !db.empty() &&
+	    unknownTypes.empty() && (numWarnings == 0)) {
+		storeCache(key, bufferSize);
+	}
+	loadTime = Timer::getTime() - startTime;
+	fromCache = false;
 }
 
 const RomInfo* RomDatabase::fetchRomInfo(const Sha1Sum& sha1sum) const
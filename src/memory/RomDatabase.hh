@@ -1,8 +1,11 @@
 #ifndef ROMDATABASE_HH
 #define ROMDATABASE_HH
 
+#include "File.hh"
 #include "MemBuffer.hh"
 #include "sha1.hh"
+#include <cstdint>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -23,11 +26,23 @@ public:
 	 */
 	const RomInfo* fetchRomInfo(const Sha1Sum& sha1sum) const;
 
-	const char* getBufferStart() const { return buffer.data(); }
+	const char* getBufferStart() const { return bufferStart; }
+
+	/** Time (in us) it took to load the database. */
+	uint64_t getLoadTime() const { return loadTime; }
+	/** Was the database loaded from the binary cache? */
+	bool isFromCache() const { return fromCache; }
 
 private:
+	bool loadCache(const std::string& key);
+	void storeCache(const std::string& key, size_t bufferSize) const;
+
 	RomDB db;
 	MemBuffer<char> buffer;
+	File cacheFile; // mapped, when loaded from the cache
+	const char* bufferStart;
+	uint64_t loadTime;
+	bool fromCache;
 };
 
 } // namespace openmsx
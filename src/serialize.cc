@@ -10,10 +10,14 @@
 #include "FileOperations.hh"
 #include "Version.hh"
 #include "Date.hh"
+#include "ThreadPool.hh"
 #include "stl.hh"
 #include "cstdiop.hh" // for dup()
+#include <algorithm>
 #include <cstring>
+#include <future>
 #include <limits>
+#include <new>
 
 using std::string;
 
@@ -37,8 +41,8 @@ unsigned OutputArchiveBase2::generateID1(const void* p)
 	       !addressOnStack(p));
 	#endif
 	++lastId;
-	assert(!polyIdMap.count(p)); // c++20 contains()
-	polyIdMap[p] = lastId;
+	assert(!polyIdMap.contains(p));
+	polyIdMap.emplace_noDuplicateCheck(p, lastId);
 	return lastId;
 }
 unsigned OutputArchiveBase2::generateID2(
@@ -50,8 +54,8 @@ unsigned OutputArchiveBase2::generateID2(
 	#endif
 	++lastId;
 	auto key = std::make_pair(p, std::type_index(typeInfo));
-	assert(!idMap.count(key)); // c++20 contains()
-	idMap[key] = lastId;
+	assert(!idMap.contains(key));
+	idMap.emplace_noDuplicateCheck(key, lastId);
 	return lastId;
 }
 
@@ -68,41 +72,6 @@ unsigned OutputArchiveBase2::getID2(
 }
 
 
-template<typename Derived>
-void OutputArchiveBase<Derived>::serialize_blob(
-	const char* tag, const void* data_, size_t len, bool /*diff*/)
-{
-	auto* data = static_cast<const uint8_t*>(data_);
-
-	string encoding;
-	string tmp;
-	if (false) {
-		// useful for debugging
-		encoding = "hex";
-		tmp = HexDump::encode(data, len);
-	} else if (false) {
-		encoding = "base64";
-		tmp = Base64::encode(data, len);
-	} else {
-		encoding = "gz-base64";
-		// TODO check for overflow?
-		auto dstLen = uLongf(len + len / 1000 + 12 + 1); // worst-case
-		MemBuffer<byte> buf(dstLen);
-		if (compress2(buf.data(), &dstLen,
-		              reinterpret_cast<const Bytef*>(data),
-		              uLong(len), 9)
-		    != Z_OK) {
-			throw MSXException("Error while compressing blob.");
-		}
-		tmp = Base64::encode(buf.data(), dstLen);
-	}
-	this->self().beginTag(tag);
-	this->self().attribute("encoding", encoding);
-	Saver<string> saver;
-	saver(this->self(), tmp, false);
-	this->self().endTag(tag);
-}
-
 template class OutputArchiveBase<MemOutputArchive>;
 template class OutputArchiveBase<XmlOutputArchive>;
 
@@ -116,50 +85,22 @@ void* InputArchiveBase2::getPointer(unsigned id)
 
 void InputArchiveBase2::addPointer(unsigned id, const void* p)
 {
-	assert(!idMap.count(id)); // c++20 contains()
-	idMap[id] = const_cast<void*>(p);
-}
-
-unsigned InputArchiveBase2::getId(const void* ptr) const
-{
-	for (const auto& p : idMap) {
-		if (p.second == ptr) return p.first;
+	assert(!idMap.contains(id));
+	idMap.emplace_noDuplicateCheck(id, const_cast<void*>(p));
+	// Different IDs can refer to the same address (e.g. an object and its
+	// first member), getId() returns the lowest of those.
+	auto it = pointerMap.find(p);
+	if (it == end(pointerMap)) {
+		pointerMap.emplace_noDuplicateCheck(p, id);
+	} else if (id < it->second) {
+		it->second = id;
 	}
-	return 0;
 }
 
-template<typename Derived>
-void InputArchiveBase<Derived>::serialize_blob(
-	const char* tag, void* data, size_t len, bool /*diff*/)
+unsigned InputArchiveBase2::getId(const void* ptr) const
 {
-	this->self().beginTag(tag);
-	string encoding;
-	this->self().attribute("encoding", encoding);
-
-	string_view tmp = this->self().loadStr();
-	this->self().endTag(tag);
-
-	if (encoding == "gz-base64") {
-		auto p = Base64::decode(tmp);
-		auto dstLen = uLongf(len); // TODO check for overflow?
-		if ((uncompress(reinterpret_cast<Bytef*>(data), &dstLen,
-		                reinterpret_cast<const Bytef*>(p.first.data()), uLong(p.second))
-		     != Z_OK) ||
-		    (dstLen != len)) {
-			throw MSXException("Error while decompressing blob.");
-		}
-	} else if ((encoding == "hex") || (encoding == "base64")) {
-		bool ok = (encoding == "hex")
-		        ? HexDump::decode_inplace(tmp, static_cast<uint8_t*>(data), len)
-		        : Base64 ::decode_inplace(tmp, static_cast<uint8_t*>(data), len);
-		if (!ok) {
-			throw XMLException(
-				"Length of decoded blob different from "
-				"expected value (", len, ')');
-		}
-	} else {
-		throw XMLException("Unsupported encoding \"", encoding, "\" for blob");
-	}
+	auto v = lookup(pointerMap, ptr);
+	return v ? *v : 0;
 }
 
 template class InputArchiveBase<MemInputArchive>;
@@ -250,9 +191,78 @@ void MemInputArchive::serialize_blob(const char* /*tag*/, void* data,
 
 ////
 
-XmlOutputArchive::XmlOutputArchive(const string& filename)
+// Blobs smaller than this are (de)compressed right away, for those it's not
+// worth to hand them over to another thread.
+static const size_t PARALLEL_BLOB_SIZE = 16 * 1024;
+
+struct EncodedBlob
+{
+	const char* encoding;
+	string data;
+};
+
+static EncodedBlob encodeBlob(const uint8_t* data, size_t len, int level)
+{
+	if (false) {
+		// useful for debugging
+		return {"hex", HexDump::encode(data, len)};
+	}
+	// TODO check for overflow?
+	auto dstLen = uLongf(len + len / 1000 + 12 + 1); // worst-case
+	MemBuffer<byte> buf(dstLen);
+	if (compress2(buf.data(), &dstLen,
+	              reinterpret_cast<const Bytef*>(data),
+	              uLong(len), level)
+	    != Z_OK) {
+		// Only happens when running out of memory. This may run on a
+		// helper thread, so don't throw, an uncompressed blob is
+		// still valid.
+		return {"base64", Base64::encode(data, len)};
+	}
+	return {"gz-base64", Base64::encode(buf.data(), dstLen)};
+}
+
+// Decode a "gz-base64" blob, 'expected' is the length stored in the
+// savestate. The savestate may be corrupt, so never decode more than that.
+static std::pair<MemBuffer<uint8_t>, size_t> decodeBlob(
+	string_view encoded, size_t expected)
+{
+	auto p = Base64::decode(encoded);
+	// deflate can't compress better than about 1:1032
+	if (expected > 1032 * p.second + 1024) {
+		throw MSXException("Error while decompressing blob.");
+	}
+	MemBuffer<uint8_t> result;
+	try {
+		result.resize(expected);
+	} catch (std::bad_alloc&) {
+		throw MSXException("Error while decompressing blob.");
+	}
+	auto dstLen = uLongf(expected);
+	if ((uncompress(result.data(), &dstLen, p.first.data(), uLong(p.second))
+	     != Z_OK) ||
+	    (dstLen != expected)) {
+		throw MSXException("Error while decompressing blob.");
+	}
+	return {std::move(result), dstLen};
+}
+
+class XmlOutputArchive::BlobEncoder
+{
+public:
+	struct Pending {
+		std::vector<size_t> path; // child indices, starting from 'root'
+		std::future<EncodedBlob> result;
+	};
+	ThreadPool pool;
+	std::vector<Pending> pending;
+};
+
+XmlOutputArchive::XmlOutputArchive(const string& filename, int compressionLevel_)
 	: root("serial")
+	, compressionLevel(compressionLevel_)
 {
+	assert((0 <= compressionLevel) && (compressionLevel <= 9));
 	root.addAttribute("openmsx_version", Version::full());
 	root.addAttribute("date_time", Date::toString(time(nullptr)));
 	root.addAttribute("platform", TARGET_PLATFORM);
@@ -261,9 +271,9 @@ XmlOutputArchive::XmlOutputArchive(const string& filename)
 		if (!f) goto error;
 		int duped_fd = dup(fileno(f.get()));
 		if (duped_fd == -1) goto error;
-		file = gzdopen(duped_fd, "wb9");
+		file = gzdopen(duped_fd, strCat("wb", compressionLevel).c_str());
 		if (!file) {
-			close(duped_fd);
+			::close(duped_fd);
 			goto error;
 		}
 		current.push_back(&root);
@@ -276,9 +286,23 @@ error:
 	throw XMLException("Could not open compressed file \"", filename, "\"");
 }
 
-XmlOutputArchive::~XmlOutputArchive()
+void XmlOutputArchive::close()
 {
+	assert(file);
 	assert(current.back() == &root);
+	if (blobEncoder) {
+		// Put the encoded blobs in the tree. Only now the tree doesn't
+		// change anymore, so only now we can use pointers to elements.
+		for (auto& p : blobEncoder->pending) {
+			XMLElement* elem = &root;
+			for (auto i : p.path) {
+				elem = const_cast<XMLElement*>(&elem->getChildren()[i]);
+			}
+			auto blob = p.result.get();
+			elem->addAttribute("encoding", blob.encoding);
+			elem->setData(blob.data);
+		}
+	}
 	const char* header =
 	    "<?xml version=\"1.0\" ?>\n"
 	    "<!DOCTYPE openmsx-serialize SYSTEM 'openmsx-serialize.dtd'>\n";
@@ -286,6 +310,18 @@ XmlOutputArchive::~XmlOutputArchive()
 	string dump = root.dump();
 	gzwrite(file, const_cast<char*>(dump.data()), unsigned(dump.size()));
 	gzclose(file);
+	file = nullptr;
+}
+
+XmlOutputArchive::~XmlOutputArchive()
+{
+	if (file) {
+		// close() wasn't called (or failed), e.g. because serializing
+		// threw. Don't collect the blob results here, that could throw
+		// as well. Destroying the thread pool waits for the running
+		// encoders.
+		gzclose(file);
+	}
 }
 
 void XmlOutputArchive::saveChar(char c)
@@ -344,6 +380,40 @@ void XmlOutputArchive::attribute(const char* name, unsigned u)
 	attributeImpl(name, u);
 }
 
+void XmlOutputArchive::serialize_blob(
+	const char* tag, const void* data_, size_t len, bool /*diff*/)
+{
+	auto* data = static_cast<const uint8_t*>(data_);
+	beginTag(tag);
+	if (len < PARALLEL_BLOB_SIZE) {
+		auto blob = encodeBlob(data, len, compressionLevel);
+		attribute("encoding", blob.encoding);
+		save(blob.data);
+	} else {
+		// Lets the loader decode this blob before it knows its size.
+		attribute("length", unsigned(len));
+		if (!blobEncoder) blobEncoder = std::make_unique<BlobEncoder>();
+		// Elements can still move when siblings are added, so
+		// remember the position of this element in the tree.
+		std::vector<size_t> path;
+		for (size_t i = 1; i < current.size(); ++i) {
+			path.push_back(current[i] -
+			               current[i - 1]->getChildren().data());
+		}
+		// The caller may change or free the data as soon as we
+		// return, so work on a copy.
+		MemBuffer<uint8_t> copy(len);
+		memcpy(copy.data(), data, len);
+		int level = compressionLevel;
+		blobEncoder->pending.push_back({std::move(path),
+			blobEncoder->pool.enqueue(
+				[copy = std::move(copy), len, level] {
+					return encodeBlob(copy.data(), len, level);
+				})});
+	}
+	endTag(tag);
+}
+
 void XmlOutputArchive::beginTag(const char* tag)
 {
 	assert(!current.empty());
@@ -359,10 +429,96 @@ void XmlOutputArchive::endTag(const char* tag)
 
 ////
 
+class XmlInputArchive::BlobDecoder
+{
+public:
+	ThreadPool pool;
+	std::map<const XMLElement*,
+	         std::future<std::pair<MemBuffer<uint8_t>, size_t>>> blobs;
+};
+
+// Only the blobs of which the (uncompressed) length is stored, older
+// savestates don't have that.
+static void collectBlobs(const XMLElement& elem,
+                         std::vector<std::pair<const XMLElement*, unsigned>>& result)
+{
+	unsigned length;
+	if ((elem.getData().size() >= PARALLEL_BLOB_SIZE) &&
+	    (elem.getAttribute("encoding", {}) == "gz-base64") &&
+	    elem.findAttributeInt("length", length)) {
+		result.emplace_back(&elem, length);
+	}
+	for (auto& c : elem.getChildren()) collectBlobs(c, result);
+}
+
 XmlInputArchive::XmlInputArchive(const string& filename)
 	: rootElem(XMLLoader::load(filename, "openmsx-serialize.dtd"))
 {
 	elems.emplace_back(&rootElem, 0);
+
+	// Start decoding the large blobs in parallel, while the rest of the
+	// state is being loaded.
+	std::vector<std::pair<const XMLElement*, unsigned>> largeBlobs;
+	collectBlobs(rootElem, largeBlobs);
+	if (largeBlobs.empty()) return;
+	blobDecoder = std::make_unique<BlobDecoder>();
+	for (auto& b : largeBlobs) {
+		string_view encoded = b.first->getData();
+		size_t length = b.second;
+		blobDecoder->blobs.emplace(b.first, blobDecoder->pool.enqueue(
+			[encoded, length] { return decodeBlob(encoded, length); }));
+	}
+}
+
+XmlInputArchive::~XmlInputArchive() = default;
+
+void XmlInputArchive::serialize_blob(
+	const char* tag, void* data, size_t len, bool /*diff*/)
+{
+	beginTag(tag);
+	string encoding;
+	attribute("encoding", encoding);
+	const XMLElement* elem = elems.back().first;
+	string_view tmp = loadStr();
+	endTag(tag);
+
+	if (encoding == "gz-base64") {
+		if (blobDecoder) {
+			auto it = blobDecoder->blobs.find(elem);
+			if (it != end(blobDecoder->blobs)) {
+				auto result = std::move(it->second);
+				blobDecoder->blobs.erase(it);
+				try {
+					auto p = result.get();
+					if (p.second == len) {
+						memcpy(data, p.first.data(), len);
+						return;
+					}
+				} catch (MSXException&) {
+					// handled below
+				}
+			}
+		}
+		auto p = Base64::decode(tmp);
+		auto dstLen = uLongf(len); // TODO check for overflow?
+		if ((uncompress(reinterpret_cast<Bytef*>(data), &dstLen,
+		                reinterpret_cast<const Bytef*>(p.first.data()), uLong(p.second))
+		     != Z_OK) ||
+		    (dstLen != len)) {
+			throw MSXException("Error while decompressing blob.");
+		}
+	} else if ((encoding == "hex") || (encoding == "base64")) {
+		bool ok = (encoding == "hex")
+		        ? HexDump::decode_inplace(tmp, static_cast<uint8_t*>(data), len)
+		        : Base64 ::decode_inplace(tmp, static_cast<uint8_t*>(data), len);
+		if (!ok) {
+			throw XMLException(
+				"Length of decoded blob different from "
+				"expected value (", len, ')');
+		}
+	} else {
+		throw XMLException("Unsupported encoding \"", encoding, "\" for blob");
+	}
 }
 
 string_view XmlInputArchive::loadStr()
@@ -5,6 +5,7 @@
 #include "SerializeBuffer.hh"
 #include "XMLElement.hh"
 #include "MemBuffer.hh"
+#include "hash_map.hh"
 #include "inline.hh"
 #include "strCat.hh"
 #include "unreachable.hh"
@@ -325,6 +326,21 @@ protected:
 	}
 };
 
+// Hash functions for the pointer <-> ID maps in the archives. Pointers are
+// aligned, so the low bits carry little information: use the upper half of a
+// multiplicative (Fibonacci) hash instead.
+struct HashPointer {
+	uint32_t operator()(const void* p) const {
+		auto x = uint64_t(reinterpret_cast<uintptr_t>(p));
+		return uint32_t((x * 0x9E3779B97F4A7C15ull) >> 32);
+	}
+};
+struct HashPointerType {
+	uint32_t operator()(const std::pair<const void*, std::type_index>& k) const {
+		return HashPointer()(k.first) ^ uint32_t(k.second.hash_code());
+	}
+};
+
 // The part of OutputArchiveBase that doesn't depend on the template parameter
 class OutputArchiveBase2
 {
@@ -402,8 +418,8 @@ private:
 	unsigned getID1(const void* p);
 	unsigned getID2(const void* p, const std::type_info& typeInfo);
 
-	std::map<std::pair<const void*, std::type_index>, unsigned> idMap;
-	std::map<const void*, unsigned> polyIdMap;
+	hash_map<std::pair<const void*, std::type_index>, unsigned, HashPointerType> idMap;
+	hash_map<const void*, unsigned, HashPointer> polyIdMap;
 	unsigned lastId = 0;
 };
 
@@ -435,11 +451,6 @@ public:
 		this->self().endTag(tag);
 	}
 
-	// Default implementation is to base64-encode the blob and serialize
-	// the resulting string. But memory archives will memcpy the blob.
-	void serialize_blob(const char* tag, const void* data, size_t len,
-	                    bool diff = true);
-
 	template<typename T> void serialize(const char* tag, const T& t)
 	{
 		this->self().beginTag(tag);
@@ -519,8 +530,9 @@ protected:
 	InputArchiveBase2() = default;
 
 private:
-	std::map<unsigned, void*> idMap;
-	std::map<void*, std::shared_ptr<void>> sharedPtrMap;
+	hash_map<unsigned, void*> idMap;
+	hash_map<const void*, unsigned, HashPointer> pointerMap; // reverse of 'idMap'
+	hash_map<void*, std::shared_ptr<void>, HashPointer> sharedPtrMap;
 };
 
 template<typename Derived>
@@ -532,8 +544,6 @@ public:
 	{
 		doSerialize(tag, t, std::tuple<Args...>(args...));
 	}
-	void serialize_blob(const char* tag, void* data, size_t len,
-	                    bool diff = true);
 
 	template<typename T>
 	void serialize(const char* tag, T& t)
@@ -719,9 +729,20 @@ private:
 class XmlOutputArchive final : public OutputArchiveBase<XmlOutputArchive>
 {
 public:
-	explicit XmlOutputArchive(const std::string& filename);
+	/** @param compressionLevel zlib compression level (0-9) for the blobs
+	  *   and for the file as a whole.
+	  */
+	explicit XmlOutputArchive(const std::string& filename,
+	                          int compressionLevel = 9);
+	/** Without a call to close() nothing is written to the file. */
 	~XmlOutputArchive();
 
+	/** Collects the encoded blobs and writes the file. Must be called
+	  * after the last serialize() call. Errors (e.g. of the blob
+	  * encoders) are thrown from here, not from the destructor.
+	  */
+	void close();
+
 	template <typename T> void saveImpl(const T& t)
 	{
 		// TODO make sure floating point is printed with enough digits
@@ -742,6 +763,13 @@ public:
 	void save(unsigned u);             // but having them non-inline
 	void save(unsigned long long ull); // saves quite a bit of code
 
+	/** The blob is compressed and base64-encoded. Large blobs are
+	  * encoded in parallel (on a thread pool), the results are put in
+	  * the XML tree in close().
+	  */
+	void serialize_blob(const char* tag, const void* data, size_t len,
+	                    bool diff = true);
+
 	void beginSection() { /*nothing*/ }
 	void endSection()   { /*nothing*/ }
 
@@ -766,15 +794,20 @@ public:
 	void attribute(const char* name, unsigned u);
 
 private:
+	class BlobEncoder;
+
 	gzFile file;
 	XMLElement root;
 	std::vector<XMLElement*> current;
+	std::unique_ptr<BlobEncoder> blobEncoder;
+	int compressionLevel;
 };
 
 class XmlInputArchive final : public InputArchiveBase<XmlInputArchive>
 {
 public:
 	explicit XmlInputArchive(const std::string& filename);
+	~XmlInputArchive();
 
 	inline bool versionAtLeast(unsigned actual, unsigned required) const
 	{
@@ -803,6 +836,13 @@ public:
 	void load(std::string& t);
 	string_view loadStr();
 
+	/** Large compressed blobs are already decoded in parallel (on a
+	  * thread pool) when the archive is opened, for those this only picks
+	  * up the result.
+	  */
+	void serialize_blob(const char* tag, void* data, size_t len,
+	                    bool diff = true);
+
 	void skipSection(bool /*skip*/) { /*nothing*/ }
 
 //internal:
@@ -833,8 +873,12 @@ public:
 	int countChildren() const;
 
 private:
+	class BlobDecoder;
+
 	XMLElement rootElem;
 	std::vector<std::pair<const XMLElement*, size_t>> elems;
+	// must be destroyed before 'rootElem', it reads from it
+	std::unique_ptr<BlobDecoder> blobDecoder;
 };
 
 #define INSTANTIATE_SERIALIZE_METHODS(CLASS) \
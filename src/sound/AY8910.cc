@@ -566,6 +566,7 @@ byte AY8910::peekRegister(unsigned reg, EmuTime::param time) const
 void AY8910::writeRegister(unsigned reg, byte value, EmuTime::param time)
 {
 	if (reg >= 16) return;
+	if (reg < AY_PORTA) logWrite(SoundChipLogger::PSG, 0, reg, value, time);
 	if ((reg < AY_PORTA) && (reg == AY_ESHAPE || regs[reg] != value)) {
 		// Update the output buffer before changing the register.
 		updateStream(time);
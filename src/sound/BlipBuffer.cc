@@ -6,6 +6,9 @@
 #include <cstring>
 #include <cassert>
 #include <iostream>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 namespace openmsx {
 
@@ -134,6 +137,54 @@ void BlipBuffer::addDelta(TimeIndex time, int delta)
 	}
 }
 
+#ifdef __SSE2__
+// Low 32 bits of the products of 4 (signed) integers with the same value.
+// SSE2 has no instruction for this (pmulld is SSE4.1).
+static inline __m128i mulLo(__m128i a, __m128i b)
+{
+	__m128i even = _mm_mul_epu32(a, b);
+	__m128i odd  = _mm_mul_epu32(_mm_srli_epi64(a, 32), b);
+	return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+	                          _mm_shuffle_epi32(odd,  _MM_SHUFFLE(0, 0, 2, 0)));
+}
+#endif
+
+void BlipBuffer::addDeltas(const TimeIndex* times, const int* deltas, unsigned num)
+{
+	if (num == 0) return;
+	assert(std::is_sorted(times, times + num));
+	unsigned last = times[num - 1].toInt() + BLIP_IMPULSE_WIDTH;
+	assert(last < BUFFER_SIZE);
+	availSamp = std::max<int>(availSamp, last);
+
+	if (unlikely((offset + last) > BUFFER_SIZE)) {
+		// (some of) the impulses wrap around the end of the buffer
+		for (unsigned j = 0; j < num; ++j) {
+			addDelta(times[j], deltas[j]);
+		}
+		return;
+	}
+	int* buf = &buffer[offset];
+	for (unsigned j = 0; j < num; ++j) {
+		const int* imp = impulses.a[times[j].fractAsInt()];
+		int* b = buf + times[j].toInt();
+#ifdef __SSE2__
+		static_assert((BLIP_IMPULSE_WIDTH % 4) == 0, "");
+		__m128i d = _mm_set1_epi32(deltas[j]);
+		for (int i = 0; i < BLIP_IMPULSE_WIDTH; i += 4) {
+			auto* p = reinterpret_cast<__m128i*>(b + i);
+			__m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(imp + i));
+			_mm_storeu_si128(p, _mm_add_epi32(_mm_loadu_si128(p), mulLo(x, d)));
+		}
+#else
+		int delta = deltas[j];
+		for (int i = 0; i < BLIP_IMPULSE_WIDTH; ++i) {
+			b[i] += imp[i] * delta;
+		}
+#endif
+	}
+}
+
 static const int SAMPLE_SHIFT = BLIP_SAMPLE_BITS - 16;
 static const int BASS_SHIFT = 9;
 
@@ -150,12 +201,13 @@ void BlipBuffer::readSamplesHelper(int* __restrict out, unsigned samples) __rest
 		//  code used 'acc / (1<< BASS_SHIFT)' to avoid this,
 		//  but it generates less efficient code.
 		acc -= (acc >> BASS_SHIFT);
-		acc += buffer[ofst];
-		buffer[ofst] = 0;
-		++ofst;
+		acc += buffer[ofst + i];
 	}
+	// clearing in a separate (vectorized) pass is faster than clearing
+	// each element in the (serial) loop above
+	memset(&buffer[ofst], 0, samples * sizeof(int));
 	accum = acc;
-	offset = ofst & BUFFER_MASK;
+	offset = (ofst + samples) & BUFFER_MASK;
 }
 
 template <unsigned PITCH>
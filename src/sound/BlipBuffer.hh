@@ -26,6 +26,10 @@ public:
 	// units and since the last time readSamples() was called.
 	void addDelta(TimeIndex time, int delta);
 
+	// Same as calling addDelta() for each (time, delta) pair, but faster.
+	// The times must be in increasing order.
+	void addDeltas(const TimeIndex* times, const int* deltas, unsigned num);
+
 	// Read the given amount of samples into destination buffer.
 	template <unsigned PITCH>
 	bool readSamples(int* out, unsigned samples);
@@ -1,6 +1,7 @@
 #include "MSXMixer.hh"
 #include "Mixer.hh"
 #include "SoundDevice.hh"
+#include "WavWriter.hh"
 #include "MSXMotherBoard.hh"
 #include "MSXCommandController.hh"
 #include "TclObject.hh"
@@ -47,6 +48,7 @@ MSXMixer::MSXMixer(Mixer& mixer_, MSXMotherBoard& motherBoard_,
 	, throttleManager(globalSettings.getThrottleManager())
 	, prevTime(getCurrentTime(), 44100)
 	, soundDeviceInfo(commandController.getMachineInfoCommand())
+	, chipLogger(motherBoard, *this)
 	, recorder(nullptr)
 	, synchronousCounter(0)
 {
@@ -172,6 +174,17 @@ void MSXMixer::updateStream(EmuTime::param time)
 	unsigned count = prevTime.getTicksTill(time);
 	assert(count <= 8192);
 
+	if (motherBoard.isFastForwarding() && !recorder) {
+		// Nobody listens (the mixer is muted while fast-forwarding),
+		// only advance the state that's visible to the MSX.
+		assert(muteCount);
+		for (auto& info : infos) {
+			info.device->skipBuffer(count, time);
+		}
+		prevTime += count;
+		return;
+	}
+
 	// call generate() even if count==0 and even if muted
 	generate(mixBuffer, time, count);
 
@@ -180,7 +193,7 @@ void MSXMixer::updateStream(EmuTime::param time)
 	}
 
 	if (recorder) {
-		recorder->addWave(count, mixBuffer);
+		recorder->addWave(count, mixBuffer, time);
 	}
 
 	prevTime += count;
@@ -777,6 +790,28 @@ void MSXMixer::SoundDeviceInfoTopic::execute(
 		result = device->getDescription();
 		break;
 	}
+	case 4: {
+		SoundDevice* device = msxMixer.findDevice(tokens[2].getString());
+		if (!device) {
+			throw CommandException("Unknown sound device");
+		}
+		if (tokens[3].getString() != "record") {
+			throw CommandException("Unknown subtopic, expected 'record'");
+		}
+		// status of the recorded channels (numbered from 1, like the
+		// channel settings)
+		for (unsigned i = 0; i < device->getNumChannels(); ++i) {
+			if (auto* rec = device->getChannelRecorder(i)) {
+				TclObject status;
+				status.addDictKeyValue("overruns", int(rec->getOverruns()));
+				if (!rec->getError().empty()) {
+					status.addDictKeyValue("error", rec->getError());
+				}
+				result.addDictKeyValue(int(i + 1), status);
+			}
+		}
+		break;
+	}
 	default:
 		throw CommandException("Too many parameters");
 	}
@@ -784,7 +819,10 @@ void MSXMixer::SoundDeviceInfoTopic::execute(
 
 string MSXMixer::SoundDeviceInfoTopic::help(const vector<string>& /*tokens*/) const
 {
-	return "Shows a list of available sound devices.\n";
+	return "Shows a list of available sound devices.\n"
+	       "machine_info sounddevice <device>          show description\n"
+	       "machine_info sounddevice <device> record   status of the "
+	       "recorded channels\n";
 }
 
 void MSXMixer::SoundDeviceInfoTopic::tabCompletion(vector<string>& tokens) const
@@ -794,6 +832,9 @@ void MSXMixer::SoundDeviceInfoTopic::tabCompletion(vector<string>& tokens) const
 			OUTER(MSXMixer, soundDeviceInfo).infos,
 			[](auto& info) { return info.device->getName(); }));
 		completeString(tokens, devices);
+	} else if (tokens.size() == 4) {
+		static const char* const subtopics[] = { "record" };
+		completeString(tokens, subtopics);
 	}
 }
 
@@ -4,6 +4,7 @@
 #include "Schedulable.hh"
 #include "Observer.hh"
 #include "InfoTopic.hh"
+#include "SoundChipLogger.hh"
 #include "EmuTime.hh"
 #include "DynamicClock.hh"
 #include <cstdint>
@@ -111,6 +112,11 @@ public:
 	unsigned getSampleRate() const { return hostSampleRate; }
 
 	SoundDevice* findDevice(string_view name) const;
+	template<typename F> void forEachDevice(F f) const {
+		for (auto& info : infos) f(*info.device);
+	}
+
+	SoundChipLogger& getChipLogger() { return chipLogger; }
 
 	void reInit();
 
@@ -169,6 +175,8 @@ private:
 		void tabCompletion(std::vector<std::string>& tokens) const override;
 	} soundDeviceInfo;
 
+	SoundChipLogger chipLogger;
+
 	AviRecorder* recorder;
 	unsigned synchronousCounter;
 
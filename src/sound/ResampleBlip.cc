@@ -35,6 +35,10 @@ bool ResampleBlip<CHANNELS>::generateOutput(int* dataOut, unsigned hostNum,
 		if (input.generateInput(buf, emuNum)) {
 			FP pos1;
 			hostClock.getTicksTill(emu1, pos1);
+			// the transitions of one channel are collected and passed
+			// to the BlipBuffer in one go
+			VLA(BlipBuffer::TimeIndex, times, emuNum);
+			VLA(int, deltas, emuNum);
 			for (unsigned ch = 0; ch < CHANNELS; ++ch) {
 				// In case of PSG (and to a lesser degree SCC) it happens
 				// very often that two consecutive samples have the same
@@ -46,6 +50,7 @@ bool ResampleBlip<CHANNELS>::generateOutput(int* dataOut, unsigned hostNum,
 					buf[CHANNELS * (emuNum - 1) + ch] + 1;
 				FP pos = pos1;
 				int last = lastInput[ch]; // local var is slightly faster
+				unsigned num = 0;
 				for (unsigned i = 0; /**/; ++i) {
 					int delta = buf[CHANNELS * i + ch] - last;
 					if (unlikely(delta != 0)) {
@@ -53,12 +58,13 @@ bool ResampleBlip<CHANNELS>::generateOutput(int* dataOut, unsigned hostNum,
 							break;
 						}
 						last = buf[CHANNELS * i + ch];
-						blip[ch].addDelta(
-							BlipBuffer::TimeIndex(pos),
-							delta);
+						times[num] = BlipBuffer::TimeIndex(pos);
+						deltas[num] = delta;
+						++num;
 					}
 					pos += step;
 				}
+				blip[ch].addDeltas(times, deltas, num);
 				lastInput[ch] = last;
 			}
 		} else {
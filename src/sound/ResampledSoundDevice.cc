@@ -19,6 +19,7 @@ ResampledSoundDevice::ResampledSoundDevice(
 		bool stereo_)
 	: SoundDevice(motherBoard.getMSXMixer(), name_, description_, channels, stereo_)
 	, resampleSetting(motherBoard.getReactor().getGlobalSettings().getResampleSetting())
+	, skipClock(EmuTime::zero)
 {
 	resampleSetting.attach(*this);
 }
@@ -37,9 +38,31 @@ void ResampledSoundDevice::setOutputRate(unsigned /*sampleRate*/)
 bool ResampledSoundDevice::updateBuffer(unsigned length, int* buffer,
                                         EmuTime::param time)
 {
+	if (!algo) {
+		// done skipping
+		createResampler();
+	}
 	return algo->generateOutput(buffer, length, time);
 }
 
+void ResampledSoundDevice::skipBuffer(unsigned length, EmuTime::param time)
+{
+	if (isRecordingChannels()) {
+		SoundDevice::skipBuffer(length, time);
+		return;
+	}
+	if (algo) {
+		// Start skipping. Drop the resampler (its history is useless
+		// after skipping anyway), updateBuffer() creates a new one.
+		algo.reset();
+		skipClock.reset(getHostSampleClock().getTime());
+		skipClock.setFreq(unsigned(getInputRate() / getEffectiveSpeed()));
+	}
+	unsigned num = skipClock.getTicksTill(time);
+	skipChannels(num);
+	skipClock += num;
+}
+
 bool ResampledSoundDevice::generateInput(int* buffer, unsigned num)
 {
 	return mixChannels(buffer, num);
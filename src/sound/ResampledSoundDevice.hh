@@ -2,6 +2,7 @@
 #define RESAMPLEDSOUNDDEVICE_HH
 
 #include "SoundDevice.hh"
+#include "DynamicClock.hh"
 #include "Observer.hh"
 #include <memory>
 
@@ -33,6 +34,7 @@ protected:
 	void setOutputRate(unsigned sampleRate) override;
 	bool updateBuffer(unsigned length, int* buffer,
 	                  EmuTime::param time) override;
+	void skipBuffer(unsigned length, EmuTime::param time) override;
 
 	// Observer<Setting>
 	void update(const Setting& setting) override;
@@ -41,7 +43,8 @@ protected:
 
 private:
 	EnumSetting<ResampleType>& resampleSetting;
-	std::unique_ptr<ResampleAlgo> algo;
+	std::unique_ptr<ResampleAlgo> algo; // nullptr while skipping
+	DynamicClock skipClock; // input samples, only used while skipping
 };
 
 } // namespace openmsx
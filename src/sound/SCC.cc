@@ -294,28 +294,34 @@ void SCC::writeMem(byte address, byte value, EmuTime::param time)
 	case SCC_Real:
 		if (address < 0x80) {
 			// 0x00..0x7F : write wave form 1..4
+			logWrite(SoundChipLogger::SCC, 0, address, value, time);
 			writeWave(address >> 5, address, value);
 		} else if (address < 0xA0) {
 			// 0x80..0x9F : freq volume block
+			logFreqVol(address, value, time);
 			setFreqVol(address, value, time);
 		} else if (address < 0xE0) {
 			// 0xA0..0xDF : no function
 		} else {
 			// 0xE0..0xFF : deformation register
+			logWrite(SoundChipLogger::SCC, 5, 0, value, time);
 			setDeformReg(value, time);
 		}
 		break;
 	case SCC_Compatible:
 		if (address < 0x80) {
 			// 0x00..0x7F : write wave form 1..4
+			logWrite(SoundChipLogger::SCC, 0, address, value, time);
 			writeWave(address >> 5, address, value);
 		} else if (address < 0xA0) {
 			// 0x80..0x9F : freq volume block
+			logFreqVol(address, value, time);
 			setFreqVol(address, value, time);
 		} else if (address < 0xC0) {
 			// 0xA0..0xBF : ignore write wave form 5
 		} else if (address < 0xE0) {
 			// 0xC0..0xDF : deformation register
+			logWrite(SoundChipLogger::SCC, 5, 0, value, time);
 			setDeformReg(value, time);
 		} else {
 			// 0xE0..0xFF : no function
@@ -324,12 +330,15 @@ void SCC::writeMem(byte address, byte value, EmuTime::param time)
 	case SCC_plusmode:
 		if (address < 0xA0) {
 			// 0x00..0x9F : write wave form 1..5
+			logWrite(SoundChipLogger::SCC, 4, address, value, time);
 			writeWave(address >> 5, address, value);
 		} else if (address < 0xC0) {
 			// 0xA0..0xBF : freq volume block
+			logFreqVol(address, value, time);
 			setFreqVol(address, value, time);
 		} else if (address < 0xE0) {
 			// 0xC0..0xDF : deformation register
+			logWrite(SoundChipLogger::SCC, 5, 0, value, time);
 			setDeformReg(value, time);
 		} else {
 			// 0xE0..0xFF : no function
@@ -340,6 +349,20 @@ void SCC::writeMem(byte address, byte value, EmuTime::param time)
 	}
 }
 
+void SCC::logFreqVol(unsigned address, byte value, EmuTime::param time)
+{
+	// VGM ports: 1 = frequency, 2 = volume, 3 = key on/off. The freq
+	// volume block is 16 bytes (mirrored), also in SCC+ mode.
+	unsigned offset = address & 0x0F;
+	if (offset < 0x0A) {
+		logWrite(SoundChipLogger::SCC, 1, offset, value, time);
+	} else if (offset < 0x0F) {
+		logWrite(SoundChipLogger::SCC, 2, offset - 0x0A, value, time);
+	} else {
+		logWrite(SoundChipLogger::SCC, 3, 0, value, time);
+	}
+}
+
 int SCC::getAmplificationFactorImpl() const
 {
 	return 256;
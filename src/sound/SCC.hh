@@ -39,6 +39,7 @@ private:
 	void setDeformReg(byte value, EmuTime::param time);
 	void setDeformRegHelper(byte value);
 	void setFreqVol(unsigned address, byte value, EmuTime::param time);
+	void logFreqVol(unsigned address, byte value, EmuTime::param time);
 	byte getFreqVol(unsigned address) const;
 
 	static const int CLOCK_FREQ = 3579545;
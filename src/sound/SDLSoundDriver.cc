@@ -5,6 +5,7 @@
 #include "GlobalSettings.hh"
 #include "ThrottleManager.hh"
 #include "MSXException.hh"
+#include "TclObject.hh"
 #include "Math.hh"
 #include "Timer.hh"
 #include "build-info.hh"
@@ -14,10 +15,19 @@
 
 namespace openmsx {
 
+// All sizes below are in int16_t units (so 2 per stereo sample) and are
+// expressed in 'F', the size of one SDL audio fragment.
+static const unsigned BUFFER_FRAGMENTS = 8;
+static const unsigned MAX_TARGET_FRAGMENTS = 6;
+static const unsigned WINDOW_SECONDS = 2; // to look for a lower latency
+
 SDLSoundDriver::SDLSoundDriver(Reactor& reactor_,
                                unsigned wantedFreq, unsigned wantedSamples)
 	: reactor(reactor_)
+	, underruns(0)
+	, callbacks(0)
 	, muted(true)
+	, statusInfo(reactor.getOpenMSXInfoCommand())
 {
 	SDL_AudioSpec desired;
 	desired.freq     = wantedFreq;
@@ -37,8 +47,10 @@ SDLSoundDriver::SDLSoundDriver(Reactor& reactor_,
 	frequency = obtained.freq;
 	fragmentSize = obtained.samples;
 
-	mixBufferSize = 3 * (obtained.size / sizeof(int16_t)) + 2;
+	unsigned F = 2 * fragmentSize;
+	mixBufferSize = BUFFER_FRAGMENTS * F + 2;
 	mixBuffer.resize(mixBufferSize);
+	targetFill = 2 * F; // start low, adjustLatency() raises it when needed
 	reInit();
 }
 
@@ -49,9 +61,14 @@ SDLSoundDriver::~SDLSoundDriver()
 
 void SDLSoundDriver::reInit()
 {
+	// the callback isn't running while we hold the lock
 	SDL_LockAudioDevice(deviceID);
 	readIdx  = 0;
 	writeIdx = 0;
+	primed = false;
+	minAvailable = unsigned(-1);
+	prevUnderruns = underruns;
+	windowStart = callbacks;
 	SDL_UnlockAudioDevice(deviceID);
 }
 
@@ -79,7 +96,9 @@ unsigned SDLSoundDriver::getFrequency() const
 
 unsigned SDLSoundDriver::getSamples() const
 {
-	return fragmentSize;
+	// Let the mixer produce smaller fragments than the SDL fragments, this
+	// allows a lower (and more finely tuned) target fill level.
+	return std::max(fragmentSize / 2, 1u);
 }
 
 void SDLSoundDriver::audioCallbackHelper(void* userdata, uint8_t* strm, int len)
@@ -89,40 +108,61 @@ void SDLSoundDriver::audioCallbackHelper(void* userdata, uint8_t* strm, int len)
 		audioCallback(reinterpret_cast<int16_t*>(strm), len / sizeof(int16_t));
 }
 
-unsigned SDLSoundDriver::getBufferFilled() const
+unsigned SDLSoundDriver::getBufferFilled(unsigned rdIdx, unsigned wrIdx) const
 {
-	int result = writeIdx - readIdx;
+	// We can't distinguish completely filled from completely empty (in
+	// both cases the indices are equal). That's fine because the producer
+	// never fills more than 'targetFill', which is less than the size.
+	int result = wrIdx - rdIdx;
 	if (result < 0) result += mixBufferSize;
 	assert((0 <= result) && (unsigned(result) < mixBufferSize));
 	return result;
 }
 
-unsigned SDLSoundDriver::getBufferFree() const
+double SDLSoundDriver::toMilliSeconds(unsigned len) const
 {
-	// we can't distinguish completely filled from completely empty
-	// (in both cases readIx would be equal to writeIdx), so instead
-	// we define full as '(writeIdx + 2) == readIdx' (note that index
-	// increases in steps of 2 (stereo)).
-	int result = mixBufferSize - 2 - getBufferFilled();
-	assert((0 <= result) && (unsigned(result) < mixBufferSize));
-	return result;
+	return (len / 2) * 1000.0 / frequency;
 }
 
+// Runs in the SDL audio thread.
 void SDLSoundDriver::audioCallback(int16_t* stream, unsigned len)
 {
 	assert((len & 1) == 0); // stereo
-	unsigned available = getBufferFilled();
+	unsigned rdIdx = readIdx.load(std::memory_order_relaxed);
+	unsigned wrIdx = writeIdx.load(std::memory_order_acquire);
+	unsigned available = getBufferFilled(rdIdx, wrIdx);
+
+	callbacks.store(callbacks.load(std::memory_order_relaxed) + 1,
+	                std::memory_order_relaxed);
+	if (available < len) {
+		if (primed) {
+			underruns.store(underruns.load(std::memory_order_relaxed) + 1,
+			                std::memory_order_relaxed);
+		}
+	} else {
+		primed = true;
+		// atomic min(), the producer may reset it concurrently
+		unsigned prev = minAvailable.load(std::memory_order_relaxed);
+		while ((available < prev) &&
+		       !minAvailable.compare_exchange_weak(
+				prev, available, std::memory_order_relaxed)) {
+			// 'prev' was updated, try again
+		}
+	}
+
 	unsigned num = std::min(len, available);
-	if ((readIdx + num) < mixBufferSize) {
-		memcpy(stream, &mixBuffer[readIdx], num * sizeof(int16_t));
-		readIdx += num;
+	if ((rdIdx + num) < mixBufferSize) {
+		memcpy(stream, &mixBuffer[rdIdx], num * sizeof(int16_t));
+		rdIdx += num;
 	} else {
-		unsigned len1 = mixBufferSize - readIdx;
-		memcpy(stream, &mixBuffer[readIdx], len1 * sizeof(int16_t));
+		unsigned len1 = mixBufferSize - rdIdx;
+		memcpy(stream, &mixBuffer[rdIdx], len1 * sizeof(int16_t));
 		unsigned len2 = num - len1;
 		memcpy(&stream[len1], &mixBuffer[0], len2 * sizeof(int16_t));
-		readIdx = len2;
+		rdIdx = len2;
 	}
+	readIdx.store(rdIdx, std::memory_order_release);
+
 	int missing = len - available;
 	if (missing > 0) {
 		// buffer underrun
@@ -130,40 +170,110 @@ void SDLSoundDriver::audioCallback(int16_t* stream, unsigned len)
 	}
 }
 
+void SDLSoundDriver::adjustLatency()
+{
+	unsigned F = 2 * fragmentSize;
+	unsigned minTarget = F;
+	unsigned maxTarget = MAX_TARGET_FRAGMENTS * F;
+	unsigned numUnderruns = underruns.load(std::memory_order_relaxed);
+	unsigned numCallbacks = callbacks.load(std::memory_order_relaxed);
+	if (numUnderruns != prevUnderruns) {
+		// the callback ran dry, buffer more
+		prevUnderruns = numUnderruns;
+		targetFill = std::min(targetFill + F / 2, maxTarget);
+		minAvailable.store(unsigned(-1), std::memory_order_relaxed);
+		windowStart = numCallbacks;
+	} else if ((numCallbacks - windowStart) >=
+	           (WINDOW_SECONDS * frequency / fragmentSize)) {
+		// No underruns during the last window. When the buffer never
+		// got close to running dry, give up half of the margin.
+		unsigned minAvail = minAvailable.exchange(
+			unsigned(-1), std::memory_order_relaxed);
+		if ((minAvail != unsigned(-1)) && (minAvail > F)) {
+			unsigned slack = ((minAvail - F) / 2) & ~1u; // keep it even
+			targetFill = (slack < (targetFill - minTarget))
+			           ? (targetFill - slack) : minTarget;
+		}
+		windowStart = numCallbacks;
+	}
+}
+
+// Runs in the main thread.
 void SDLSoundDriver::uploadBuffer(int16_t* buffer, unsigned len)
 {
-	SDL_LockAudioDevice(deviceID);
+	adjustLatency();
+
 	len *= 2; // stereo
-	unsigned free = getBufferFree();
+	unsigned wrIdx = writeIdx.load(std::memory_order_relaxed);
+	auto getFree = [&] {
+		unsigned filled = getBufferFilled(
+			readIdx.load(std::memory_order_acquire), wrIdx);
+		return (filled < targetFill) ? (targetFill - filled) : 0;
+	};
+	unsigned free = getFree();
 	if (len > free) {
 		if (reactor.getGlobalSettings().getThrottleManager().isThrottled()) {
 			do {
-				SDL_UnlockAudioDevice(deviceID);
 				Timer::sleep(5000); // 5ms
-				SDL_LockAudioDevice(deviceID);
 				if (MSXMotherBoard* board = reactor.getMotherBoard()) {
 					board->getRealTime().resync();
 				}
-				free = getBufferFree();
-			} while (len > free);
+				free = getFree();
+			} while ((len > free) && (free < targetFill));
+			// (2nd condition: when len > targetFill, don't wait forever)
+			len = std::min(len, free);
 		} else {
 			// drop excess samples
 			len = free;
 		}
 	}
 	assert(len <= free);
-	if ((writeIdx + len) < mixBufferSize) {
-		memcpy(&mixBuffer[writeIdx], buffer, len * sizeof(int16_t));
-		writeIdx += len;
+	if ((wrIdx + len) < mixBufferSize) {
+		memcpy(&mixBuffer[wrIdx], buffer, len * sizeof(int16_t));
+		wrIdx += len;
 	} else {
-		unsigned len1 = mixBufferSize - writeIdx;
-		memcpy(&mixBuffer[writeIdx], buffer, len1 * sizeof(int16_t));
+		unsigned len1 = mixBufferSize - wrIdx;
+		memcpy(&mixBuffer[wrIdx], buffer, len1 * sizeof(int16_t));
 		unsigned len2 = len - len1;
 		memcpy(&mixBuffer[0], &buffer[len1], len2 * sizeof(int16_t));
-		writeIdx = len2;
+		wrIdx = len2;
 	}
+	writeIdx.store(wrIdx, std::memory_order_release);
+}
 
-	SDL_UnlockAudioDevice(deviceID);
+
+// class StatusInfo
+
+SDLSoundDriver::StatusInfo::StatusInfo(InfoCommand& openMSXInfoCommand)
+	: InfoTopic(openMSXInfoCommand, "audio_status")
+{
+}
+
+void SDLSoundDriver::StatusInfo::execute(
+	span<const TclObject> /*tokens*/, TclObject& result) const
+{
+	auto& driver = OUTER(SDLSoundDriver, statusInfo);
+	unsigned filled = driver.getBufferFilled(
+		driver.readIdx .load(std::memory_order_relaxed),
+		driver.writeIdx.load(std::memory_order_relaxed));
+	unsigned F = 2 * driver.fragmentSize;
+	// latencies in milliseconds, including the SDL fragment
+	result.addDictKeyValues(
+		"underruns",      driver.underruns.load(std::memory_order_relaxed),
+		"latency",        driver.toMilliSeconds(filled + F),
+		"target_latency", driver.toMilliSeconds(driver.targetFill + F),
+		"fragment_size",  driver.fragmentSize,
+		"frequency",      driver.frequency);
+}
+
+std::string SDLSoundDriver::StatusInfo::help(
+	const std::vector<std::string>& /*tokens*/) const
+{
+	return "Returns the status of the SDL sound driver: the number of "
+	       "buffer underruns (audible as crackles), the current and the "
+	       "target latency in ms (adapts to the measured underruns), the "
+	       "size of the SDL audio fragments (in samples) and the actual "
+	       "sample frequency.";
 }
 
 } // namespace openmsx
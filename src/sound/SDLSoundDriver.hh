@@ -2,8 +2,11 @@
 #define SDLSOUNDDRIVER_HH
 
 #include "SoundDriver.hh"
+#include "InfoTopic.hh"
 #include "SDLSurfacePtr.hh"
 #include "MemBuffer.hh"
+#include "outer.hh"
+#include <atomic>
 #include <cstdint>
 #include <SDL.h>
 
@@ -11,6 +14,17 @@ namespace openmsx {
 
 class Reactor;
 
+/** The samples produced by the emulation thread (uploadBuffer()) are passed
+  * to the SDL audio callback via a single-producer/single-consumer ring
+  * buffer. The read and write index are atomics, so neither side ever has to
+  * take the SDL audio lock.
+  *
+  * The amount of buffered audio (the latency) adapts to the system: the ring
+  * is only filled up to 'targetFill'. Each underrun in the callback raises
+  * this target. When there were no underruns for a while, the target is
+  * lowered by part of the smallest margin (fill level minus what the
+  * callback needed) that was observed in that period.
+  */
 class SDLSoundDriver final : public SoundDriver
 {
 public:
@@ -30,8 +44,9 @@ public:
 
 private:
 	void reInit();
-	unsigned getBufferFilled() const;
-	unsigned getBufferFree() const;
+	unsigned getBufferFilled(unsigned readIdx, unsigned writeIdx) const;
+	void adjustLatency();
+	double toMilliSeconds(unsigned len) const;
 	static void audioCallbackHelper(void* userdata, uint8_t* strm, int len);
 	void audioCallback(int16_t* stream, unsigned len);
 
@@ -40,9 +55,31 @@ private:
 	MemBuffer<int16_t> mixBuffer;
 	unsigned mixBufferSize;
 	unsigned frequency;
-	unsigned fragmentSize;
-	unsigned readIdx, writeIdx;
+	unsigned fragmentSize; // of the SDL audio device (in stereo samples)
+
+	// Written by the producer (uploadBuffer()) only, except in reInit()
+	// (called while the callback isn't running).
+	std::atomic<unsigned> writeIdx;
+	unsigned targetFill; // in int16_t units, like the indices
+	unsigned prevUnderruns;
+	unsigned windowStart;
+
+	// Written by the consumer (audioCallback()) only, except in reInit().
+	std::atomic<unsigned> readIdx;
+	std::atomic<unsigned> underruns;
+	std::atomic<unsigned> callbacks;
+	std::atomic<unsigned> minAvailable; // producer resets it to -1
+	bool primed; // only count underruns after the buffer got filled
+
 	bool muted;
+
+	struct StatusInfo final : InfoTopic {
+		explicit StatusInfo(InfoCommand& openMSXInfoCommand);
+		void execute(span<const TclObject> tokens,
+		             TclObject& result) const override;
+		std::string help(const std::vector<std::string>& tokens) const override;
+	} statusInfo;
+
 	SDLSubSystemInitializer<SDL_INIT_AUDIO> audioInitializer;
 };
 
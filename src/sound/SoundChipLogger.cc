@@ -0,0 +1,384 @@
+#include "SoundChipLogger.hh"
+#include "MSXMixer.hh"
+#include "SoundDevice.hh"
+#include "MSXMotherBoard.hh"
+#include "MSXCommandController.hh"
+#include "CliComm.hh"
+#include "CommandException.hh"
+#include "AsyncFileWriter.hh"
+#include "File.hh"
+#include "FileContext.hh"
+#include "FileOperations.hh"
+#include "MSXException.hh"
+#include "TclObject.hh"
+#include "StringOp.hh"
+#include "endian.hh"
+#include "outer.hh"
+#include "ranges.hh"
+#include "strCat.hh"
+#include <cstdio>
+#include <cstring>
+
+using std::string;
+using std::vector;
+
+namespace openmsx {
+
+static const char* const chipNames[SoundChipLogger::NUM_CHIPS] = {
+	"PSG", "MSX-Music", "MSX-Audio", "Moonsound", "SCC", "OPM", "OPL3"
+};
+
+// VGM command bytes, for chips with a port byte this is followed by the
+// port, the register and the value, otherwise by the register and value.
+// For the YMF262 the port is part of the command (0x5E/0x5F).
+static const byte vgmCommands[SoundChipLogger::NUM_CHIPS] = {
+	0xA0, 0x51, 0x5C, 0xD0, 0xD2, 0x54, 0x5E
+};
+static bool hasPort(SoundChipLogger::Chip chip)
+{
+	return (chip == SoundChipLogger::MOONSOUND) || (chip == SoundChipLogger::SCC);
+}
+
+static const unsigned VGM_HEADER_SIZE = 0x100;
+static const unsigned VGM_SAMPLE_RATE = 44100;
+
+SoundChipLogger::SoundChipLogger(MSXMotherBoard& motherBoard_, MSXMixer& mixer_)
+	: motherBoard(motherBoard_)
+	, mixer(mixer_)
+	, startTime(EmuTime::zero)
+	, lastWriteTime(EmuTime::zero)
+	, cmd(motherBoard.getMSXCommandController())
+{
+}
+
+SoundChipLogger::~SoundChipLogger()
+{
+	if (chips) {
+		try {
+			stop(motherBoard.getCurrentTime());
+		} catch (MSXException&) {
+			// ignore
+		}
+	}
+}
+
+void SoundChipLogger::start(unsigned chipMask, bool raw_, const string& filename_)
+{
+	assert(!chips && chipMask);
+	writer = std::make_unique<AsyncFileWriter>(
+		File(filename_, File::TRUNCATE));
+	filename = filename_;
+	raw = raw_;
+	ticks = 0;
+	numWrites = 0;
+	started = false;
+	sccPlusUsed = false;
+	chips = chipMask;
+
+	if (!raw) {
+		// placeholder, the actual header is written at the end
+		byte header[VGM_HEADER_SIZE] = {};
+		writeData(header, sizeof(header));
+
+		// e.g. the content of the sample RAM (raw logs only contain writes)
+		mixer.forEachDevice([&](SoundDevice& device) {
+			device.logInitialState(*this);
+		});
+	}
+}
+
+void SoundChipLogger::stop(EmuTime::param time)
+{
+	if (!started) {
+		abort();
+		throw CommandException(
+			"Nothing was written to the logged sound chips, "
+			"no file was created.");
+	}
+	if (!raw) {
+		wait(time);
+		byte end = 0x66;
+		writeData(&end, 1);
+	}
+	try {
+		if (writer) { // otherwise a write error occurred (already reported)
+			writer->flush();
+			if (!raw) writeHeader();
+		}
+	} catch (MSXException&) {
+		chips = 0;
+		writer.reset();
+		throw;
+	}
+	chips = 0;
+	writer.reset();
+}
+
+void SoundChipLogger::abort()
+{
+	chips = 0;
+	writer.reset();
+	FileOperations::unlink(filename);
+}
+
+void SoundChipLogger::writeData(const void* data, size_t size)
+{
+	if (!writer) return;
+	try {
+		writer->write(data, size);
+	} catch (MSXException& e) {
+		// can't throw from here, we're called from the sound chips
+		motherBoard.getMSXCliComm().printError(
+			"Sound chip logging aborted: ", e.getMessage());
+		chips = 0;
+		writer.reset();
+	}
+}
+
+void SoundChipLogger::wait(EmuTime::param time)
+{
+	if (raw || (time < startTime)) return;
+	uint64_t newTicks = (time - startTime).getTicksAt(VGM_SAMPLE_RATE);
+	while (newTicks > ticks) {
+		auto step = unsigned(std::min<uint64_t>(newTicks - ticks, 0xFFFF));
+		ticks += step;
+		if (step <= 16) {
+			byte w = 0x70 + step - 1;
+			writeData(&w, 1);
+		} else {
+			byte w[3] = { 0x61, byte(step & 0xFF), byte(step >> 8) };
+			writeData(w, 3);
+		}
+	}
+}
+
+void SoundChipLogger::writeCommand(Chip chip, byte port, byte reg, byte value)
+{
+	if (chip == SCC && port == 4) sccPlusUsed = true;
+	byte buf[4];
+	unsigned n = 0;
+	buf[n++] = vgmCommands[chip] + ((chip == OPL3) ? port : 0);
+	if (hasPort(chip)) buf[n++] = port;
+	buf[n++] = reg;
+	buf[n++] = value;
+	writeData(buf, n);
+}
+
+void SoundChipLogger::write(Chip chip, byte port, byte reg, byte value,
+                            EmuTime::param time)
+{
+	assert(isLogging(chip));
+	if (!started) {
+		started = true;
+		startTime = time;
+		motherBoard.getMSXCliComm().printInfo(
+			"Sound chip logging started, data was written to one "
+			"of the logged sound chips.");
+	}
+	lastWriteTime = time;
+	++numWrites;
+	if (raw) {
+		char buf[64];
+		int n = snprintf(buf, sizeof(buf), "%.9f %s %u 0x%02X 0x%02X\n",
+		                 (time - startTime).toDouble(), chipNames[chip],
+		                 unsigned(port), unsigned(reg), unsigned(value));
+		writeData(buf, n);
+	} else {
+		wait(time);
+		writeCommand(chip, port, reg, value);
+	}
+}
+
+void SoundChipLogger::writeInitialReg(Chip chip, byte port, byte reg, byte value)
+{
+	assert(!started && !raw);
+	writeCommand(chip, port, reg, value);
+}
+
+void SoundChipLogger::writeDataBlock(byte type, const byte* data, unsigned size)
+{
+	assert(!started && !raw);
+	byte header[15] = { 0x67, 0x66, type };
+	Endian::write_UA_L32(&header[ 3], size + 8); // block size
+	Endian::write_UA_L32(&header[ 7], size);     // total memory size
+	Endian::write_UA_L32(&header[11], 0);        // start address
+	writeData(header, sizeof(header));
+	writeData(data, size);
+}
+
+void SoundChipLogger::marker(EmuTime::param time)
+{
+	if (!started) return;
+	if (raw) {
+		char buf[32];
+		int n = snprintf(buf, sizeof(buf), "%.9f marker\n",
+		                 (time - startTime).toDouble());
+		writeData(buf, n);
+	} else {
+		// this command is used for loop points by VGM tools, and
+		// optimized away by vgm_cmp
+		wait(time);
+		byte m[3] = { 0xBB, 0xBB, 0xBB };
+		writeData(m, 3);
+	}
+}
+
+void SoundChipLogger::writeHeader()
+{
+	// VGM 1.61, rewrites the placeholder at the start of the file
+	byte h[VGM_HEADER_SIZE] = {};
+	memcpy(&h[0x00], "Vgm ", 4);
+	auto set = [&](unsigned offset, uint32_t value) {
+		Endian::write_UA_L32(&h[offset], value);
+	};
+	set(0x04, uint32_t(writer->getSize() - 4)); // EOF offset
+	set(0x08, 0x161); // version
+	set(0x18, uint32_t(ticks)); // total number of samples
+	set(0x34, VGM_HEADER_SIZE - 0x34); // data offset (relative)
+	if (isLogging(MSX_MUSIC)) set(0x10, 3579545);  // YM2413
+	if (isLogging(OPM))       set(0x30, 3579545);  // YM2151
+	if (isLogging(MSX_AUDIO)) set(0x58, 3579545);  // Y8950
+	if (isLogging(OPL3))      set(0x5C, 14318180); // YMF262
+	if (isLogging(MOONSOUND)) set(0x60, 33868800); // YMF278B
+	if (isLogging(PSG))       set(0x74, 1789773);  // AY8910
+	if (isLogging(SCC)) {
+		// bit 31 indicates SCC+ (K052539)
+		set(0x9C, 1789773 | (sccPlusUsed ? 0x80000000 : 0));
+	}
+	auto& file = writer->getFile();
+	file.seek(0);
+	file.write(h, sizeof(h));
+}
+
+
+// class SoundChipLogger::Cmd
+
+SoundChipLogger::Cmd::Cmd(CommandController& commandController_)
+	: Command(commandController_, "soundchip_log")
+{
+}
+
+void SoundChipLogger::Cmd::execute(span<const TclObject> tokens, TclObject& result)
+{
+	if (tokens.size() < 2) {
+		throw CommandException("Missing argument");
+	}
+	auto& logger = OUTER(SoundChipLogger, cmd);
+	auto time = logger.motherBoard.getCurrentTime();
+	string_view subcommand = tokens[1].getString();
+	if (subcommand == "start") {
+		if (logger.chips) {
+			throw CommandException("Already logging.");
+		}
+		bool raw = false;
+		string prefix = "music";
+		string filename;
+		unsigned mask = 0;
+		for (size_t i = 2; i < tokens.size(); ++i) {
+			string_view arg = tokens[i].getString();
+			if (arg == "-raw") {
+				raw = true;
+			} else if (arg == "-prefix") {
+				if (++i == tokens.size()) {
+					throw CommandException("Missing argument for option \"-prefix\"");
+				}
+				prefix = tokens[i].getString().str();
+			} else if (arg == "-file") {
+				if (++i == tokens.size()) {
+					throw CommandException("Missing argument for option \"-file\"");
+				}
+				filename = tokens[i].getString().str();
+			} else {
+				auto it = ranges::find_if(chipNames, [&](const char* chipName) {
+					return StringOp::casecmp()(chipName, arg);
+				});
+				if (it == std::end(chipNames)) {
+					throw CommandException("Unknown sound chip: ", arg);
+				}
+				mask |= 1 << (it - std::begin(chipNames));
+			}
+		}
+		if (!mask) {
+			throw CommandException("Please specify at least one sound chip to log.");
+		}
+		filename = FileOperations::parseCommandFileArgument(
+			filename, "vgm_recordings", prefix, raw ? ".txt" : ".vgm");
+		logger.start(mask, raw, filename);
+		string chips;
+		for (unsigned c = 0; c < NUM_CHIPS; ++c) {
+			if (mask & (1 << c)) strAppend(chips, ' ', chipNames[c]);
+		}
+		result = strCat("Sound chip logging initiated, logging will start at "
+		                "the first write to one of the chips. Logging to ",
+		                filename, " for the following sound chips:", chips);
+	} else if ((subcommand == "stop") || (subcommand == "abort")) {
+		if (tokens.size() != 2) throw SyntaxError();
+		if (!logger.chips) {
+			throw CommandException("Not logging.");
+		}
+		if (subcommand == "stop") {
+			logger.stop(time);
+			result = logger.filename;
+		} else {
+			logger.abort();
+		}
+	} else if (subcommand == "marker") {
+		if (tokens.size() != 2) throw SyntaxError();
+		if (!logger.chips) {
+			throw CommandException("Not logging.");
+		}
+		logger.marker(time);
+	} else if (subcommand == "status") {
+		if (tokens.size() != 2) throw SyntaxError();
+		bool active = logger.chips != 0;
+		result.addDictKeyValue("active", active);
+		if (active) {
+			result.addDictKeyValues(
+				"file", logger.filename,
+				"format", logger.raw ? "raw" : "vgm",
+				"started", logger.started,
+				"writes", int(logger.numWrites));
+			if (logger.started) {
+				result.addDictKeyValues(
+					"time", (time - logger.startTime).toDouble(),
+					"idle", (time - logger.lastWriteTime).toDouble());
+			}
+		}
+	} else {
+		throw SyntaxError();
+	}
+}
+
+string SoundChipLogger::Cmd::help(const vector<string>& /*tokens*/) const
+{
+	return "Logs the register writes of sound chips to a VGM file.\n"
+	       "soundchip_log start [-raw] [-prefix <prefix>] [-file <filename>] <chip>...\n"
+	       "                       Start logging the given chips (PSG, MSX-Music,\n"
+	       "                       MSX-Audio, Moonsound, SCC, OPM, OPL3), by default to\n"
+	       "                       'musicNNNN.vgm'. With -raw a text file with one\n"
+	       "                       timestamped write per line is created instead.\n"
+	       "                       The actual logging starts at the first write.\n"
+	       "soundchip_log stop     Stop logging and finish the file\n"
+	       "soundchip_log abort    Stop logging and delete the file\n"
+	       "soundchip_log marker   Insert a marker (e.g. to indicate a loop point)\n"
+	       "soundchip_log status   Query the logging state\n";
+}
+
+void SoundChipLogger::Cmd::tabCompletion(vector<string>& tokens) const
+{
+	if (tokens.size() == 2) {
+		static const char* const cmds[] = {
+			"start", "stop", "abort", "marker", "status",
+		};
+		completeString(tokens, cmds);
+	} else if ((tokens.size() >= 3) && (tokens[1] == "start")) {
+		static const char* const options[] = {
+			"-raw", "-prefix", "-file",
+			"PSG", "MSX-Music", "MSX-Audio", "Moonsound", "SCC", "OPM",
+			"OPL3",
+		};
+		completeString(tokens, options, false); // case insensitive
+	}
+}
+
+} // namespace openmsx
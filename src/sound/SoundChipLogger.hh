@@ -0,0 +1,84 @@
+#ifndef SOUNDCHIPLOGGER_HH
+#define SOUNDCHIPLOGGER_HH
+
+#include "Command.hh"
+#include "EmuTime.hh"
+#include "openmsx.hh"
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace openmsx {
+
+class MSXMotherBoard;
+class MSXMixer;
+class AsyncFileWriter;
+
+/** Logs the register writes of (a selection of) the sound chips to a file,
+  * either in VGM format or as a plain text log.
+  *
+  * This replaces the old Tcl script that used watchpoints on the I/O ports
+  * and memory addresses of the chips: the writes are now reported directly
+  * by the sound devices, encoded in a buffer and written to disk from a
+  * background thread. When logging is not active for a chip, the cost of
+  * this is a single test per register write.
+  */
+class SoundChipLogger
+{
+public:
+	enum Chip { PSG, MSX_MUSIC, MSX_AUDIO, MOONSOUND, SCC, OPM, OPL3, NUM_CHIPS };
+
+	SoundChipLogger(MSXMotherBoard& motherBoard, MSXMixer& mixer);
+	~SoundChipLogger();
+
+	bool isLogging(Chip chip) const { return (chips >> chip) & 1; }
+
+	/** Log a register write. The meaning of 'port' is chip specific, it
+	  * is the same as the port byte of the corresponding VGM command
+	  * (0 for chips that don't have such a byte).
+	  */
+	void write(Chip chip, byte port, byte reg, byte value, EmuTime::param time);
+
+	/** Log a VGM data block (e.g. the content of the sample RAM). Only
+	  * allowed while the logging is being started, see
+	  * SoundDevice::logInitialState().
+	  */
+	void writeDataBlock(byte type, const byte* data, unsigned size);
+	/** Log a register write that is not timestamped, see writeDataBlock(). */
+	void writeInitialReg(Chip chip, byte port, byte reg, byte value);
+
+private:
+	void start(unsigned chipMask, bool raw, const std::string& filename);
+	void stop(EmuTime::param time);
+	void abort();
+	void marker(EmuTime::param time);
+	void wait(EmuTime::param time);
+	void writeCommand(Chip chip, byte port, byte reg, byte value);
+	void writeHeader();
+	void writeData(const void* data, size_t size);
+
+	MSXMotherBoard& motherBoard;
+	MSXMixer& mixer;
+
+	std::unique_ptr<AsyncFileWriter> writer;
+	std::string filename;
+	EmuTime startTime;
+	EmuTime lastWriteTime;
+	uint64_t ticks; // number of 44100Hz samples already written as waits
+	uint64_t numWrites;
+	unsigned chips = 0; // bitmask, only non-zero while logging
+	bool raw;
+	bool started;   // has the first write been logged
+	bool sccPlusUsed;
+
+	struct Cmd final : Command {
+		explicit Cmd(CommandController& commandController);
+		void execute(span<const TclObject> tokens, TclObject& result) override;
+		std::string help(const std::vector<std::string>& tokens) const override;
+		void tabCompletion(std::vector<std::string>& tokens) const override;
+	} cmd;
+};
+
+} // namespace openmsx
+
+#endif
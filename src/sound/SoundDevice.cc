@@ -8,10 +8,12 @@
 #include "MemoryOps.hh"
 #include "MemBuffer.hh"
 #include "MSXException.hh"
+#include "aligned.hh"
 #include "likely.hh"
 #include "ranges.hh"
 #include "vla.hh"
 #include "xrange.hh"
+#include <algorithm>
 #include <cassert>
 #include <memory>
 
@@ -184,6 +186,29 @@ void SoundDevice::muteChannel(unsigned channel, bool muted)
 	channelMuted[channel] = muted;
 }
 
+void SoundDevice::skipBuffer(unsigned length, EmuTime::param time)
+{
+	// +3, see updateBuffer()
+	VLA_SSE_ALIGNED(int, buffer, (isStereo() ? 2 : 1) * length + 3);
+	updateBuffer(length, buffer, time);
+}
+
+void SoundDevice::logInitialState(SoundChipLogger& /*logger*/)
+{
+}
+
+void SoundDevice::skipChannels(unsigned num)
+{
+	// generate in chunks to limit the size of the (discarded) output
+	static const unsigned CHUNK = 1024;
+	SSE_ALIGNED(int buffer[2 * CHUNK + 3]);
+	while (num) {
+		unsigned n = std::min(num, CHUNK);
+		mixChannels(buffer, n);
+		num -= n;
+	}
+}
+
 bool SoundDevice::mixChannels(int* dataOut, unsigned samples)
 {
 #ifdef __SSE2__
@@ -5,6 +5,7 @@
 #include "EmuTime.hh"
 #include "FixedPoint.hh"
 #include "string_view.hh"
+#include "likely.hh"
 #include <memory>
 
 namespace openmsx {
@@ -69,6 +70,30 @@ public:
 	void recordChannel(unsigned channel, const Filename& filename);
 	void muteChannel  (unsigned channel, bool muted);
 
+	unsigned getNumChannels() const { return numChannels; }
+
+	/** The native sample rate of this device (the rate of the samples
+	  * produced by generateChannels()).
+	  */
+	unsigned getInputRate() const { return inputSampleRate; }
+
+	/** Generate the output of the individual channels at the native
+	  * sample rate, so without mixing, resampling or recording. This is
+	  * meant for tools that look at the output of the chip itself (e.g.
+	  * to measure its speed). See generateChannels() for the parameters,
+	  * for stereo devices each buffer must hold 2 * 'num' samples.
+	  */
+	void generateRawChannels(int** buffers, unsigned num) {
+		generateChannels(buffers, num);
+	}
+
+	/** The writer for a recorded channel, nullptr if the channel isn't
+	  * being recorded. */
+	const Wav16Writer* getChannelRecorder(unsigned channel) const {
+		assert(channel < numChannels);
+		return writer[channel].get();
+	}
+
 protected:
 	/** Constructor.
 	  * @param mixer The Mixer object
@@ -109,7 +134,6 @@ protected:
 	void updateStream(EmuTime::param time);
 
 	void setInputRate(unsigned sampleRate) { inputSampleRate = sampleRate; }
-	unsigned getInputRate() const { return inputSampleRate; }
 
 public: // Will be called by Mixer:
 	/**
@@ -140,6 +164,23 @@ public: // Will be called by Mixer:
 	virtual bool updateBuffer(unsigned length, int* buffer,
 	                          EmuTime::param time) = 0;
 
+	/** Like updateBuffer(), but nobody is going to listen to the output.
+	  * This is used while fast-forwarding (e.g. during 'reverse goto'),
+	  * the mixer is muted then anyway. Only the state that can be
+	  * observed by the MSX (status flags, timers, sample positions, ...)
+	  * must be advanced, so generating (and resampling) the samples can
+	  * be skipped.
+	  * The default implementation generates and discards the output.
+	  */
+	virtual void skipBuffer(unsigned length, EmuTime::param time);
+
+	/** Called when SoundChipLogger starts logging. Devices can log their
+	  * current state that is not set via register writes (e.g. the
+	  * content of the sample RAM), see SoundChipLogger::writeDataBlock().
+	  * The default implementation does nothing.
+	  */
+	virtual void logInitialState(SoundChipLogger& logger);
+
 protected:
 	/** Adds a number of samples that all have the same value.
 	  * Can be used to synthesize the high half of a square wave cycle.
@@ -180,6 +221,30 @@ protected:
 	  */
 	bool mixChannels(int* dataOut, unsigned samples);
 
+	/** Advance the channels by 'num' samples without producing output,
+	  * see skipBuffer(). The state afterwards must be the same as after
+	  * generateChannels(), otherwise the audio, snapshots and savestates
+	  * after a 'reverse goto' depend on whether the output was needed.
+	  * The default implementation calls generateChannels() and discards
+	  * the result. Devices can override this with a cheaper version that
+	  * only advances the state (envelopes, phases, play positions, ...).
+	  */
+	virtual void skipChannels(unsigned num);
+
+	/** Report a register write to the SoundChipLogger. This only costs a
+	  * single test when logging is not active for this type of chip.
+	  */
+	void logWrite(SoundChipLogger::Chip chip, byte port, byte reg,
+	              byte value, EmuTime::param time) {
+		auto& logger = mixer.getChipLogger();
+		if (unlikely(logger.isLogging(chip))) {
+			logger.write(chip, port, reg, value, time);
+		}
+	}
+
+	/** Is the output of (some of) the channels being recorded? */
+	bool isRecordingChannels() const { return numRecordChannels != 0; }
+
 	/** See MSXMixer::getHostSampleClock(). */
 	const DynamicClock& getHostSampleClock() const;
 	double getEffectiveSpeed() const;
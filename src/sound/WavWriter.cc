@@ -1,5 +1,5 @@
 #include "WavWriter.hh"
-#include "MSXException.hh"
+#include "FileException.hh"
 #include "Math.hh"
 #include "vla.hh"
 #include "endian.hh"
@@ -8,11 +8,11 @@
 
 namespace openmsx {
 
-WavWriter::WavWriter(const Filename& filename,
-                     unsigned channels, unsigned bits, unsigned frequency)
-	: file(filename, "wb")
-	, bytes(0)
+static File createWav(const Filename& filename,
+                      unsigned channels, unsigned bits, unsigned frequency)
 {
+	File file(filename, "wb");
+
 	// write wav header
 	struct WavHeader {
 		char        chunkID[4];     // + 0 'RIFF'
@@ -45,6 +45,14 @@ WavWriter::WavWriter(const Filename& filename,
 	header.subChunk2Size = 0; // actaul value filled in later
 
 	file.write(&header, sizeof(header));
+	return file;
+}
+
+WavWriter::WavWriter(const Filename& filename,
+                     unsigned channels, unsigned bits, unsigned frequency)
+	: writer(createWav(filename, channels, bits, frequency))
+	, bytes(0)
+{
 }
 
 WavWriter::~WavWriter()
@@ -53,7 +61,7 @@ WavWriter::~WavWriter()
 		// data chunk must have an even number of bytes
 		if (bytes & 1) {
 			uint8_t pad = 0;
-			file.write(&pad, 1);
+			writer.write(&pad, 1);
 		}
 
 		flush(); // write header
@@ -62,8 +70,30 @@ WavWriter::~WavWriter()
 	}
 }
 
+void WavWriter::writeData(const void* data, unsigned size)
+{
+	if (!error.empty()) return; // stopped after a write error
+	try {
+		writer.write(data, size);
+		bytes += size;
+	} catch (FileException& e) {
+		error = e.getMessage();
+	}
+}
+
 void WavWriter::flush()
 {
+	if (!error.empty()) {
+		throw FileException(error);
+	}
+	try {
+		writer.flush();
+	} catch (FileException& e) {
+		error = e.getMessage();
+		throw;
+	}
+
+	auto& file = writer.getFile();
 	Endian::L32 totalSize = (bytes + 44 - 8 + 1) & ~1; // round up to even number
 	Endian::L32 wavSize   = bytes;
 
@@ -77,8 +107,7 @@ void WavWriter::flush()
 
 void Wav8Writer::write(const uint8_t* buffer, unsigned samples)
 {
-	file.write(buffer, samples);
-	bytes += samples;
+	writeData(buffer, samples);
 }
 
 void Wav16Writer::write(const int16_t* buffer, unsigned samples)
@@ -93,11 +122,10 @@ void Wav16Writer::write(const int16_t* buffer, unsigned samples)
 		// code is anyway not performance critical.
 		//VLA(Endian::L16, buf, samples); // doesn't work in clang
 		std::vector<Endian::L16> buf(buffer, buffer + samples);
-		file.write(buf.data(), size);
+		writeData(buf.data(), size);
 	} else {
-		file.write(buffer, size);
+		writeData(buffer, size);
 	}
-	bytes += size;
 }
 
 void Wav16Writer::write(const int* buffer, unsigned stereo, unsigned samples,
@@ -117,8 +145,7 @@ void Wav16Writer::write(const int* buffer, unsigned stereo, unsigned samples,
 		}
 	}
 	unsigned size = sizeof(int16_t) * samples * stereo;
-	file.write(buf.data(), size);
-	bytes += size;
+	writeData(buf.data(), size);
 }
 
 void Wav16Writer::writeSilence(unsigned samples)
@@ -126,8 +153,7 @@ void Wav16Writer::writeSilence(unsigned samples)
 	VLA(int16_t, buf, samples);
 	unsigned size = sizeof(int16_t) * samples;
 	memset(buf, 0, size);
-	file.write(buf, size);
-	bytes += size;
+	writeData(buf, size);
 }
 
 } // namespace openmsx
@@ -1,15 +1,21 @@
 #ifndef WAVWRITER_HH
 #define WAVWRITER_HH
 
-#include "File.hh"
+#include "AsyncFileWriter.hh"
 #include <cassert>
 #include <cstdint>
+#include <string>
 
 namespace openmsx {
 
 class Filename;
 
 /** Base class for writing WAV files.
+  *
+  * The actual disk writes happen in a background thread (see
+  * AsyncFileWriter), so that recording doesn't stall the emulation. A write
+  * error doesn't throw from write(), instead recording stops and the error
+  * is available via getError() (and is thrown by the next flush()).
   */
 class WavWriter
 {
@@ -23,12 +29,22 @@ public:
 	  */
 	void flush();
 
+	/** The write error that stopped the recording (empty if none). */
+	const std::string& getError() const { return error; }
+
+	/** The number of times the emulation had to wait for the disk. */
+	unsigned getOverruns() const { return writer.getOverruns(); }
+
 protected:
 	WavWriter(const Filename& filename,
 	          unsigned channels, unsigned bits, unsigned frequency);
 	~WavWriter();
 
-	File file;
+	void writeData(const void* data, unsigned size);
+
+private:
+	AsyncFileWriter writer;
+	std::string error;
 	unsigned bytes;
 };
 
@@ -833,6 +833,44 @@ bool Y8950::checkMuteHelper()
 	return adpcm.isMuted();
 }
 
+// Advance the LFOs and the noise generators by one sample.
+void Y8950::advanceLFO()
+{
+	// Amplitude modulation: 27 output levels (triangle waveform);
+	// 1 level takes one of: 192, 256 or 448 samples
+	// One entry from LFO_AM_TABLE lasts for 64 samples
+	// lfo_am_table is 210 elements long
+	++am_phase;
+	if (am_phase == (LFO_AM_TAB_ELEMENTS * 64)) am_phase = 0;
+
+	pm_phase = (pm_phase + PM_DPHASE) & (PM_DP_WIDTH - 1);
+
+	if (noise_seed & 1) {
+		noise_seed ^= 0x24000;
+	}
+	noise_seed >>= 1;
+
+	noiseA_phase += noiseA_dphase;
+	noiseA_phase &= (0x40 << 11) - 1;
+	if ((noiseA_phase >> 11) == 0x3f) {
+		noiseA_phase = 0;
+	}
+
+	noiseB_phase += noiseB_dphase;
+	noiseB_phase &= (0x10 << 11) - 1;
+}
+
+int Y8950::getLfoAm() const
+{
+	unsigned tmp = lfo_am_table[am_phase / 64];
+	return am_mode ? tmp : tmp / 4;
+}
+
+int Y8950::getLfoPm() const
+{
+	return pm.table[pm_mode][pm_phase >> (PM_DP_BITS - PM_PG_BITS)];
+}
+
 void Y8950::generateChannels(int** bufs, unsigned num)
 {
 	// TODO implement per-channel mute (instead of all-or-nothing)
@@ -847,33 +885,11 @@ void Y8950::generateChannels(int** bufs, unsigned num)
 	}
 
 	for (unsigned sample = 0; sample < num; ++sample) {
-		// Amplitude modulation: 27 output levels (triangle waveform);
-		// 1 level takes one of: 192, 256 or 448 samples
-		// One entry from LFO_AM_TABLE lasts for 64 samples
-		// lfo_am_table is 210 elements long
-		++am_phase;
-		if (am_phase == (LFO_AM_TAB_ELEMENTS * 64)) am_phase = 0;
-		unsigned tmp = lfo_am_table[am_phase / 64];
-		int lfo_am = am_mode ? tmp : tmp / 4;
-
-		pm_phase = (pm_phase + PM_DPHASE) & (PM_DP_WIDTH - 1);
-		int lfo_pm = pm.table[pm_mode][pm_phase >> (PM_DP_BITS - PM_PG_BITS)];
-
-		if (noise_seed & 1) {
-			noise_seed ^= 0x24000;
-		}
-		noise_seed >>= 1;
+		advanceLFO();
+		int lfo_am = getLfoAm();
+		int lfo_pm = getLfoPm();
 		int whitenoise = noise_seed & 1 ? DB_POS(6) : DB_NEG(6);
-
-		noiseA_phase += noiseA_dphase;
-		noiseA_phase &= (0x40 << 11) - 1;
-		if ((noiseA_phase >> 11) == 0x3f) {
-			noiseA_phase = 0;
-		}
 		int noiseA = noiseA_phase & (0x03 << 11) ? DB_POS(6) : DB_NEG(6);
-
-		noiseB_phase += noiseB_dphase;
-		noiseB_phase &= (0x10 << 11) - 1;
 		int noiseB = noiseB_phase & (0x0A << 11) ? DB_POS(6) : DB_NEG(6);
 
 		int m = rythm_mode ? 6 : 9;
@@ -925,6 +941,68 @@ void Y8950::generateChannels(int** bufs, unsigned num)
 	}
 }
 
+void Y8950::skipChannels(unsigned num)
+{
+	// Like generateChannels(), but without calculating the output of the
+	// carriers and the rhythm instruments. The LFOs, noise generators,
+	// envelopes, phases, modulator feedback and the ADPCM (audio) play
+	// position advance exactly like when generating.
+	if (checkMuteHelper()) return;
+
+	for (unsigned sample = 0; sample < num; ++sample) {
+		advanceLFO();
+		int lfo_am = getLfoAm();
+		int lfo_pm = getLfoPm();
+
+		int m = rythm_mode ? 6 : 9;
+		for (int i = 0; i < m; ++i) {
+			if (ch[i].slot[CAR].isActive()) {
+				ch[i].slot[MOD].calc_slot_mod(lfo_pm, lfo_am);
+				ch[i].slot[CAR].calc_envelope(lfo_am);
+				ch[i].slot[CAR].calc_phase(lfo_pm);
+			}
+		}
+		if (rythm_mode) {
+			ch[7].slot[MOD].calc_phase(lfo_pm);
+			ch[8].slot[CAR].calc_phase(lfo_pm);
+
+			if (ch[6].slot[CAR].isActive()) { // bass drum
+				ch[6].slot[MOD].calc_slot_mod(lfo_pm, lfo_am);
+				ch[6].slot[CAR].calc_envelope(lfo_am);
+				ch[6].slot[CAR].calc_phase(lfo_pm);
+			}
+			if (ch[7].slot[CAR].isActive()) { // snare
+				ch[7].slot[CAR].calc_envelope(lfo_am);
+				ch[7].slot[CAR].calc_phase(lfo_pm);
+			}
+			if (ch[8].slot[CAR].isActive()) { // cymbal
+				ch[8].slot[CAR].calc_envelope(lfo_am);
+			}
+			if (ch[7].slot[MOD].isActive()) { // hi-hat
+				ch[7].slot[MOD].calc_envelope(lfo_am);
+			}
+			if (ch[8].slot[MOD].isActive()) { // tom
+				ch[8].slot[MOD].calc_envelope(lfo_am);
+				ch[8].slot[MOD].calc_phase(lfo_pm);
+			}
+		}
+
+		adpcm.calcSample();
+	}
+}
+
+void Y8950::logInitialState(SoundChipLogger& logger)
+{
+	if (!logger.isLogging(SoundChipLogger::MSX_AUDIO)) return;
+	// The sample RAM, if it was already loaded before logging started.
+	// Later writes are logged as register writes (VGM tools can
+	// optimize those into a data block).
+	auto& ram = adpcm.getRam();
+	if (ram.getSize()) {
+		logger.writeDataBlock(0x88, &ram[0], ram.getSize());
+	}
+}
+
 //
 // I/O Ctrl
 //
@@ -938,6 +1016,8 @@ void Y8950::writeReg(byte rg, byte data, EmuTime::param time)
 		-1, -1, -1, -1, -1, -1, -1, -1
 	};
 
+	logWrite(SoundChipLogger::MSX_AUDIO, 0, rg, data, time);
+
 	// TODO only for registers that influence sound
 	// TODO also ADPCM
 	//if (rg >= 0x20) {
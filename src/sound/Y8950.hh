@@ -76,6 +76,8 @@ private:
 	// SoundDevice
 	int getAmplificationFactorImpl() const override;
 	void generateChannels(int** bufs, unsigned num) override;
+	void skipChannels(unsigned num) override;
+	void logInitialState(SoundChipLogger& logger) override;
 
 	inline void keyOn_BD();
 	inline void keyOn_SD();
@@ -91,6 +93,9 @@ private:
 	void update_key_status();
 
 	bool checkMuteHelper();
+	inline void advanceLFO();
+	inline int getLfoAm() const;
+	inline int getLfoPm() const;
 
 	void changeStatusMask(byte newMask);
 
@@ -27,6 +27,7 @@ public:
 	int calcSample();
 	void sync(EmuTime::param time);
 	void resetStatus();
+	const TrackedRam& getRam() const { return ram; }
 
 	template<typename Archive>
 	void serialize(Archive& ar, unsigned version);
@@ -618,6 +618,7 @@ void YM2151::refreshEG(YM2151Operator* op)
 
 void YM2151::writeReg(byte r, byte v, EmuTime::param time)
 {
+	logWrite(SoundChipLogger::OPM, 0, r, v, time);
 	updateStream(time);
 
 	YM2151Operator* op = &oper[(r & 0x07) * 4 + ((r & 0x18) >> 3)];
@@ -65,6 +65,7 @@ void YM2413::reset(EmuTime::param time)
 
 void YM2413::writeReg(byte reg, byte value, EmuTime::param time)
 {
+	logWrite(SoundChipLogger::MSX_MUSIC, 0, reg, value, time);
 	updateStream(time);
 	core->writeReg(reg, value);
 }
@@ -11,6 +11,7 @@
 #include "ranges.hh"
 #include "serialize.hh"
 #include "unreachable.hh"
+#include "vla.hh"
 #include <cstring>
 #include <cassert>
 #include <iostream>
@@ -1098,7 +1099,9 @@ Patch& YM2413::getPatch(unsigned instrument, bool carrier)
 }
 
 template <unsigned FLAGS>
-ALWAYS_INLINE void YM2413::calcChannel(Channel& ch, int* buf, unsigned num)
+ALWAYS_INLINE void YM2413::calcChannel(
+	Channel& ch, int* buf, unsigned num,
+	const unsigned* lfoPm, const int* lfoAm)
 {
 	// VC++ requires explicit conversion to bool. Compiler bug??
 	const bool HAS_CAR_PM = (FLAGS &  1) != 0;
@@ -1114,8 +1117,6 @@ ALWAYS_INLINE void YM2413::calcChannel(Channel& ch, int* buf, unsigned num)
 	assert(((ch.mod.patch.AMPM & 1) != 0) == HAS_MOD_PM);
 	assert(((ch.mod.patch.AMPM & 2) != 0) == HAS_MOD_AM);
 
-	unsigned tmp_pm_phase = pm_phase;
-	unsigned tmp_am_phase = am_phase;
 	unsigned car_fixed_env = 0; // dummy
 	unsigned mod_fixed_env = 0; // dummy
 	if (HAS_CAR_FIXED_ENV) {
@@ -1127,23 +1128,8 @@ ALWAYS_INLINE void YM2413::calcChannel(Channel& ch, int* buf, unsigned num)
 
 	unsigned sample = 0;
 	do {
-		unsigned lfo_pm = 0;
-		if (HAS_CAR_PM || HAS_MOD_PM) {
-			// Copied from Burczynski:
-			//  There are only 8 different steps for PM, and each
-			//  step lasts for 1024 samples. This results in a PM
-			//  freq of 6.1Hz (but datasheet says it's 6.4Hz).
-			++tmp_pm_phase;
-			lfo_pm = (tmp_pm_phase >> 10) & 7;
-		}
-		int lfo_am = 0; // avoid warning
-		if (HAS_CAR_AM || HAS_MOD_AM) {
-			++tmp_am_phase;
-			if (tmp_am_phase == (LFO_AM_TAB_ELEMENTS * 64)) {
-				tmp_am_phase = 0;
-			}
-			lfo_am = lfo_am_table[tmp_am_phase / 64];
-		}
+		unsigned lfo_pm = (HAS_CAR_PM || HAS_MOD_PM) ? lfoPm[sample] : 0;
+		int      lfo_am = (HAS_CAR_AM || HAS_MOD_AM) ? lfoAm[sample] : 0;
 		int fm = ch.mod.calc_slot_mod<HAS_MOD_AM, HAS_MOD_FB, HAS_MOD_FIXED_ENV>(
 		                      HAS_MOD_PM ? lfo_pm : 0, lfo_am, mod_fixed_env);
 		buf[sample] += ch.car.calc_slot_car<HAS_CAR_AM, HAS_CAR_FIXED_ENV>(
@@ -1156,6 +1142,25 @@ void YM2413::generateChannels(int* bufs[9 + 5], unsigned num)
 {
 	assert(num != 0);
 
+	// The LFOs are the same for all channels, calculate them only once.
+	VLA(unsigned, lfoPm, num);
+	VLA(int,      lfoAm, num);
+	unsigned tmp_pm_phase = pm_phase;
+	unsigned tmp_am_phase = am_phase;
+	for (unsigned sample = 0; sample < num; ++sample) {
+		// Copied from Burczynski:
+		//  There are only 8 different steps for PM, and each
+		//  step lasts for 1024 samples. This results in a PM
+		//  freq of 6.1Hz (but datasheet says it's 6.4Hz).
+		++tmp_pm_phase;
+		lfoPm[sample] = (tmp_pm_phase >> 10) & 7;
+		++tmp_am_phase;
+		if (tmp_am_phase == (LFO_AM_TAB_ELEMENTS * 64)) {
+			tmp_am_phase = 0;
+		}
+		lfoAm[sample] = lfo_am_table[tmp_am_phase / 64];
+	}
+
 	unsigned m = isRhythm() ? 6 : 9;
 	for (unsigned i = 0; i < m; ++i) {
 		Channel& ch = channels[i];
@@ -1176,134 +1181,134 @@ void YM2413::generateChannels(int* bufs[9 + 5], unsigned num)
 			                 ( carFixedEnv           << 5) |
 			                 ( modFixedEnv           << 6);
 			switch (flags) {
-			case   0: calcChannel<  0>(ch, bufs[i], num); break;
-			case   1: calcChannel<  1>(ch, bufs[i], num); break;
-			case   2: calcChannel<  2>(ch, bufs[i], num); break;
-			case   3: calcChannel<  3>(ch, bufs[i], num); break;
-			case   4: calcChannel<  4>(ch, bufs[i], num); break;
-			case   5: calcChannel<  5>(ch, bufs[i], num); break;
-			case   6: calcChannel<  6>(ch, bufs[i], num); break;
-			case   7: calcChannel<  7>(ch, bufs[i], num); break;
-			case   8: calcChannel<  8>(ch, bufs[i], num); break;
-			case   9: calcChannel<  9>(ch, bufs[i], num); break;
-			case  10: calcChannel< 10>(ch, bufs[i], num); break;
-			case  11: calcChannel< 11>(ch, bufs[i], num); break;
-			case  12: calcChannel< 12>(ch, bufs[i], num); break;
-			case  13: calcChannel< 13>(ch, bufs[i], num); break;
-			case  14: calcChannel< 14>(ch, bufs[i], num); break;
-			case  15: calcChannel< 15>(ch, bufs[i], num); break;
-			case  16: calcChannel< 16>(ch, bufs[i], num); break;
-			case  17: calcChannel< 17>(ch, bufs[i], num); break;
-			case  18: calcChannel< 18>(ch, bufs[i], num); break;
-			case  19: calcChannel< 19>(ch, bufs[i], num); break;
-			case  20: calcChannel< 20>(ch, bufs[i], num); break;
-			case  21: calcChannel< 21>(ch, bufs[i], num); break;
-			case  22: calcChannel< 22>(ch, bufs[i], num); break;
-			case  23: calcChannel< 23>(ch, bufs[i], num); break;
-			case  24: calcChannel< 24>(ch, bufs[i], num); break;
-			case  25: calcChannel< 25>(ch, bufs[i], num); break;
-			case  26: calcChannel< 26>(ch, bufs[i], num); break;
-			case  27: calcChannel< 27>(ch, bufs[i], num); break;
-			case  28: calcChannel< 28>(ch, bufs[i], num); break;
-			case  29: calcChannel< 29>(ch, bufs[i], num); break;
-			case  30: calcChannel< 30>(ch, bufs[i], num); break;
-			case  31: calcChannel< 31>(ch, bufs[i], num); break;
-			case  32: calcChannel< 32>(ch, bufs[i], num); break;
-			case  33: calcChannel< 33>(ch, bufs[i], num); break;
-			case  34: calcChannel< 34>(ch, bufs[i], num); break;
-			case  35: calcChannel< 35>(ch, bufs[i], num); break;
-			case  36: calcChannel< 36>(ch, bufs[i], num); break;
-			case  37: calcChannel< 37>(ch, bufs[i], num); break;
-			case  38: calcChannel< 38>(ch, bufs[i], num); break;
-			case  39: calcChannel< 39>(ch, bufs[i], num); break;
-			case  40: calcChannel< 40>(ch, bufs[i], num); break;
-			case  41: calcChannel< 41>(ch, bufs[i], num); break;
-			case  42: calcChannel< 42>(ch, bufs[i], num); break;
-			case  43: calcChannel< 43>(ch, bufs[i], num); break;
-			case  44: calcChannel< 44>(ch, bufs[i], num); break;
-			case  45: calcChannel< 45>(ch, bufs[i], num); break;
-			case  46: calcChannel< 46>(ch, bufs[i], num); break;
-			case  47: calcChannel< 47>(ch, bufs[i], num); break;
-			case  48: calcChannel< 48>(ch, bufs[i], num); break;
-			case  49: calcChannel< 49>(ch, bufs[i], num); break;
-			case  50: calcChannel< 50>(ch, bufs[i], num); break;
-			case  51: calcChannel< 51>(ch, bufs[i], num); break;
-			case  52: calcChannel< 52>(ch, bufs[i], num); break;
-			case  53: calcChannel< 53>(ch, bufs[i], num); break;
-			case  54: calcChannel< 54>(ch, bufs[i], num); break;
-			case  55: calcChannel< 55>(ch, bufs[i], num); break;
-			case  56: calcChannel< 56>(ch, bufs[i], num); break;
-			case  57: calcChannel< 57>(ch, bufs[i], num); break;
-			case  58: calcChannel< 58>(ch, bufs[i], num); break;
-			case  59: calcChannel< 59>(ch, bufs[i], num); break;
-			case  60: calcChannel< 60>(ch, bufs[i], num); break;
-			case  61: calcChannel< 61>(ch, bufs[i], num); break;
-			case  62: calcChannel< 62>(ch, bufs[i], num); break;
-			case  63: calcChannel< 63>(ch, bufs[i], num); break;
-			case  64: calcChannel< 64>(ch, bufs[i], num); break;
-			case  65: calcChannel< 65>(ch, bufs[i], num); break;
-			case  66: calcChannel< 66>(ch, bufs[i], num); break;
-			case  67: calcChannel< 67>(ch, bufs[i], num); break;
-			case  68: calcChannel< 68>(ch, bufs[i], num); break;
-			case  69: calcChannel< 69>(ch, bufs[i], num); break;
-			case  70: calcChannel< 70>(ch, bufs[i], num); break;
-			case  71: calcChannel< 71>(ch, bufs[i], num); break;
-			case  72: calcChannel< 72>(ch, bufs[i], num); break;
-			case  73: calcChannel< 73>(ch, bufs[i], num); break;
-			case  74: calcChannel< 74>(ch, bufs[i], num); break;
-			case  75: calcChannel< 75>(ch, bufs[i], num); break;
-			case  76: calcChannel< 76>(ch, bufs[i], num); break;
-			case  77: calcChannel< 77>(ch, bufs[i], num); break;
-			case  78: calcChannel< 78>(ch, bufs[i], num); break;
-			case  79: calcChannel< 79>(ch, bufs[i], num); break;
-			case  80: calcChannel< 80>(ch, bufs[i], num); break;
-			case  81: calcChannel< 81>(ch, bufs[i], num); break;
-			case  82: calcChannel< 82>(ch, bufs[i], num); break;
-			case  83: calcChannel< 83>(ch, bufs[i], num); break;
-			case  84: calcChannel< 84>(ch, bufs[i], num); break;
-			case  85: calcChannel< 85>(ch, bufs[i], num); break;
-			case  86: calcChannel< 86>(ch, bufs[i], num); break;
-			case  87: calcChannel< 87>(ch, bufs[i], num); break;
-			case  88: calcChannel< 88>(ch, bufs[i], num); break;
-			case  89: calcChannel< 89>(ch, bufs[i], num); break;
-			case  90: calcChannel< 90>(ch, bufs[i], num); break;
-			case  91: calcChannel< 91>(ch, bufs[i], num); break;
-			case  92: calcChannel< 92>(ch, bufs[i], num); break;
-			case  93: calcChannel< 93>(ch, bufs[i], num); break;
-			case  94: calcChannel< 94>(ch, bufs[i], num); break;
-			case  95: calcChannel< 95>(ch, bufs[i], num); break;
-			case  96: calcChannel< 96>(ch, bufs[i], num); break;
-			case  97: calcChannel< 97>(ch, bufs[i], num); break;
-			case  98: calcChannel< 98>(ch, bufs[i], num); break;
-			case  99: calcChannel< 99>(ch, bufs[i], num); break;
-			case 100: calcChannel<100>(ch, bufs[i], num); break;
-			case 101: calcChannel<101>(ch, bufs[i], num); break;
-			case 102: calcChannel<102>(ch, bufs[i], num); break;
-			case 103: calcChannel<103>(ch, bufs[i], num); break;
-			case 104: calcChannel<104>(ch, bufs[i], num); break;
-			case 105: calcChannel<105>(ch, bufs[i], num); break;
-			case 106: calcChannel<106>(ch, bufs[i], num); break;
-			case 107: calcChannel<107>(ch, bufs[i], num); break;
-			case 108: calcChannel<108>(ch, bufs[i], num); break;
-			case 109: calcChannel<109>(ch, bufs[i], num); break;
-			case 110: calcChannel<110>(ch, bufs[i], num); break;
-			case 111: calcChannel<111>(ch, bufs[i], num); break;
-			case 112: calcChannel<112>(ch, bufs[i], num); break;
-			case 113: calcChannel<113>(ch, bufs[i], num); break;
-			case 114: calcChannel<114>(ch, bufs[i], num); break;
-			case 115: calcChannel<115>(ch, bufs[i], num); break;
-			case 116: calcChannel<116>(ch, bufs[i], num); break;
-			case 117: calcChannel<117>(ch, bufs[i], num); break;
-			case 118: calcChannel<118>(ch, bufs[i], num); break;
-			case 119: calcChannel<119>(ch, bufs[i], num); break;
-			case 120: calcChannel<120>(ch, bufs[i], num); break;
-			case 121: calcChannel<121>(ch, bufs[i], num); break;
-			case 122: calcChannel<122>(ch, bufs[i], num); break;
-			case 123: calcChannel<123>(ch, bufs[i], num); break;
-			case 124: calcChannel<124>(ch, bufs[i], num); break;
-			case 125: calcChannel<125>(ch, bufs[i], num); break;
-			case 126: calcChannel<126>(ch, bufs[i], num); break;
-			case 127: calcChannel<127>(ch, bufs[i], num); break;
+			case   0: calcChannel<  0>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case   1: calcChannel<  1>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case   2: calcChannel<  2>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case   3: calcChannel<  3>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case   4: calcChannel<  4>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case   5: calcChannel<  5>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case   6: calcChannel<  6>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case   7: calcChannel<  7>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case   8: calcChannel<  8>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case   9: calcChannel<  9>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  10: calcChannel< 10>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  11: calcChannel< 11>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  12: calcChannel< 12>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  13: calcChannel< 13>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  14: calcChannel< 14>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  15: calcChannel< 15>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  16: calcChannel< 16>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  17: calcChannel< 17>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  18: calcChannel< 18>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  19: calcChannel< 19>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  20: calcChannel< 20>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  21: calcChannel< 21>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  22: calcChannel< 22>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  23: calcChannel< 23>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  24: calcChannel< 24>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  25: calcChannel< 25>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  26: calcChannel< 26>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  27: calcChannel< 27>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  28: calcChannel< 28>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  29: calcChannel< 29>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  30: calcChannel< 30>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  31: calcChannel< 31>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  32: calcChannel< 32>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  33: calcChannel< 33>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  34: calcChannel< 34>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  35: calcChannel< 35>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  36: calcChannel< 36>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  37: calcChannel< 37>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  38: calcChannel< 38>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  39: calcChannel< 39>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  40: calcChannel< 40>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  41: calcChannel< 41>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  42: calcChannel< 42>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  43: calcChannel< 43>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  44: calcChannel< 44>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  45: calcChannel< 45>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  46: calcChannel< 46>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  47: calcChannel< 47>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  48: calcChannel< 48>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  49: calcChannel< 49>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  50: calcChannel< 50>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  51: calcChannel< 51>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  52: calcChannel< 52>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  53: calcChannel< 53>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  54: calcChannel< 54>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  55: calcChannel< 55>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  56: calcChannel< 56>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  57: calcChannel< 57>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  58: calcChannel< 58>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  59: calcChannel< 59>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  60: calcChannel< 60>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  61: calcChannel< 61>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  62: calcChannel< 62>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  63: calcChannel< 63>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  64: calcChannel< 64>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  65: calcChannel< 65>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  66: calcChannel< 66>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  67: calcChannel< 67>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  68: calcChannel< 68>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  69: calcChannel< 69>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  70: calcChannel< 70>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  71: calcChannel< 71>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  72: calcChannel< 72>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  73: calcChannel< 73>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  74: calcChannel< 74>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  75: calcChannel< 75>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  76: calcChannel< 76>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  77: calcChannel< 77>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  78: calcChannel< 78>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  79: calcChannel< 79>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  80: calcChannel< 80>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  81: calcChannel< 81>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  82: calcChannel< 82>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  83: calcChannel< 83>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  84: calcChannel< 84>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  85: calcChannel< 85>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  86: calcChannel< 86>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  87: calcChannel< 87>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  88: calcChannel< 88>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  89: calcChannel< 89>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  90: calcChannel< 90>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  91: calcChannel< 91>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  92: calcChannel< 92>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  93: calcChannel< 93>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  94: calcChannel< 94>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  95: calcChannel< 95>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  96: calcChannel< 96>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  97: calcChannel< 97>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  98: calcChannel< 98>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case  99: calcChannel< 99>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case 100: calcChannel<100>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case 101: calcChannel<101>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case 102: calcChannel<102>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case 103: calcChannel<103>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case 104: calcChannel<104>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case 105: calcChannel<105>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case 106: calcChannel<106>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case 107: calcChannel<107>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case 108: calcChannel<108>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case 109: calcChannel<109>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case 110: calcChannel<110>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case 111: calcChannel<111>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case 112: calcChannel<112>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case 113: calcChannel<113>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case 114: calcChannel<114>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case 115: calcChannel<115>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case 116: calcChannel<116>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case 117: calcChannel<117>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case 118: calcChannel<118>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case 119: calcChannel<119>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case 120: calcChannel<120>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case 121: calcChannel<121>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case 122: calcChannel<122>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case 123: calcChannel<123>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case 124: calcChannel<124>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case 125: calcChannel<125>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case 126: calcChannel<126>(ch, bufs[i], num, lfoPm, lfoAm); break;
+			case 127: calcChannel<127>(ch, bufs[i], num, lfoPm, lfoAm); break;
 			default: UNREACHABLE;
 			}
 		} else {
@@ -152,7 +152,8 @@ public:
 	Patch& getPatch(unsigned instrument, bool carrier);
 
 	template <unsigned FLAGS>
-	inline void calcChannel(Channel& ch, int* buf, unsigned num);
+	inline void calcChannel(Channel& ch, int* buf, unsigned num,
+	                        const unsigned* lfoPm, const int* lfoAm);
 
 	template<typename Archive>
 	void serialize(Archive& ar, unsigned version);
@@ -0,0 +1,202 @@
+#ifndef YMF262CORE_HH
+#define YMF262CORE_HH
+
+#include "FixedPoint.hh"
+#include "openmsx.hh"
+
+namespace openmsx {
+
+/** The sound generation part of the YMF262 (OPL3).
+ *
+ * This is the YMF262 emulation without the timers, the status register and
+ * the connection to the rest of the emulator (see the YMF262 class for
+ * those). Like for the YM2413 cores, all timing information is implicit in
+ * the order of the calls: write some registers, generate some samples, write
+ * more registers, ... This allows to test the sound generation in isolation.
+ */
+class YMF262Core
+{
+public:
+	YMF262Core();
+	YMF262Core(const YMF262Core&) = delete;
+	YMF262Core& operator=(const YMF262Core&) = delete;
+
+	void reset();
+
+	/** Write to one of the 512 registers. The timer and IRQ registers
+	 * (0x02-0x04) are only stored, they don't influence the sound.
+	 */
+	void writeReg(unsigned r, byte v);
+	byte peekReg(unsigned r) const;
+
+	/** Is OPL3 mode enabled (bit 0 of register 0x105)? */
+	bool isOPL3Mode() const { return OPL3_mode; }
+
+	/** Generate the sound output of the 18 channels (stereo, so each
+	 * buffer must have room for 2 * 'num' samples). The output is added
+	 * to the existing content of the buffers. Silent channels get a
+	 * nullptr buffer, see YM2413Core::generateChannels().
+	 */
+	void generateChannels(int** bufs, unsigned num);
+
+	/** The output of generateChannels() must still be multiplied with
+	 * this factor.
+	 */
+	int getAmplificationFactor() const { return 1 << 3; }
+
+	template<typename Archive>
+	void serialize(Archive& ar, unsigned version);
+
+public:
+	/** 16.16 fixed point type for frequency calculations */
+	using FreqIndex = FixedPoint<16>;
+
+	enum EnvelopeState {
+		EG_ATTACK, EG_DECAY, EG_SUSTAIN, EG_RELEASE, EG_OFF
+	};
+
+private:
+	class Channel;
+
+	class Slot {
+	public:
+		Slot();
+		inline int op_calc(unsigned phase, unsigned lfo_am) const;
+		inline void FM_KEYON(byte key_set);
+		inline void FM_KEYOFF(byte key_clr);
+		inline void advanceEnvelopeGenerator(unsigned egCnt);
+		inline void advancePhaseGenerator(Channel& ch, unsigned lfo_pm);
+		inline bool isSilent() const;
+		void update_ar_dr();
+		void update_rr();
+		void calc_fc(const Channel& ch);
+
+		/** Sets the amount of feedback [0..7]
+		 */
+		void setFeedbackShift(byte value) {
+			fb_shift = value ? 9 - value : 0;
+		}
+
+		template<typename Archive>
+		void serialize(Archive& ar, unsigned version);
+
+		// Phase Generator
+		FreqIndex Cnt;	// frequency counter
+		FreqIndex Incr;	// frequency counter step
+		int* connect;	// slot output pointer
+		int op1_out[2];	// slot1 output for feedback
+
+		// Envelope Generator
+		unsigned TL;	// total level: TL << 2
+		int TLL;	// adjusted now TL
+		int volume;	// envelope counter
+		int sl;		// sustain level: sl_tab[SL]
+
+		const unsigned* wavetable; // waveform select
+
+		EnvelopeState state; // EG: phase type
+		unsigned eg_m_ar;// (attack state)
+		unsigned eg_m_dr;// (decay state)
+		unsigned eg_m_rr;// (release state)
+		byte eg_sh_ar;	// (attack state)
+		byte eg_sel_ar;	// (attack state)
+		byte eg_sh_dr;	// (decay state)
+		byte eg_sel_dr;	// (decay state)
+		byte eg_sh_rr;	// (release state)
+		byte eg_sel_rr;	// (release state)
+
+		byte key;	// 0 = KEY OFF, >0 = KEY ON
+
+		byte fb_shift;	// PG: feedback shift value
+		bool CON;	// PG: connection (algorithm) type
+		bool eg_type;	// EG: percussive/non-percussive mode
+
+		// LFO
+		byte AMmask;	// LFO Amplitude Modulation enable mask
+		bool vib;	// LFO Phase Modulation enable flag (active high)
+
+		byte ar;	// attack rate: AR<<2
+		byte dr;	// decay rate:  DR<<2
+		byte rr;	// release rate:RR<<2
+		byte KSR;	// key scale rate
+		byte ksl;	// keyscale level
+		byte ksr;	// key scale rate: kcode>>KSR
+		byte mul;	// multiple: mul_tab[ML]
+	};
+
+	class Channel {
+	public:
+		Channel();
+		void chan_calc(unsigned lfo_am);
+		void chan_calc_ext(unsigned lfo_am);
+		inline void advance(unsigned egCnt, unsigned lfo_pm);
+		inline bool isSilent() const;
+		inline void skip(unsigned num, const unsigned* lfoPm, bool feedback);
+
+		template<typename Archive>
+		void serialize(Archive& ar, unsigned version);
+
+		Slot slot[2];
+
+		int block_fnum;	// block+fnum
+		FreqIndex fc;	// Freq. Increment base
+		int ksl_base;	// KeyScaleLevel Base step
+		byte kcode;	// key code (for key scaling)
+
+		// there are 12 2-operator channels which can be combined in pairs
+		// to form six 4-operator channel, they are:
+		//  0 and 3,
+		//  1 and 4,
+		//  2 and 5,
+		//  9 and 12,
+		//  10 and 13,
+		//  11 and 14
+		bool extended; // set if this channel forms up a 4op channel with
+			       // another channel (only used by first of pair of
+			       // channels, ie 0,1,2 and 9,10,11)
+	};
+
+	inline void advanceNoise();
+	inline void output(int** bufs, unsigned ch, unsigned j) const;
+
+	inline int genPhaseHighHat();
+	inline int genPhaseSnare();
+	inline int genPhaseCymbal();
+
+	void chan_calc_rhythm(unsigned lfo_am);
+	void set_mul(unsigned sl, byte v);
+	void set_ksl_tl(unsigned sl, byte v);
+	void set_ar_dr(unsigned sl, byte v);
+	void set_sl_rr(unsigned sl, byte v);
+	bool checkMuteHelper();
+
+	inline bool isExtended(unsigned ch) const;
+	inline Channel& getFirstOfPair(unsigned ch);
+	inline Channel& getSecondOfPair(unsigned ch);
+
+	int chanout[18]; // 18 channels
+
+	byte reg[512];
+	Channel channel[18];	// OPL3 chips have 18 channels
+
+	unsigned pan[18 * 4];		// channels output masks 4 per channel
+	                                //    0xffffffff = enable
+	unsigned eg_cnt;		// global envelope generator counter
+	unsigned noise_rng;		// 23 bit noise shift register
+
+	// LFO
+	using LFOAMIndex = FixedPoint< 6>;
+	using LFOPMIndex = FixedPoint<10>;
+	LFOAMIndex lfo_am_cnt;
+	LFOPMIndex lfo_pm_cnt;
+	bool lfo_am_depth;
+	byte lfo_pm_depth_range;
+
+	byte rhythm;			// Rhythm mode
+	bool nts;			// NTS (note select)
+	bool OPL3_mode;			// OPL3 extension enable flag
+};
+
+} // namespace openmsx
+
+#endif
@@ -533,28 +533,61 @@ void YMF278::generateChannels(int** bufs, unsigned num)
 			bufs[i][2 * j + 0] += (smplOut * volLeft ) >> 5;
 			bufs[i][2 * j + 1] += (smplOut * volRight) >> 5;
 
-			unsigned step = (sl.lfo_active && sl.vib)
-			              ? calcStep(sl.OCT, sl.FN, sl.compute_vib())
-			              : sl.step;
-			sl.stepptr += step;
-
-			// If there is a 4-sample loop and you advance 12 samples per step,
-			// it may exceed the end offset.
-			// This is abused by the "Lizard Star" song to generate noise at 0:52. -Valley Bell
-			if (sl.stepptr >= 0x10000) {
-				sl.sample1 = sl.sample2;
-				sl.sample2 = getSample(sl);
-				sl.pos += (sl.stepptr >> 16);
-				sl.stepptr &= 0xffff;
-				if ((uint32_t(sl.pos) + sl.endaddr) >= 0x10000) { // check position >= (negated) end address
-					sl.pos += sl.endaddr + sl.loopaddr; // This is how the actual chip does it.
-				}
-			}
+			advancePosition(sl);
+		}
+		advance();
+	}
+}
+
+void YMF278::skipChannels(unsigned num)
+{
+	// Like generateChannels(), but without calculating the output. The
+	// play positions (and the sample values for the interpolation), the
+	// LFOs and the envelopes advance exactly like when generating, so the
+	// state after skipping doesn't depend on whether the output was used.
+	if (!anyActive()) return;
+
+	for (unsigned j = 0; j < num; ++j) {
+		for (auto& sl : slots) {
+			if (sl.state != EG_OFF) advancePosition(sl);
 		}
 		advance();
 	}
 }
 
+void YMF278::advancePosition(Slot& sl)
+{
+	unsigned step = (sl.lfo_active && sl.vib)
+	              ? calcStep(sl.OCT, sl.FN, sl.compute_vib())
+	              : sl.step;
+	sl.stepptr += step;
+
+	// If there is a 4-sample loop and you advance 12 samples per step,
+	// it may exceed the end offset.
+	// This is abused by the "Lizard Star" song to generate noise at 0:52. -Valley Bell
+	if (sl.stepptr >= 0x10000) {
+		sl.sample1 = sl.sample2;
+		sl.sample2 = getSample(sl);
+		sl.pos += (sl.stepptr >> 16);
+		sl.stepptr &= 0xffff;
+		if ((uint32_t(sl.pos) + sl.endaddr) >= 0x10000) { // check position >= (negated) end address
+			sl.pos += sl.endaddr + sl.loopaddr; // This is how the actual chip does it.
+		}
+	}
+}
+
+void YMF278::logInitialState(SoundChipLogger& logger)
+{
+	if (!logger.isLogging(SoundChipLogger::MOONSOUND)) return;
+	// sample RAM that was already loaded before logging started
+	if (ram.getSize()) {
+		logger.writeDataBlock(0x87, &ram[0], ram.getSize());
+	}
+	// enable OPL4 mode (NEW2), also when that was done before logging
+	// started, otherwise the wave part can't be used
+	logger.writeInitialReg(SoundChipLogger::MOONSOUND, 1, 0x05, 0x03);
+}
+
 void YMF278::keyOnHelper(YMF278::Slot& slot)
 {
 	// Unlike FM, the envelope level is reset. (And it makes sense, because you restart the sample.)
@@ -577,6 +610,8 @@ void YMF278::keyOnHelper(YMF278::Slot& slot)
 
 void YMF278::writeReg(byte reg, byte data, EmuTime::param time)
 {
+	// VGM port 2 = wave part
+	logWrite(SoundChipLogger::MOONSOUND, 2, reg, data, time);
 	updateStream(time); // TODO optimize only for regs that directly influence sound
 	writeRegDirect(reg, data, time);
 }
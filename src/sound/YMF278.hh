@@ -89,10 +89,13 @@ private:
 
 	// SoundDevice
 	void generateChannels(int** bufs, unsigned num) override;
+	void skipChannels(unsigned num) override;
+	void logInitialState(SoundChipLogger& logger) override;
 
 	void writeRegDirect(byte reg, byte data, EmuTime::param time);
 	unsigned getRamAddress(unsigned addr) const;
 	int16_t getSample(Slot& op);
+	void advancePosition(Slot& sl);
 	void advance();
 	bool anyActive();
 	void keyOnHelper(Slot& slot);
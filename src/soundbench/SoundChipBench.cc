@@ -0,0 +1,507 @@
+// Standalone throughput benchmark for the sound chips.
+//
+// Each sound chip is instantiated on its own (not inserted in any slot, the
+// emulation never runs), it is fed a list of register writes and the time
+// spent in generateChannels() is measured, without the overhead of the rest
+// of the emulator.
+//
+// The devices only get an empty motherboard: a machine without any devices,
+// which provides the infrastructure the sound chips need (CPU for the IRQ
+// lines, scheduler, debugger, mixer). Chips that need a ROM that's not
+// installed are skipped.
+//
+// Usage: soundbench [-trace <file>] [-repeat <n>] [-check <file>] [<chip>...]
+//
+// The output of each chip is also hashed. This is not a regression test
+// (those are the golden-output unit tests, e.g. YMF262_test), but it allows
+// to verify that an optimization didn't change the output for a particular
+// trace: store the output of a run before the change and pass it to -check
+// after the change (with the same trace and -repeat count). A hash mismatch
+// is reported and gives a non-zero exit code.
+//
+// The pseudo chip 'BlipBuffer' measures the band-limited synthesis that is
+// used by the 'blip' resampler and the DACs on its own, with many amplitude
+// changes per output sample (e.g. PSG sample playback).
+//
+// Without -trace a built-in pseudo random register trace is used. A trace
+// file has the same format as the raw logs of the 'soundchip_log' command,
+// so real music can be recorded with 'soundchip_log start -raw ...'.
+//
+// Build with the "soundbench" flavour (make OPENMSX_FLAVOUR=soundbench) or
+// with the 'soundbench' meson target.
+
+#include "Reactor.hh"
+#include "MSXMotherBoard.hh"
+#include "HardwareConfig.hh"
+#include "DeviceConfig.hh"
+#include "XMLElement.hh"
+#include "GlobalCommandController.hh"
+#include "AY8910.hh"
+#include "AY8910Periphery.hh"
+#include "BlipBuffer.hh"
+#include "MSXAudio.hh"
+#include "MSXMixer.hh"
+#include "SCC.hh"
+#include "SN76489.hh"
+#include "SoundDevice.hh"
+#include "VLM5030.hh"
+#include "YM2151.hh"
+#include "YM2413.hh"
+#include "YMF262.hh"
+#include "YMF278.hh"
+#include "MSXException.hh"
+#include "StringOp.hh"
+#include "Thread.hh"
+#include "Timer.hh"
+#include "ranges.hh"
+#include "stl.hh"
+#include "strCat.hh"
+#include <algorithm>
+#include <cassert>
+#include <cinttypes>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+namespace openmsx {
+
+struct TraceEvent
+{
+	double time; // in seconds
+	byte port;
+	byte reg;
+	byte value;
+};
+
+struct RegRange
+{
+	byte port;
+	byte first;
+	byte last;
+};
+
+struct BenchChip
+{
+	string name;       // as shown in the output
+	string traceName;  // chip name in the trace file
+	unsigned portMask; // which ports (of the trace) go to this chip
+	vector<RegRange> randomRegs; // used for the built-in trace
+
+	std::unique_ptr<XMLElement> config; // must outlive the device
+	std::shared_ptr<void> owner;
+	SoundDevice* device = nullptr;
+	std::function<void(byte port, byte reg, byte value, EmuTime::param time)> write;
+
+	vector<TraceEvent> trace;
+	uint64_t hash = 0xCBF29CE484222325ull; // FNV-1a
+	uint64_t samples = 0;
+	uint64_t duration = 0; // in us, only the time spent in generateChannels()
+};
+
+/** Generate 'num' samples and add them to the hash. */
+static void generate(BenchChip& chip, unsigned num, vector<int>& data)
+{
+	auto& device = *chip.device;
+	unsigned numChannels = device.getNumChannels();
+	unsigned stereo = device.isStereo() ? 2 : 1;
+	while (num) {
+		unsigned n = std::min(num, 4096u);
+		unsigned pitch = n * stereo;
+		data.assign(numChannels * pitch, 0);
+		int* bufs[SoundDevice::MAX_CHANNELS];
+		for (unsigned i = 0; i < numChannels; ++i) {
+			bufs[i] = &data[i * pitch];
+		}
+
+		auto start = Timer::getTime();
+		device.generateRawChannels(bufs, n);
+		chip.duration += Timer::getTime() - start;
+
+		// a nullptr buffer counts as silence
+		for (unsigned i = 0; i < numChannels; ++i) {
+			for (unsigned j = 0; j < pitch; ++j) {
+				uint32_t s = bufs[i] ? bufs[i][j] : 0;
+				for (int b = 0; b < 4; ++b) {
+					chip.hash ^= (s >> (8 * b)) & 0xFF;
+					chip.hash *= 0x100000001B3ull;
+				}
+			}
+		}
+		chip.samples += n;
+		num -= n;
+	}
+}
+
+static XMLElement createConfig(string_view name)
+{
+	XMLElement result(name);
+	result.addAttribute("id", name);
+	result.addChild("sound").addChild("volume", "32767");
+	return result;
+}
+
+struct NoPeriphery final : AY8910Periphery {};
+static NoPeriphery noPeriphery;
+
+// Store the device in the chip and return a reference to it.
+template<typename T>
+static T& own(BenchChip& chip, std::unique_ptr<T> device)
+{
+	auto& result = *device;
+	chip.owner = std::shared_ptr<T>(std::move(device));
+	return result;
+}
+
+static vector<BenchChip> createChips(MSXMotherBoard& board)
+{
+	const auto& hwConf = *board.getMachineConfig();
+	auto time = board.getCurrentTime();
+	auto& mixer = board.getMSXMixer();
+	vector<BenchChip> chips;
+
+	// A chip that cannot be created (e.g. because its ROM is not
+	// installed) is reported and skipped.
+	auto create = [&](string name, string traceName, unsigned portMask,
+	                  vector<RegRange> regs, auto init) {
+		BenchChip chip;
+		chip.name = std::move(name);
+		chip.traceName = std::move(traceName);
+		chip.portMask = portMask;
+		chip.randomRegs = std::move(regs);
+		chip.config = std::make_unique<XMLElement>(createConfig(chip.name));
+		try {
+			vector<SoundDevice*> before;
+			mixer.forEachDevice([&](SoundDevice& d) { before.push_back(&d); });
+			init(chip, DeviceConfig(hwConf, *chip.config));
+			// The SoundDevice base class of some chips is private, so
+			// get it from the mixer: it's the first device registered
+			// by 'init' (e.g. MSXAudio registers the Y8950 and a DAC).
+			mixer.forEachDevice([&](SoundDevice& d) {
+				if (!chip.device && !contains(before, &d)) chip.device = &d;
+			});
+			assert(chip.device);
+			chips.push_back(std::move(chip));
+		} catch (MSXException& e) {
+			std::cerr << chip.name << ": skipped: " << e.getMessage() << '\n';
+		}
+	};
+
+	create("PSG", "PSG", 1, {{0, 0x00, 0x0D}},
+	       [&](BenchChip& chip, const DeviceConfig& config) {
+		auto& ay = own(chip, std::make_unique<AY8910>(
+			chip.name, noPeriphery, config, time));
+		chip.write = [&ay](byte /*port*/, byte reg, byte value, EmuTime::param t) {
+			ay.writeRegister(reg, value, t);
+		};
+	});
+	create("SCC", "SCC", 0x3F, {{0, 0x00, 0x7F}, {1, 0x00, 0x09},
+	                            {2, 0x00, 0x04}, {3, 0x00, 0x00}, {5, 0x00, 0x00}},
+	       [&](BenchChip& chip, const DeviceConfig& config) {
+		auto& scc = own(chip, std::make_unique<SCC>(chip.name, config, time));
+		// Convert back from the VGM ports, see SCC::logFreqVol(). Port 4
+		// (SCC+ waveform) switches the chip to SCC+ mode.
+		auto plus = std::make_shared<bool>(false);
+		chip.write = [&scc, plus](byte port, byte reg, byte value, EmuTime::param t) {
+			if ((port == 4) && !*plus) {
+				scc.setChipMode(SCC::SCC_plusmode);
+				*plus = true;
+			}
+			byte freqVol = *plus ? 0xA0 : 0x80;
+			switch (port) {
+			case 0: case 4: scc.writeMem(reg, value, t); break;
+			case 1: scc.writeMem(freqVol + (reg & 0x0F), value, t); break;
+			case 2: scc.writeMem(freqVol + 0x0A + (reg & 0x07), value, t); break;
+			case 3: scc.writeMem(freqVol + 0x0F, value, t); break;
+			case 5: scc.writeMem(*plus ? 0xC0 : 0xE0, value, t); break;
+			}
+		};
+	});
+	for (bool alternative : {false, true}) {
+		create(alternative ? "MSX-Music-Burczynski" : "MSX-Music-Okazaki",
+		       "MSX-Music", 1, {{0, 0x00, 0x38}},
+		       [&](BenchChip& chip, const DeviceConfig& config) {
+			if (alternative) chip.config->addChild("alternative", "true");
+			auto& ym = own(chip, std::make_unique<YM2413>(chip.name, config));
+			chip.write = [&ym](byte /*port*/, byte reg, byte value, EmuTime::param t) {
+				ym.writeReg(reg, value, t);
+			};
+		});
+	}
+	create("MSX-Audio", "MSX-Audio", 1, {{0, 0x00, 0xC8}},
+	       [&](BenchChip& chip, const DeviceConfig& config) {
+		auto& audio = own(chip, std::make_unique<MSXAudio>(config));
+		chip.write = [&audio](byte /*port*/, byte reg, byte value, EmuTime::param t) {
+			audio.writeIO(0, reg,   t);
+			audio.writeIO(1, value, t);
+		};
+	});
+	create("OPL3", "OPL3", 3, {{0, 0x00, 0xF5}, {1, 0x00, 0xF5}},
+	       [&](BenchChip& chip, const DeviceConfig& config) {
+		auto& opl3 = own(chip, std::make_unique<YMF262>(chip.name, config, false));
+		chip.write = [&opl3](byte port, byte reg, byte value, EmuTime::param t) {
+			opl3.writeReg512((port << 8) | reg, value, t);
+		};
+	});
+	create("OPL4-wave", "Moonsound", 4, {{2, 0x02, 0xF9}},
+	       [&](BenchChip& chip, const DeviceConfig& config) {
+		auto& rom = chip.config->addChild("rom");
+		rom.addChild("sha1", "32760893ce06dbe3930627755ba065cc3d8ec6ca");
+		rom.addChild("filename", "yrw801.rom");
+		auto& opl4 = own(chip, std::make_unique<YMF278>(chip.name, 640, config));
+		chip.write = [&opl4](byte /*port*/, byte reg, byte value, EmuTime::param t) {
+			opl4.writeReg(reg, value, t);
+		};
+	});
+	create("OPM", "OPM", 1, {{0, 0x01, 0xFF}},
+	       [&](BenchChip& chip, const DeviceConfig& config) {
+		auto& opm = own(chip, std::make_unique<YM2151>(
+			chip.name, "YM2151", config, time));
+		chip.write = [&opm](byte /*port*/, byte reg, byte value, EmuTime::param t) {
+			opm.writeReg(reg, value, t);
+		};
+	});
+	// there's no port/register for this chip, only the value matters
+	create("SN76489", "SN76489", 1, {{0, 0x00, 0x00}},
+	       [&](BenchChip& chip, const DeviceConfig& config) {
+		auto& dcsg = own(chip, std::make_unique<SN76489>(config));
+		chip.write = [&dcsg](byte /*port*/, byte /*reg*/, byte value, EmuTime::param t) {
+			dcsg.write(value, t);
+		};
+	});
+	// port 0: data, port 1: control (RST/VCU/ST pins)
+	create("VLM5030", "VLM5030", 3, {{0, 0x00, 0x00}, {1, 0x00, 0x00}},
+	       [&](BenchChip& chip, const DeviceConfig& config) {
+		auto& vlm = own(chip, std::make_unique<VLM5030>(
+			chip.name, "VLM5030", "", config));
+		chip.write = [&vlm](byte port, byte /*reg*/, byte value, EmuTime::param t) {
+			if (port == 0) {
+				vlm.writeData(value);
+			} else {
+				vlm.writeControl(value, t);
+			}
+		};
+	});
+	return chips;
+}
+
+static void loadTrace(const string& filename, vector<BenchChip>& chips)
+{
+	std::ifstream file(filename);
+	if (!file) throw MSXException("Couldn't open trace file: ", filename);
+	string line;
+	unsigned lineNum = 0;
+	while (std::getline(file, line)) {
+		++lineNum;
+		double time;
+		char name[64];
+		unsigned port, reg, value;
+		int n = sscanf(line.c_str(), "%lf %63s %u %x %x",
+		               &time, name, &port, &reg, &value);
+		if ((n == 2) && (string_view(name) == "marker")) continue;
+		if (n != 5) {
+			throw MSXException("Syntax error in trace file ", filename,
+			                   " line ", lineNum);
+		}
+		// the FM part of the Moonsound is an OPL3 as well
+		string_view traceName = ((string_view(name) == "Moonsound") && (port < 2))
+		                      ? "OPL3" : name;
+		for (auto& chip : chips) {
+			if ((chip.traceName == traceName) && ((chip.portMask >> port) & 1)) {
+				chip.trace.push_back({time, byte(port), byte(reg), byte(value)});
+			}
+		}
+	}
+}
+
+static void createRandomTrace(BenchChip& chip)
+{
+	// Raw mt19937 output is the same on all platforms (the distributions
+	// are not), so the hash of the output can be compared between hosts.
+	std::mt19937 gen(12345);
+	double time = 0.0;
+	for (int i = 0; i < 20000; ++i) {
+		const auto& range = chip.randomRegs[gen() % chip.randomRegs.size()];
+		byte reg = range.first + gen() % (range.last - range.first + 1);
+		byte value = gen() & 0xFF;
+		chip.trace.push_back({time, range.port, reg, value});
+		time += (gen() % 1000) / 1000000.0; // 0-1ms
+	}
+}
+
+static void run(BenchChip& chip, EmuTime::param time, vector<int>& data)
+{
+	double rate = chip.device->getInputRate();
+	uint64_t start = chip.samples;
+	for (const auto& event : chip.trace) {
+		auto target = start + uint64_t(event.time * rate);
+		if (target > chip.samples) {
+			generate(chip, unsigned(target - chip.samples), data);
+		}
+		chip.write(event.port, event.reg, event.value, time);
+	}
+	// also render 100ms after the last write
+	generate(chip, unsigned(rate / 10), data);
+}
+
+// Hashes from the output of a previous run, see -check.
+using Expected = std::map<string, uint64_t>;
+
+static Expected loadExpected(const string& filename)
+{
+	std::ifstream file(filename);
+	if (!file) throw MSXException("Couldn't open file: ", filename);
+	Expected result;
+	string line;
+	while (std::getline(file, line)) {
+		char name[64];
+		uint64_t hash;
+		if (sscanf(line.c_str(), "%63s %" SCNx64, name, &hash) == 2) {
+			result[name] = hash;
+		}
+	}
+	return result;
+}
+
+/** Print the result, returns false iff the hash doesn't match the expected
+  * value (chips that are not in 'expected' always match). */
+static bool report(const string& name, uint64_t hash, uint64_t samples,
+                   uint64_t duration, const Expected& expected)
+{
+	double seconds = duration / 1000000.0;
+	printf("%-22s %016" PRIx64 " %10" PRIu64 " samples %12.0f samples/s\n",
+	       name.c_str(), hash, samples,
+	       seconds > 0.0 ? samples / seconds : 0.0);
+	auto it = expected.find(name);
+	if ((it != expected.end()) && (it->second != hash)) {
+		printf("%-22s MISMATCH, expected %016" PRIx64 "\n",
+		       name.c_str(), it->second);
+		return false;
+	}
+	return true;
+}
+
+static bool benchBlip(unsigned repeat, const Expected& expected)
+{
+	auto blip = std::make_unique<BlipBuffer>(); // too big for the stack
+	std::mt19937 gen(12345);
+	vector<BlipBuffer::TimeIndex> times;
+	vector<int> deltas;
+	vector<int> out(1024);
+	uint64_t hash = 0xCBF29CE484222325ull; // FNV-1a
+	uint64_t samples = 0;
+	uint64_t duration = 0;
+	for (unsigned r = 0; r < repeat; ++r) {
+		for (int i = 0; i < 20000; ++i) {
+			// 0-8 amplitude changes per output sample
+			unsigned num = 1 + gen() % 1024;
+			unsigned numDeltas = gen() % (8 * num + 1);
+			times.clear();
+			deltas.clear();
+			for (unsigned j = 0; j < numDeltas; ++j) {
+				times.push_back(BlipBuffer::TimeIndex::create(
+					gen() % (num << BlipBuffer::BLIP_PHASE_BITS)));
+				deltas.push_back(int(gen() % 0x10000) - 0x8000);
+			}
+			ranges::sort(times);
+
+			auto start = Timer::getTime();
+			blip->addDeltas(times.data(), deltas.data(), numDeltas);
+			bool nonZero = blip->readSamples<1>(out.data(), num);
+			duration += Timer::getTime() - start;
+
+			for (unsigned j = 0; j < num; ++j) {
+				uint32_t s = nonZero ? out[j] : 0;
+				for (int b = 0; b < 4; ++b) {
+					hash ^= (s >> (8 * b)) & 0xFF;
+					hash *= 0x100000001B3ull;
+				}
+			}
+			samples += num;
+		}
+	}
+	return report("BlipBuffer", hash, samples, duration, expected);
+}
+
+static int main(int argc, char** argv)
+{
+	string traceFile;
+	unsigned repeat = 1;
+	Expected expected;
+	vector<string> selected;
+	for (int i = 1; i < argc; ++i) {
+		string_view arg = argv[i];
+		if ((arg == "-trace") && (i + 1 < argc)) {
+			traceFile = argv[++i];
+		} else if ((arg == "-repeat") && (i + 1 < argc)) {
+			repeat = std::max(1, StringOp::stringToInt(argv[++i]));
+		} else if ((arg == "-check") && (i + 1 < argc)) {
+			expected = loadExpected(argv[++i]);
+		} else if (arg.starts_with("-")) {
+			std::cerr << "Usage: " << argv[0] << " [-trace <file>] "
+			             "[-repeat <n>] [-check <file>] [<chip>...]\n";
+			return 1;
+		} else {
+			selected.push_back(arg.str());
+		}
+	}
+
+	bool ok = true;
+	if (selected.empty() || contains(selected, "BlipBuffer")) {
+		ok &= benchBlip(repeat, expected);
+		if (selected.size() == 1) return ok ? 0 : 1; // no motherboard needed
+	}
+
+	Thread::setMainThread();
+	Reactor reactor;
+	reactor.init();
+	reactor.getGlobalCommandController().executeCommand("set sound_driver null");
+	auto board = reactor.createEmptyMotherBoard();
+	// must be destroyed after the chips, but before the motherboard
+	auto machineConfig = HardwareConfig::createEmptyMachineConfig(*board);
+	board->setMachineConfig(machineConfig.get());
+
+	vector<BenchChip> chips = createChips(*board);
+	if (!selected.empty()) {
+		chips.erase(std::remove_if(chips.begin(), chips.end(),
+			[&](const BenchChip& chip) { return !contains(selected, chip.name); }),
+			chips.end());
+	}
+	if (!traceFile.empty()) {
+		loadTrace(traceFile, chips);
+	} else {
+		for (auto& chip : chips) createRandomTrace(chip);
+	}
+
+	auto time = board->getCurrentTime();
+	vector<int> data;
+	for (auto& chip : chips) {
+		if (chip.trace.empty()) continue;
+		for (unsigned r = 0; r < repeat; ++r) {
+			run(chip, time, data);
+		}
+		ok &= report(chip.name, chip.hash, chip.samples, chip.duration,
+		             expected);
+	}
+	return ok ? 0 : 1;
+}
+
+} // namespace openmsx
+
+int main(int argc, char** argv)
+{
+	try {
+		return openmsx::main(argc, argv);
+	} catch (openmsx::MSXException& e) {
+		std::cerr << "Error: " << e.getMessage() << '\n';
+		return 1;
+	}
+}
@@ -0,0 +1,82 @@
+#include "catch.hpp"
+#include "BinaryCliCommParser.hh"
+#include <string>
+#include <vector>
+
+using namespace std;
+using Batch = BinaryCliCommParser::Batch;
+
+static string request(const Batch& commands)
+{
+	string body;
+	BinaryCliCommParser::appendU32(body, uint32_t(commands.size()));
+	for (auto& c : commands) {
+		BinaryCliCommParser::appendString(body, c.data(), c.size());
+	}
+	string result;
+	BinaryCliCommParser::appendU32(result, uint32_t(body.size()));
+	return result + body;
+}
+
+static vector<Batch> parse(const string& stream, size_t chunk, bool& ok)
+{
+	vector<Batch> result;
+	BinaryCliCommParser parser([&](Batch&& b) { result.push_back(std::move(b)); });
+	ok = true;
+	for (size_t i = 0; ok && (i < stream.size()); i += chunk) {
+		size_t n = std::min(chunk, stream.size() - i);
+		ok = parser.parse(stream.data() + i, n);
+	}
+	return result;
+}
+
+TEST_CASE("BinaryCliCommParser")
+{
+	bool ok;
+	SECTION("single request") {
+		CHECK(parse(request({"foo"}), 100, ok) == vector<Batch>{{"foo"}});
+		CHECK(ok);
+		CHECK(parse(request({}), 100, ok) == vector<Batch>{{}});
+		CHECK(ok);
+	}
+	SECTION("batch") {
+		Batch batch = {"peek 0", "", "debug read memory 0x4000",
+		               string("a\0b<&>", 6)};
+		CHECK(parse(request(batch), 100, ok) == vector<Batch>{batch});
+		CHECK(ok);
+	}
+	SECTION("split over multiple reads") {
+		string stream = request({"foo", "bar"}) + request({"baz"});
+		for (size_t chunk : {1, 2, 3, 5, 7}) {
+			CHECK(parse(stream, chunk, ok) ==
+			      (vector<Batch>{{"foo", "bar"}, {"baz"}}));
+			CHECK(ok);
+		}
+	}
+	SECTION("incomplete") {
+		string stream = request({"foo"});
+		stream.pop_back();
+		CHECK(parse(stream, 100, ok).empty());
+		CHECK(ok);
+	}
+	SECTION("malformed") {
+		// command length beyond the end of the request
+		string stream;
+		BinaryCliCommParser::appendU32(stream, 8);
+		BinaryCliCommParser::appendU32(stream, 1);
+		BinaryCliCommParser::appendU32(stream, 5);
+		parse(stream, 100, ok);
+		CHECK(!ok);
+		// trailing bytes in the request
+		stream = request({"foo"});
+		stream[0] += 1;
+		stream += 'x';
+		parse(stream, 100, ok);
+		CHECK(!ok);
+		// too large
+		stream.clear();
+		BinaryCliCommParser::appendU32(stream, 0xFFFFFFFF);
+		parse(stream, 100, ok);
+		CHECK(!ok);
+	}
+}
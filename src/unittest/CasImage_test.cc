@@ -0,0 +1,87 @@
+#include "catch.hpp"
+#include "CasImage.hh"
+#include "EmuDuration.hh"
+#include "MSXException.hh"
+#include "stl.hh"
+#include <vector>
+
+using namespace openmsx;
+
+static const byte CAS_HEADER[8] = { 0x1F,0xA6,0xDE,0xBA,0xCC,0x13,0x7D,0x74 };
+
+// A binary file: a block with the file type and name, and a block with the
+// start, end and execute address followed by the data.
+static std::vector<byte> binaryCas(const std::vector<byte>& payload)
+{
+	std::vector<byte> result;
+	append(result, CAS_HEADER);
+	result.insert(end(result), 10, 0xD0);
+	append(result, {'T', 'E', 'S', 'T', ' ', ' '});
+	append(result, CAS_HEADER);
+	append(result, {0x00, 0xC0, 0xFF, 0xC0, 0x00, 0xC0});
+	append(result, payload);
+	return result;
+}
+
+// Read a block through the fast-load interface, like the trapped TAPIN does.
+// Between the calls time advances by the given delays (which are all shorter
+// than one byte: 44 samples at 4 x 3744Hz, about 2.9ms).
+static std::vector<byte> readBlock(const CasImage& cas, EmuTime& time,
+                                   const std::vector<unsigned>& delaysUs)
+{
+	std::vector<byte> result;
+	size_t n = 0;
+	byte value;
+	while (true) {
+		time += EmuDuration::usec(delaysUs[n++ % delaysUs.size()]);
+		if (!cas.readByte(time, value)) break;
+		result.push_back(value);
+	}
+	return result;
+}
+
+TEST_CASE("CasImage: fast-load")
+{
+	std::vector<byte> payload;
+	for (int i = 0; i < 200; ++i) payload.push_back(byte(i * 7 + 3));
+	std::vector<byte> buf = binaryCas(payload);
+	CasImage cas(buf);
+	CHECK(cas.getFirstFileType() == CassetteImage::BINARY);
+
+	std::vector<byte> header(10, 0xD0);
+	append(header, {'T', 'E', 'S', 'T', ' ', ' '});
+	std::vector<byte> data = {0x00, 0xC0, 0xFF, 0xC0, 0x00, 0xC0};
+	append(data, payload);
+
+	SECTION("no delay") {
+		EmuTime time = EmuTime::zero;
+		REQUIRE(cas.seekBlock(time));
+		CHECK(readBlock(cas, time, {0}) == header);
+		REQUIRE(cas.seekBlock(time));
+		CHECK(readBlock(cas, time, {0}) == data);
+		CHECK(!cas.seekBlock(time));
+	}
+	SECTION("time advances between the calls") {
+		// e.g. interrupts between the TAPIN calls, or the time between
+		// TAPION and the first TAPIN
+		EmuTime time = EmuTime::zero;
+		REQUIRE(cas.seekBlock(time));
+		CHECK(readBlock(cas, time, {2000, 1, 250, 2500}) == header);
+		REQUIRE(cas.seekBlock(time));
+		CHECK(readBlock(cas, time, {1000, 2400, 0, 17}) == data);
+		CHECK(!cas.seekBlock(time));
+	}
+	SECTION("a delay longer than one byte skips a byte") {
+		EmuTime time = EmuTime::zero;
+		REQUIRE(cas.seekBlock(time));
+		auto result = readBlock(cas, time, {3000});
+		CHECK(result.size() < header.size());
+		CHECK(result.back() == header.back());
+	}
+}
+
+TEST_CASE("CasImage: invalid")
+{
+	std::vector<byte> buf(100, 0x00);
+	CHECK_THROWS_AS(CasImage(buf), MSXException);
+}
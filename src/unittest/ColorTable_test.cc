@@ -0,0 +1,90 @@
+#include "catch.hpp"
+#include "ColorTable.hh"
+#include "BitmapConverter.hh"
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using namespace openmsx;
+
+// Like SDL_MapRGB() for a 32bpp ARGB surface.
+static uint32_t mapRGB(int r, int g, int b)
+{
+	return 0xFF000000 | (r << 16) | (g << 8) | b;
+}
+// Like SDL_MapRGB() for a 16bpp RGB565 surface.
+static uint16_t mapRGB16(int r, int g, int b)
+{
+	return ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
+}
+
+static int intensity(int i, int levels)
+{
+	return int(255 * (i / float(levels - 1)));
+}
+
+// Compare fillColorTable() with mapping every color separately.
+template<typename Pixel, typename Map>
+static void test(int levels, Pixel key, Pixel clash, Map map)
+{
+	std::vector<Pixel> expected;
+	for (int r = 0; r < levels; ++r) {
+		for (int g = 0; g < levels; ++g) {
+			for (int b = 0; b < levels; ++b) {
+				Pixel p = map(intensity(r, levels),
+				              intensity(g, levels),
+				              intensity(b, levels));
+				expected.push_back((p != key) ? p : clash);
+			}
+		}
+	}
+
+	Pixel r[32], g[32], b[32];
+	for (int i = 0; i < levels; ++i) {
+		r[i] = map(intensity(i, levels), 0, 0);
+		g[i] = map(0, intensity(i, levels), 0);
+		b[i] = map(0, 0, intensity(i, levels));
+	}
+	std::vector<Pixel> actual(levels * levels * levels);
+	fillColorTable(actual.data(), r, levels, g, levels, b, levels, key, clash);
+	CHECK(actual == expected);
+}
+
+TEST_CASE("ColorTable: fillColorTable")
+{
+	test<uint32_t>( 8, 0, 0, mapRGB);
+	test<uint32_t>(32, 0, 0, mapRGB);
+	// the 16bpp key color (0x0001) is produced by this format
+	test<uint16_t>( 8, 1, 0, mapRGB16);
+	test<uint16_t>(32, 1, 0, mapRGB16);
+}
+
+TEST_CASE("ColorTable: BitmapConverter palette update")
+{
+	// Palette animation in Graphic4: a different palette entry changes
+	// before each line. One converter invalidates its complete
+	// double-pixel palette, the other only the changed entry.
+	uint32_t palette[32];
+	for (int i = 0; i < 32; ++i) palette[i] = mapRGB(i * 8, 255 - i * 8, i);
+	std::vector<uint32_t> pal256(256), pal32768(32768);
+	BitmapConverter<uint32_t> full       (palette, pal256.data(), pal32768.data());
+	BitmapConverter<uint32_t> incremental(palette, pal256.data(), pal32768.data());
+	full       .setDisplayMode(DisplayMode(0x06, 0x00, 0x00));
+	incremental.setDisplayMode(DisplayMode(0x06, 0x00, 0x00));
+
+	std::mt19937 gen(1234);
+	byte vram[128];
+	uint32_t expected[256], actual[256];
+	for (int y = 0; y < 212; ++y) {
+		for (auto& v : vram) v = gen() & 0xFF;
+		int index = y & 15;
+		palette[index] = palette[index + 16] = mapRGB(y, 255 - y, index);
+		full.palette16Changed();
+		incremental.palette16Changed(index);
+		full       .convertLine(expected, vram);
+		incremental.convertLine(actual,   vram);
+		CHECK(std::equal(std::begin(actual), std::end(actual),
+		                 std::begin(expected)));
+	}
+}
@@ -0,0 +1,123 @@
+#include "catch.hpp"
+#include "MemorySearch.hh"
+#include <random>
+#include <tuple>
+#include <vector>
+
+using namespace openmsx;
+using namespace std;
+using Candidates = vector<tuple<unsigned, unsigned, unsigned>>;
+
+static Candidates getCandidates(const MemorySearch& search)
+{
+	Candidates result;
+	search.forEachCandidate(size_t(-1), [&](unsigned addr, unsigned o, unsigned n) {
+		result.emplace_back(addr, o, n);
+	});
+	return result;
+}
+
+static bool compare(int n, int b, MemorySearch::Op op)
+{
+	switch (op) {
+		case MemorySearch::EQUAL:         return n == b;
+		case MemorySearch::NOT_EQUAL:     return n != b;
+		case MemorySearch::LESS:          return n <  b;
+		case MemorySearch::GREATER:       return n >  b;
+		case MemorySearch::LESS_EQUAL:    return n <= b;
+		case MemorySearch::GREATER_EQUAL: return n >= b;
+	}
+	return false;
+}
+
+static unsigned get(const vector<byte>& v, unsigned addr, bool word)
+{
+	return word ? (v[addr] | (v[addr + 1] << 8)) : v[addr];
+}
+
+// Straightforward implementation to compare the optimized one against.
+static Candidates reference(const Candidates& prev,
+                            const vector<byte>& oldMem, const vector<byte>& newMem,
+                            bool word, bool useOld, MemorySearch::Op op, int value)
+{
+	int mask = word ? 0xFFFF : 0xFF;
+	bool wrap = (op == MemorySearch::EQUAL) || (op == MemorySearch::NOT_EQUAL);
+	Candidates result;
+	for (auto& c : prev) {
+		unsigned addr = get<0>(c);
+		unsigned o = get(oldMem, addr, word);
+		unsigned n = get(newMem, addr, word);
+		int b = value;
+		if (useOld) {
+			b += o;
+			if (wrap) b &= mask;
+		}
+		if (compare(n, b, op)) result.emplace_back(addr, o, n);
+	}
+	return result;
+}
+
+static vector<byte> randomMem(mt19937& gen, size_t size, int range)
+{
+	uniform_int_distribution<int> dist(0, range - 1);
+	vector<byte> result(size);
+	for (auto& b : result) b = byte(dist(gen));
+	return result;
+}
+
+TEST_CASE("MemorySearch: start")
+{
+	MemorySearch search;
+	CHECK(!search.isActive());
+	search.start(vector<byte>{1, 2, 3}, false);
+	CHECK(search.isActive());
+	CHECK(search.count() == 3);
+	CHECK(getCandidates(search) == Candidates{{0, 1, 1}, {1, 2, 2}, {2, 3, 3}});
+	search.start(vector<byte>{1, 2, 3}, true);
+	CHECK(search.count() == 2);
+	CHECK(getCandidates(search) == Candidates{{0, 0x201, 0x201}, {1, 0x302, 0x302}});
+	search.clear();
+	CHECK(!search.isActive());
+	CHECK(search.count() == 0);
+}
+
+TEST_CASE("MemorySearch: filters")
+{
+	static const MemorySearch::Op ops[] = {
+		MemorySearch::EQUAL, MemorySearch::NOT_EQUAL,
+		MemorySearch::LESS, MemorySearch::GREATER,
+		MemorySearch::LESS_EQUAL, MemorySearch::GREATER_EQUAL,
+	};
+	mt19937 gen(1234);
+	// sizes around multiples of 64 (one bitmap word) and 16 (one SSE register)
+	for (size_t size : {1, 15, 16, 63, 64, 65, 200, 1000}) {
+		for (bool word : {false, true}) {
+			for (auto op : ops) {
+				for (int value : {-1, 0, 1, 2, 255}) {
+					// small range, so that the filters don't
+					// eliminate everything in the first step
+					auto mem = randomMem(gen, size, 4);
+					MemorySearch search;
+					search.start(mem, word);
+					auto expected = getCandidates(search);
+					for (int step = 0; step < 3; ++step) {
+						auto newMem = randomMem(gen, size, 4);
+						bool useOld = step != 1;
+						// filterValue() only takes unsigned values
+						int v = (useOld || (value >= 0)) ? value : 3;
+						expected = reference(expected, mem, newMem, word,
+						                     useOld, op, v);
+						if (useOld) {
+							search.filterOld(newMem, op, v);
+						} else {
+							search.filterValue(newMem, op, v);
+						}
+						CHECK(getCandidates(search) == expected);
+						CHECK(search.count() == expected.size());
+						mem = newMem;
+					}
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,164 @@
+#include "catch.hpp"
+#include "serialize.hh"
+#include "serialize_stl.hh"
+#include "DeltaBlock.hh"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace openmsx;
+
+// Round-trip a few object shapes that are typical for MSX devices through the
+// in-memory archives (as used for the reverse snapshots):
+// - 'RAM': a device that is mostly one large memory block (blob).
+// - 'registers': a device with many small scalar members.
+// - 'linked': many small objects that have an ID and refer to each other by
+//   pointer, plus a shared object that is serialized only once. This
+//   exercises the pointer/ID bookkeeping in the archives.
+
+struct Ram {
+	std::vector<byte> data = std::vector<byte>(64 * 1024);
+
+	template<typename Archive> void serialize(Archive& ar, unsigned /*version*/)
+	{
+		ar.serialize_blob("ram", data.data(), data.size());
+	}
+	bool operator==(const Ram& o) const { return data == o.data; }
+};
+
+struct Registers {
+	uint8_t regs8[32];
+	uint16_t regs16[8];
+	int counters[8];
+	bool flags[8];
+
+	template<typename Archive> void serialize(Archive& ar, unsigned /*version*/)
+	{
+		for (auto& r : regs8)    ar.serialize("reg8", r);
+		for (auto& r : regs16)   ar.serialize("reg16", r);
+		for (auto& c : counters) ar.serialize("counter", c);
+		for (auto& f : flags)    ar.serialize("flag", f);
+	}
+	bool operator==(const Registers& o) const {
+		return std::equal(std::begin(regs8), std::end(regs8), std::begin(o.regs8)) &&
+		       std::equal(std::begin(regs16), std::end(regs16), std::begin(o.regs16)) &&
+		       std::equal(std::begin(counters), std::end(counters), std::begin(o.counters)) &&
+		       std::equal(std::begin(flags), std::end(flags), std::begin(o.flags));
+	}
+};
+
+struct Shared {
+	int value = 0;
+	template<typename Archive> void serialize(Archive& ar, unsigned /*version*/)
+	{
+		ar.serialize("value", value);
+	}
+};
+
+struct Node {
+	int value = 0;
+	Node* other = nullptr;
+	Shared* shared = nullptr;
+
+	template<typename Archive> void serialize(Archive& ar, unsigned /*version*/)
+	{
+		ar.serialize("value", value);
+		ar.serializeOnlyOnce("shared", *shared);
+	}
+};
+
+struct Link {
+	Node* node;
+	template<typename Archive> void serialize(Archive& ar, unsigned /*version*/)
+	{
+		ar.serialize("node", node);
+	}
+};
+
+struct Linked {
+	Shared shared;
+	std::vector<Node> nodes;
+
+	template<typename Archive> void serialize(Archive& ar, unsigned /*version*/)
+	{
+		if (ar.isLoader()) {
+			int n;
+			ar.serialize("size", n);
+			nodes.resize(n);
+			for (auto& node : nodes) node.shared = &shared;
+		} else {
+			int n = int(nodes.size());
+			ar.serialize("size", n);
+		}
+		for (auto& node : nodes) ar.serializeWithID("node", node);
+		// the 'other' pointers refer to nodes that already have an ID
+		for (auto& node : nodes) {
+			Link link{node.other};
+			ar.serialize("link", link);
+			node.other = link.node;
+		}
+	}
+	bool operator==(const Linked& o) const {
+		if (shared.value != o.shared.value) return false;
+		if (nodes.size() != o.nodes.size()) return false;
+		for (size_t i = 0; i < nodes.size(); ++i) {
+			if (nodes[i].value != o.nodes[i].value) return false;
+			if ((nodes[i].other - nodes.data()) !=
+			    (o.nodes[i].other - o.nodes.data())) return false;
+			if (nodes[i].shared != &shared) return false;
+		}
+		return true;
+	}
+};
+
+template<typename T>
+static void roundTrip(const T& original, T& loaded)
+{
+	LastDeltaBlocks lastDeltaBlocks;
+	std::vector<std::shared_ptr<DeltaBlock>> deltaBlocks;
+	MemOutputArchive out(lastDeltaBlocks, deltaBlocks, true);
+	out.serialize("object", original);
+	size_t size;
+	MemBuffer<byte> buf = out.releaseBuffer(size);
+
+	MemInputArchive in(buf.data(), size, deltaBlocks);
+	in.serialize("object", loaded);
+}
+
+TEST_CASE("Serialize: MemOutputArchive/MemInputArchive")
+{
+	std::mt19937 gen(1234);
+
+	SECTION("RAM") {
+		Ram original;
+		for (auto& b : original.data) b = gen() & 0xFF;
+		Ram loaded;
+		roundTrip(original, loaded);
+		CHECK(loaded == original);
+	}
+	SECTION("registers") {
+		Registers original;
+		for (auto& r : original.regs8)    r = gen() & 0xFF;
+		for (auto& r : original.regs16)   r = gen() & 0xFFFF;
+		for (auto& c : original.counters) c = int(gen() % 1000000) - 500000;
+		for (auto& f : original.flags)    f = gen() & 1;
+		Registers loaded = {};
+		roundTrip(original, loaded);
+		CHECK(loaded == original);
+	}
+	SECTION("linked") {
+		for (int n : {1, 100, 10000}) {
+			Linked original;
+			original.shared.value = 42;
+			original.nodes.resize(n);
+			for (auto& node : original.nodes) {
+				node.value = gen() & 0xFF;
+				node.other = &original.nodes[gen() % n];
+				node.shared = &original.shared;
+			}
+			Linked loaded;
+			roundTrip(original, loaded);
+			CHECK(loaded == original);
+		}
+	}
+}
@@ -0,0 +1,57 @@
+#include "catch.hpp"
+#include "SpriteYMatch.hh"
+#include <random>
+
+using namespace openmsx;
+
+// Brute-force version: check line by line whether the sprite is visible.
+static uint32_t reference(const byte* spriteY, int count,
+                          int displayLine, int numLines, int magSize)
+{
+	uint32_t result = 0;
+	for (int i = 0; i < count; ++i) {
+		for (int line = 0; line < numLines; ++line) {
+			if (((displayLine + line - spriteY[i]) & 0xFF) < magSize) {
+				result |= 1u << i;
+				break;
+			}
+		}
+	}
+	return result;
+}
+
+static void test(const byte* spriteY, int count,
+                 int displayLine, int numLines, int magSize)
+{
+	INFO("count=" << count << " line=" << displayLine <<
+	     " numLines=" << numLines << " magSize=" << magSize);
+	CHECK(matchSpriteY(spriteY, count, displayLine, numLines, magSize) ==
+	      reference(spriteY, count, displayLine, numLines, magSize));
+}
+
+TEST_CASE("SpriteYMatch: wrap around")
+{
+	byte spriteY[32];
+	for (int i = 0; i < 32; ++i) spriteY[i] = 256 - 8 * i;
+	for (int magSize : {8, 16, 32}) {
+		for (int line = -64; line < 256; line += 7) {
+			test(spriteY, 32, line,   1, magSize);
+			test(spriteY, 32, line,   5, magSize);
+			test(spriteY, 32, line, 300, magSize);
+		}
+	}
+}
+
+TEST_CASE("SpriteYMatch: random")
+{
+	std::mt19937 gen(1234); // raw mt19937 output is the same everywhere
+	byte spriteY[32];
+	for (int iter = 0; iter < 10000; ++iter) {
+		for (auto& y : spriteY) y = gen() & 0xFF;
+		int count = gen() % 33;
+		int displayLine = int(gen() & 0xFF) - 64; // can be negative
+		int numLines = 1 + ((gen() % 4) ? gen() % 16 : (gen() & 0xFF) + 60);
+		int magSize = 8 << (gen() % 3); // 8, 16 or 32
+		test(spriteY, count, displayLine, numLines, magSize);
+	}
+}
@@ -0,0 +1,103 @@
+#include "catch.hpp"
+#include "YM2413Okazaki.hh"
+#include "YM2413Burczynski.hh"
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using namespace openmsx;
+
+// Golden-output tests for the YM2413 cores: render a fixed sequence of
+// register writes and compare a hash of the output with the value produced
+// by the original implementation. Optimizations of the synthesis code must
+// be bit-exact (or, if not, these values must be updated deliberately).
+
+static const unsigned NUM_BUFS = 9 + 5;
+
+// FNV-1a, over all samples of all channels (a nullptr buffer counts as
+// silence, so that skipping silent channels doesn't change the hash).
+static void hashOutput(uint64_t& hash, int* bufs[NUM_BUFS], unsigned num)
+{
+	for (unsigned i = 0; i < NUM_BUFS; ++i) {
+		for (unsigned j = 0; j < num; ++j) {
+			uint32_t s = bufs[i] ? bufs[i][j] : 0;
+			for (int b = 0; b < 4; ++b) {
+				hash ^= (s >> (8 * b)) & 0xFF;
+				hash *= 0x100000001B3ull;
+			}
+		}
+	}
+}
+
+static uint64_t render(YM2413Core& core)
+{
+	std::vector<int> data(NUM_BUFS * 512);
+	uint64_t hash = 0xCBF29CE484222325ull;
+	auto generate = [&](unsigned num) {
+		assert(num <= 512);
+		std::fill(data.begin(), data.end(), 0);
+		int* bufs[NUM_BUFS];
+		for (unsigned i = 0; i < NUM_BUFS; ++i) bufs[i] = &data[i * 512];
+		core.generateChannels(bufs, num);
+		hashOutput(hash, bufs, num);
+	};
+
+	core.reset();
+	// custom instrument (with feedback and half-sine on the carrier)
+	static const byte custom[8] = { 0x61, 0x21, 0x1E, 0x17, 0xF0, 0x7F, 0x00, 0x17 };
+	for (int i = 0; i < 8; ++i) core.writeReg(i, custom[i]);
+
+	// melody: all instruments on all channels, key on, sustain, key off
+	for (int inst = 0; inst < 16; ++inst) {
+		for (int ch = 0; ch < 9; ++ch) {
+			unsigned fnum = 172 + 37 * ch + 11 * inst;
+			unsigned block = (inst + ch) & 7;
+			core.writeReg(0x30 + ch, (inst << 4) | (ch & 0x0F));
+			core.writeReg(0x10 + ch, fnum & 0xFF);
+			core.writeReg(0x20 + ch, 0x10 | (block << 1) | (fnum >> 8));
+		}
+		generate(500);
+		generate(1);
+		generate(123);
+		for (int ch = 0; ch < 9; ch += 2) {
+			// key off, odd channels with sustain
+			core.writeReg(0x20 + ch, (ch & 2) ? 0x20 : 0x00);
+		}
+		generate(400);
+	}
+
+	// rhythm mode
+	core.writeReg(0x16, 0x20); core.writeReg(0x26, 0x05);
+	core.writeReg(0x17, 0x50); core.writeReg(0x27, 0x05);
+	core.writeReg(0x18, 0xC0); core.writeReg(0x28, 0x01);
+	core.writeReg(0x36, 0x01); core.writeReg(0x37, 0x23); core.writeReg(0x38, 0x45);
+	for (int i = 0; i < 32; ++i) {
+		core.writeReg(0x0E, 0x20);
+		generate(50);
+		core.writeReg(0x0E, 0x20 | (i & 0x1F));
+		generate(300);
+	}
+
+	// random register writes (raw mt19937 output is the same everywhere)
+	std::mt19937 gen(2413);
+	for (int i = 0; i < 2000; ++i) {
+		unsigned r = gen() % 0x39;
+		core.writeReg(r, gen() & 0xFF);
+		if ((i % 4) == 0) generate(1 + gen() % 300);
+	}
+	core.writeReg(0x0E, 0x00);
+	generate(512);
+	return hash;
+}
+
+TEST_CASE("YM2413Okazaki: golden output")
+{
+	YM2413Okazaki::YM2413 core;
+	CHECK(render(core) == 0xFF8B761A18756573ull);
+}
+
+TEST_CASE("YM2413Burczynski: golden output")
+{
+	YM2413Burczynski::YM2413 core;
+	CHECK(render(core) == 0x00BBAEF85A81DCBFull);
+}
@@ -0,0 +1,163 @@
+#include "catch.hpp"
+#include "YMF262Core.hh"
+#include <cassert>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using namespace openmsx;
+
+// Golden-output test for the YMF262 core, see YM2413_test.cc. The expected
+// value was produced by the YMF262 implementation from before the block-wise
+// channel evaluation.
+
+static const unsigned NUM_BUFS = 18;
+static const unsigned MAX_SAMPLES = 1024;
+
+// FNV-1a, over all (stereo) samples of all channels (a nullptr buffer counts
+// as silence, so that skipping silent channels doesn't change the hash).
+static void hashOutput(uint64_t& hash, int* bufs[NUM_BUFS], unsigned num)
+{
+	for (unsigned i = 0; i < NUM_BUFS; ++i) {
+		for (unsigned j = 0; j < 2 * num; ++j) {
+			uint32_t s = bufs[i] ? bufs[i][j] : 0;
+			for (int b = 0; b < 4; ++b) {
+				hash ^= (s >> (8 * b)) & 0xFF;
+				hash *= 0x100000001B3ull;
+			}
+		}
+	}
+}
+
+static uint64_t render(YMF262Core& core)
+{
+	std::vector<int> data(NUM_BUFS * 2 * MAX_SAMPLES);
+	uint64_t hash = 0xCBF29CE484222325ull;
+	auto generate = [&](unsigned num) {
+		assert(num <= MAX_SAMPLES);
+		std::fill(data.begin(), data.end(), 0);
+		int* bufs[NUM_BUFS];
+		for (unsigned i = 0; i < NUM_BUFS; ++i) bufs[i] = &data[i * 2 * MAX_SAMPLES];
+		core.generateChannels(bufs, num);
+		hashOutput(hash, bufs, num);
+	};
+	// operator offsets within a register block, for the 18 slots of a set
+	static const unsigned ops[18] = {
+		0, 1, 2, 3, 4, 5, 8, 9, 10, 11, 12, 13, 16, 17, 18, 19, 20, 21
+	};
+	auto keyOn = [&](int step) {
+		for (unsigned set = 0; set < 2; ++set) {
+			for (unsigned c = 0; c < 9; ++c) {
+				unsigned base = set * 0x100;
+				unsigned fnum = 300 + 41 * c + 97 * step + 13 * set;
+				unsigned block = (c + step) & 7;
+				core.writeReg(base + 0xA0 + c, fnum & 0xFF);
+				core.writeReg(base + 0xB0 + c, 0x20 | (block << 2) | (fnum >> 8));
+			}
+		}
+	};
+	auto keyOff = [&]() {
+		for (unsigned set = 0; set < 2; ++set) {
+			for (unsigned c = 0; c < 9; c += 2) {
+				core.writeReg(set * 0x100 + 0xB0 + c, 0x00);
+			}
+		}
+	};
+
+	core.reset();
+
+	// OPL2 mode: melody on the first register set, all 4 OPL2 waveforms
+	for (unsigned i = 0; i < 18; ++i) {
+		unsigned o = ops[i];
+		core.writeReg(0x20 + o, 0x21 + (i & 3) * 0x40);
+		core.writeReg(0x40 + o, (i * 7) & 0x3F);
+		core.writeReg(0x60 + o, 0xF2 - 0x10 * (i % 3));
+		core.writeReg(0x80 + o, 0x13 + i * 0x10);
+		core.writeReg(0xE0 + o, i & 7);
+	}
+	for (unsigned c = 0; c < 9; ++c) core.writeReg(0xC0 + c, (c & 7) << 1 | (c & 1));
+	keyOn(0);
+	generate(500);
+	generate(1);
+	generate(123);
+	keyOff();
+	generate(400);
+
+	// OPL3 mode: both register sets, all 8 waveforms, panning
+	core.writeReg(0x105, 0x01);
+	for (unsigned set = 0; set < 2; ++set) {
+		unsigned base = set * 0x100;
+		for (unsigned i = 0; i < 18; ++i) {
+			unsigned o = ops[i];
+			core.writeReg(base + 0x20 + o, 0x21 + (i & 3) * 0x40);
+			core.writeReg(base + 0x40 + o, (i * 7) & 0x3F);
+			core.writeReg(base + 0x60 + o, 0xF2 + (i & 1) * 0x10 - 0x10 * (i % 3));
+			core.writeReg(base + 0x80 + o, 0x13 + i * 0x10);
+			core.writeReg(base + 0xE0 + o, (i + set) & 7);
+		}
+		for (unsigned c = 0; c < 9; ++c) {
+			core.writeReg(base + 0xC0 + c, ((c + set) & 3) << 4 | (c & 7) << 1 | (c & 1));
+		}
+	}
+	// AM and vibrato depth
+	core.writeReg(0xBD, 0xC0);
+	for (int step = 0; step < 2; ++step) {
+		keyOn(step);
+		for (int k = 0; k < 8; ++k) generate(700);
+		keyOff();
+		for (int k = 0; k < 6; ++k) generate(1000);
+	}
+
+	// 4-operator channels, all 4 connection types (CON bit of both halves)
+	core.writeReg(0x104, 0x3F);
+	for (int con = 0; con < 4; ++con) {
+		for (unsigned set = 0; set < 2; ++set) {
+			for (unsigned c = 0; c < 3; ++c) {
+				unsigned base = set * 0x100;
+				core.writeReg(base + 0xC0 + c,     0x30 | (c << 1) | (con >> 1));
+				core.writeReg(base + 0xC0 + c + 3, 0x30 | (c << 1) | (con & 1));
+			}
+		}
+		keyOn(2 + con);
+		for (int k = 0; k < 4; ++k) generate(700);
+		keyOff();
+		for (int k = 0; k < 3; ++k) generate(1000);
+	}
+
+	// note select
+	core.writeReg(0x08, 0x40);
+	keyOn(6);
+	generate(1000);
+	core.writeReg(0x08, 0x00);
+
+	// rhythm mode (the hi-hat, snare and cymbal use the noise generator),
+	// some 4-op channels remain
+	core.writeReg(0x104, 0x05);
+	core.writeReg(0xBD, 0xE0);
+	for (int step = 0; step < 2; ++step) {
+		keyOn(6 + step);
+		for (int k = 0; k < 32; ++k) {
+			generate(300);
+			byte depth = (k < 16) ? 0xE0 : 0x20;
+			core.writeReg(0xBD, depth | ((k * 5) & 0x1F));
+		}
+		keyOff();
+		for (int k = 0; k < 6; ++k) generate(1000);
+	}
+
+	// random register writes (raw mt19937 output is the same everywhere)
+	std::mt19937 gen(262);
+	for (int i = 0; i < 6000; ++i) {
+		unsigned r = gen() % 0x200;
+		core.writeReg(r, gen() & 0xFF);
+		if ((i % 8) == 0) generate(1 + gen() % MAX_SAMPLES);
+	}
+	for (int k = 0; k < 100; ++k) generate(1000);
+	return hash;
+}
+
+TEST_CASE("YMF262: golden output")
+{
+	YMF262Core core;
+	CHECK(render(core) == 0xEAC172C523E489E5ull);
+}
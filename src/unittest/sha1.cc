@@ -131,3 +131,18 @@ TEST_CASE("sha1: update,digest")
 		CHECK(sum.toString() == "34aa973cd4c4daa4f61eeb2bdbad27316534016f");
 	}
 }
+
+TEST_CASE("sha1: calc, many blocks")
+{
+	// one update() call that spans many 64-byte blocks, both starting at
+	// a block boundary and after a partially filled block
+	std::string in(1000000, 'a');
+	auto* data = reinterpret_cast<const uint8_t*>(in.data());
+	CHECK(SHA1::calc(data, in.size()).toString() ==
+	      "34aa973cd4c4daa4f61eeb2bdbad27316534016f");
+
+	SHA1 sha1;
+	sha1.update(data, 7);
+	sha1.update(data + 7, in.size() - 7);
+	CHECK(sha1.digest().toString() == "34aa973cd4c4daa4f61eeb2bdbad27316534016f");
+}
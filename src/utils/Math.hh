@@ -8,6 +8,9 @@
 #ifdef _MSC_VER
 #include <intrin.h>
 #pragma intrinsic(_BitScanForward)
+#ifdef _M_X64
+#pragma intrinsic(_BitScanForward64)
+#endif
 #endif
 
 // These constants are very common extensions, but not guaranteed to be defined
@@ -235,6 +238,39 @@ inline unsigned findFirstSet(unsigned x)
 #endif
 }
 
+/** Count the number of trailing zero-bits in the given 64-bit word.
+  * The result is undefined when the input is zero (all bits are zero).
+  */
+inline unsigned countTrailingZeros64(uint64_t x)
+{
+#if defined(__GNUC__)
+	return __builtin_ctzll(x); // undefined when x==0
+#elif defined(_MSC_VER) && defined(_M_X64)
+	unsigned long index;
+	_BitScanForward64(&index, x);
+	return index;
+#else
+	auto lo = uint32_t(x);
+	return lo ? findFirstSet(lo) - 1
+	          : findFirstSet(uint32_t(x >> 32)) + 31;
+#endif
+}
+
+/** Count the number of bits that are set in the given 64-bit word.
+  */
+inline unsigned popcount64(uint64_t x)
+{
+#if defined(__GNUC__)
+	return __builtin_popcountll(x);
+#else
+	// Not __popcnt64(): that requires a CPU with the POPCNT instruction.
+	x = x - ((x >> 1) & 0x5555555555555555ull);
+	x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+	x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+	return unsigned((x * 0x0101010101010101ull) >> 56);
+#endif
+}
+
 } // namespace Math
 
 #endif // MATH_HH
@@ -0,0 +1,54 @@
+#include "ThreadPool.hh"
+#include <algorithm>
+
+namespace openmsx {
+
+ThreadPool::ThreadPool(unsigned numThreads)
+	: maxThreads(numThreads ? numThreads
+	                        : std::max(1u, std::thread::hardware_concurrency()))
+	, stop(false)
+{
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stop = true;
+		jobs.clear();
+	}
+	condition.notify_all();
+	for (auto& t : threads) t.join();
+}
+
+void ThreadPool::push(std::function<void()> job)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		jobs.push_back(std::move(job));
+	}
+	// Start the threads on demand: one per job until the maximum is
+	// reached. Only the owner calls push(), so no need to protect
+	// 'threads'.
+	if (threads.size() < maxThreads) {
+		threads.emplace_back([this] { run(); });
+	}
+	condition.notify_one();
+}
+
+void ThreadPool::run()
+{
+	while (true) {
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			condition.wait(lock, [&] { return stop || !jobs.empty(); });
+			if (stop) return;
+			job = std::move(jobs.front());
+			jobs.pop_front();
+		}
+		job();
+	}
+}
+
+} // namespace openmsx
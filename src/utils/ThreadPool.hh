@@ -0,0 +1,55 @@
+#ifndef THREADPOOL_HH
+#define THREADPOOL_HH
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace openmsx {
+
+/** A small set of worker threads that execute jobs from a shared queue.
+  * The threads are only started when jobs are added. Jobs that are
+  * still queued when the pool is destroyed are dropped (their futures will
+  * report a broken promise), jobs that are already running are waited for.
+  */
+class ThreadPool
+{
+public:
+	/** @param numThreads Maximum number of worker threads, 0 means one
+	  *   thread per hardware thread.
+	  */
+	explicit ThreadPool(unsigned numThreads = 0);
+	~ThreadPool();
+
+	/** Queue a job. The result (or exception) of the job is available
+	  * via the returned future.
+	  */
+	template<typename F> auto enqueue(F f) -> std::future<decltype(f())>
+	{
+		using R = decltype(f());
+		auto task = std::make_shared<std::packaged_task<R()>>(std::move(f));
+		auto result = task->get_future();
+		push([task] { (*task)(); });
+		return result;
+	}
+
+private:
+	void push(std::function<void()> job);
+	void run();
+
+	std::vector<std::thread> threads;
+	std::deque<std::function<void()>> jobs;
+	std::mutex mutex; // protects 'jobs' and 'stop'
+	std::condition_variable condition;
+	unsigned maxThreads;
+	bool stop;
+};
+
+} // namespace openmsx
+
+#endif
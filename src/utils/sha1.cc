@@ -28,6 +28,11 @@ A million repetitions of "a"
 #ifdef __SSE2__
 #include <emmintrin.h> // SSE2
 #endif
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define SHA1_SHA_NI 1
+#include <cpuid.h>
+#include <immintrin.h> // SHA-NI, SSSE3, SSE4.1
+#endif
 
 using std::string;
 
@@ -314,6 +319,204 @@ void SHA1::transform(const uint8_t buffer[64])
 	m_state.a[4] += e;
 }
 
+#ifdef SHA1_SHA_NI
+// Hardware accelerated transform, using the SHA extensions (SHA-NI) that are
+// present in recent x86 CPUs (Intel since Goldmont/Ice Lake, AMD since Zen).
+// These instructions are not part of the baseline instruction set, so this
+// code is compiled for that target separately and only used after checking
+// the CPU at run time.
+#define SHA_NI_TARGET __attribute__((target("sha,ssse3,sse4.1")))
+
+static bool hasShaNi()
+{
+	unsigned eax, ebx, ecx, edx;
+	if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return false;
+	bool ssse3  = (ecx & (1 << 9))  != 0;
+	bool sse4_1 = (ecx & (1 << 19)) != 0;
+	if (__get_cpuid_max(0, nullptr) < 7) return false;
+	__cpuid_count(7, 0, eax, ebx, ecx, edx);
+	bool sha = (ebx & (1 << 29)) != 0;
+	return ssse3 && sse4_1 && sha;
+}
+
+// load 16 message bytes as 4 big-endian words (in reverse order)
+SHA_NI_TARGET static inline __m128i loadBlock(const uint8_t* data)
+{
+	const __m128i MASK = _mm_set_epi64x(0x0001020304050607, 0x08090a0b0c0d0e0f);
+	return _mm_shuffle_epi8(
+		_mm_loadu_si128(reinterpret_cast<const __m128i*>(data)), MASK);
+}
+
+SHA_NI_TARGET static void transformShaNi(
+	uint32_t state[5], const uint8_t* data, size_t numBlocks)
+{
+	__m128i abcd = _mm_shuffle_epi32(
+		_mm_loadu_si128(reinterpret_cast<const __m128i*>(state)), 0x1B);
+	__m128i e0 = _mm_set_epi32(state[4], 0, 0, 0);
+	__m128i e1, msg0, msg1, msg2, msg3;
+
+	for (/**/; numBlocks; --numBlocks, data += 64) {
+		__m128i abcdSave = abcd;
+		__m128i eSave = e0;
+
+		// rounds 0-3
+		msg0 = loadBlock(data + 0);
+		e0 = _mm_add_epi32(e0, msg0);
+		e1 = abcd;
+		abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+		// rounds 4-7
+		msg1 = loadBlock(data + 16);
+		e1 = _mm_sha1nexte_epu32(e1, msg1);
+		e0 = abcd;
+		abcd = _mm_sha1rnds4_epu32(abcd, e1, 0);
+		msg0 = _mm_sha1msg1_epu32(msg0, msg1);
+		// rounds 8-11
+		msg2 = loadBlock(data + 32);
+		e0 = _mm_sha1nexte_epu32(e0, msg2);
+		e1 = abcd;
+		abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+		msg1 = _mm_sha1msg1_epu32(msg1, msg2);
+		msg0 = _mm_xor_si128(msg0, msg2);
+		// rounds 12-15
+		msg3 = loadBlock(data + 48);
+		e1 = _mm_sha1nexte_epu32(e1, msg3);
+		e0 = abcd;
+		msg0 = _mm_sha1msg2_epu32(msg0, msg3);
+		abcd = _mm_sha1rnds4_epu32(abcd, e1, 0);
+		msg2 = _mm_sha1msg1_epu32(msg2, msg3);
+		msg1 = _mm_xor_si128(msg1, msg3);
+		// rounds 16-19
+		e0 = _mm_sha1nexte_epu32(e0, msg0);
+		e1 = abcd;
+		msg1 = _mm_sha1msg2_epu32(msg1, msg0);
+		abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+		msg3 = _mm_sha1msg1_epu32(msg3, msg0);
+		msg2 = _mm_xor_si128(msg2, msg0);
+		// rounds 20-23
+		e1 = _mm_sha1nexte_epu32(e1, msg1);
+		e0 = abcd;
+		msg2 = _mm_sha1msg2_epu32(msg2, msg1);
+		abcd = _mm_sha1rnds4_epu32(abcd, e1, 1);
+		msg0 = _mm_sha1msg1_epu32(msg0, msg1);
+		msg3 = _mm_xor_si128(msg3, msg1);
+		// rounds 24-27
+		e0 = _mm_sha1nexte_epu32(e0, msg2);
+		e1 = abcd;
+		msg3 = _mm_sha1msg2_epu32(msg3, msg2);
+		abcd = _mm_sha1rnds4_epu32(abcd, e0, 1);
+		msg1 = _mm_sha1msg1_epu32(msg1, msg2);
+		msg0 = _mm_xor_si128(msg0, msg2);
+		// rounds 28-31
+		e1 = _mm_sha1nexte_epu32(e1, msg3);
+		e0 = abcd;
+		msg0 = _mm_sha1msg2_epu32(msg0, msg3);
+		abcd = _mm_sha1rnds4_epu32(abcd, e1, 1);
+		msg2 = _mm_sha1msg1_epu32(msg2, msg3);
+		msg1 = _mm_xor_si128(msg1, msg3);
+		// rounds 32-35
+		e0 = _mm_sha1nexte_epu32(e0, msg0);
+		e1 = abcd;
+		msg1 = _mm_sha1msg2_epu32(msg1, msg0);
+		abcd = _mm_sha1rnds4_epu32(abcd, e0, 1);
+		msg3 = _mm_sha1msg1_epu32(msg3, msg0);
+		msg2 = _mm_xor_si128(msg2, msg0);
+		// rounds 36-39
+		e1 = _mm_sha1nexte_epu32(e1, msg1);
+		e0 = abcd;
+		msg2 = _mm_sha1msg2_epu32(msg2, msg1);
+		abcd = _mm_sha1rnds4_epu32(abcd, e1, 1);
+		msg0 = _mm_sha1msg1_epu32(msg0, msg1);
+		msg3 = _mm_xor_si128(msg3, msg1);
+		// rounds 40-43
+		e0 = _mm_sha1nexte_epu32(e0, msg2);
+		e1 = abcd;
+		msg3 = _mm_sha1msg2_epu32(msg3, msg2);
+		abcd = _mm_sha1rnds4_epu32(abcd, e0, 2);
+		msg1 = _mm_sha1msg1_epu32(msg1, msg2);
+		msg0 = _mm_xor_si128(msg0, msg2);
+		// rounds 44-47
+		e1 = _mm_sha1nexte_epu32(e1, msg3);
+		e0 = abcd;
+		msg0 = _mm_sha1msg2_epu32(msg0, msg3);
+		abcd = _mm_sha1rnds4_epu32(abcd, e1, 2);
+		msg2 = _mm_sha1msg1_epu32(msg2, msg3);
+		msg1 = _mm_xor_si128(msg1, msg3);
+		// rounds 48-51
+		e0 = _mm_sha1nexte_epu32(e0, msg0);
+		e1 = abcd;
+		msg1 = _mm_sha1msg2_epu32(msg1, msg0);
+		abcd = _mm_sha1rnds4_epu32(abcd, e0, 2);
+		msg3 = _mm_sha1msg1_epu32(msg3, msg0);
+		msg2 = _mm_xor_si128(msg2, msg0);
+		// rounds 52-55
+		e1 = _mm_sha1nexte_epu32(e1, msg1);
+		e0 = abcd;
+		msg2 = _mm_sha1msg2_epu32(msg2, msg1);
+		abcd = _mm_sha1rnds4_epu32(abcd, e1, 2);
+		msg0 = _mm_sha1msg1_epu32(msg0, msg1);
+		msg3 = _mm_xor_si128(msg3, msg1);
+		// rounds 56-59
+		e0 = _mm_sha1nexte_epu32(e0, msg2);
+		e1 = abcd;
+		msg3 = _mm_sha1msg2_epu32(msg3, msg2);
+		abcd = _mm_sha1rnds4_epu32(abcd, e0, 2);
+		msg1 = _mm_sha1msg1_epu32(msg1, msg2);
+		msg0 = _mm_xor_si128(msg0, msg2);
+		// rounds 60-63
+		e1 = _mm_sha1nexte_epu32(e1, msg3);
+		e0 = abcd;
+		msg0 = _mm_sha1msg2_epu32(msg0, msg3);
+		abcd = _mm_sha1rnds4_epu32(abcd, e1, 3);
+		msg2 = _mm_sha1msg1_epu32(msg2, msg3);
+		msg1 = _mm_xor_si128(msg1, msg3);
+		// rounds 64-67
+		e0 = _mm_sha1nexte_epu32(e0, msg0);
+		e1 = abcd;
+		msg1 = _mm_sha1msg2_epu32(msg1, msg0);
+		abcd = _mm_sha1rnds4_epu32(abcd, e0, 3);
+		msg3 = _mm_sha1msg1_epu32(msg3, msg0);
+		msg2 = _mm_xor_si128(msg2, msg0);
+		// rounds 68-71
+		e1 = _mm_sha1nexte_epu32(e1, msg1);
+		e0 = abcd;
+		msg2 = _mm_sha1msg2_epu32(msg2, msg1);
+		abcd = _mm_sha1rnds4_epu32(abcd, e1, 3);
+		msg3 = _mm_xor_si128(msg3, msg1);
+		// rounds 72-75
+		e0 = _mm_sha1nexte_epu32(e0, msg2);
+		e1 = abcd;
+		msg3 = _mm_sha1msg2_epu32(msg3, msg2);
+		abcd = _mm_sha1rnds4_epu32(abcd, e0, 3);
+		// rounds 76-79
+		e1 = _mm_sha1nexte_epu32(e1, msg3);
+		e0 = abcd;
+		abcd = _mm_sha1rnds4_epu32(abcd, e1, 3);
+
+		// add the working vars back into the state
+		e0 = _mm_sha1nexte_epu32(e0, eSave);
+		abcd = _mm_add_epi32(abcd, abcdSave);
+	}
+
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(state),
+	                 _mm_shuffle_epi32(abcd, 0x1B));
+	state[4] = _mm_extract_epi32(e0, 3);
+}
+#endif
+
+void SHA1::transformBlocks(const uint8_t* data, size_t numBlocks)
+{
+#ifdef SHA1_SHA_NI
+	static const bool useShaNi = hasShaNi();
+	if (useShaNi) {
+		transformShaNi(m_state.a, data, numBlocks);
+		return;
+	}
+#endif
+	for (/**/; numBlocks; --numBlocks, data += 64) {
+		transform(data);
+	}
+}
+
 // Use this function to hash in binary data and strings
 void SHA1::update(const uint8_t* data, size_t len)
 {
@@ -325,10 +528,10 @@ void SHA1::update(const uint8_t* data, size_t len)
 	size_t i;
 	if ((j + len) > 63) {
 		memcpy(&m_buffer[j], data, (i = 64 - j));
-		transform(m_buffer);
-		for (; i + 63 < len; i += 64) {
-			transform(&data[i]);
-		}
+		transformBlocks(m_buffer, 1);
+		size_t numBlocks = (len - i) / 64;
+		transformBlocks(&data[i], numBlocks);
+		i += 64 * numBlocks;
 		j = 0;
 	} else {
 		i = 0;
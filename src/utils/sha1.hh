@@ -92,6 +92,7 @@ public:
 
 private:
 	void transform(const uint8_t buffer[64]);
+	void transformBlocks(const uint8_t* data, size_t numBlocks);
 	void finalize();
 
 	uint64_t m_count;
@@ -1,6 +1,7 @@
 #include "AviRecorder.hh"
 #include "AviWriter.hh"
 #include "WavWriter.hh"
+#include "ShmWriter.hh"
 #include "Reactor.hh"
 #include "MSXMotherBoard.hh"
 #include "FileContext.hh"
@@ -13,6 +14,7 @@
 #include "FileOperations.hh"
 #include "TclObject.hh"
 #include "outer.hh"
+#include "unistdp.hh"
 #include "view.hh"
 #include "vla.hh"
 #include <cassert>
@@ -37,49 +39,59 @@ AviRecorder::~AviRecorder()
 {
 	assert(!aviWriter);
 	assert(!wavWriter);
+	assert(!shmWriter);
+}
+
+void AviRecorder::setupAudio(bool recordStereo, bool recordMono)
+{
+	mixer = &reactor.getMotherBoard()->getMSXMixer();
+	warnedStereo = false;
+	if (recordStereo) {
+		stereo = true;
+	} else if (recordMono) {
+		stereo = false;
+		warnedStereo = true; // no warning if data is actually stereo
+	} else {
+		stereo = mixer->needStereoRecording();
+	}
+	sampleRate = mixer->getSampleRate();
+	warnedSampleRate = false;
+}
+
+void AviRecorder::setupVideo()
+{
+	// Set V99x8, V9990, Laserdisc, ... in record mode (when
+	// present). Only the active one will actually send frames to
+	// the video. This also works for Video9000.
+	postProcessors.clear();
+	for (auto* l : reactor.getDisplay().getAllLayers()) {
+		if (auto* pp = dynamic_cast<PostProcessor*>(l)) {
+			postProcessors.push_back(pp);
+		}
+	}
+	if (postProcessors.empty()) {
+		throw CommandException(
+			"Current renderer doesn't support video recording.");
+	}
+	warnedFps = false;
+	duration = EmuDuration::infinity;
+	prevTime = EmuTime::infinity;
 }
 
 void AviRecorder::start(bool recordAudio, bool recordVideo, bool recordMono,
                         bool recordStereo, const Filename& filename)
 {
 	stop();
-	MSXMotherBoard* motherBoard = reactor.getMotherBoard();
-	if (!motherBoard) {
+	if (!reactor.getMotherBoard()) {
 		throw CommandException("No active MSX machine.");
 	}
 	if (recordAudio) {
-		mixer = &motherBoard->getMSXMixer();
-		warnedStereo = false;
-		if (recordStereo) {
-			stereo = true;
-		} else if (recordMono) {
-			stereo = false;
-			warnedStereo = true; // no warning if data is actually stereo
-		} else {
-			stereo = mixer->needStereoRecording();
-		}
-		sampleRate = mixer->getSampleRate();
-		warnedSampleRate = false;
+		setupAudio(recordStereo, recordMono);
 	}
 	if (recordVideo) {
-		// Set V99x8, V9990, Laserdisc, ... in record mode (when
-		// present). Only the active one will actually send frames to
-		// the video. This also works for Video9000.
-		postProcessors.clear();
-		for (auto* l : reactor.getDisplay().getAllLayers()) {
-			if (auto* pp = dynamic_cast<PostProcessor*>(l)) {
-				postProcessors.push_back(pp);
-			}
-		}
-		if (postProcessors.empty()) {
-			throw CommandException(
-				"Current renderer doesn't support video recording.");
-		}
+		setupVideo();
 		// any source is fine because they all have the same bpp
 		unsigned bpp = postProcessors.front()->getBpp();
-		warnedFps = false;
-		duration = EmuDuration::infinity;
-		prevTime = EmuTime::infinity;
 
 		try {
 			aviWriter = std::make_unique<AviWriter>(
@@ -101,6 +113,41 @@ void AviRecorder::start(bool recordAudio, bool recordVideo, bool recordMono,
 	if (mixer) mixer->setRecorder(this);
 }
 
+void AviRecorder::startShm(bool recordAudio, bool recordVideo, bool recordMono,
+                           bool recordStereo, const string& name)
+{
+	stop();
+	if (!reactor.getMotherBoard()) {
+		throw CommandException("No active MSX machine.");
+	}
+	if (recordAudio) {
+		setupAudio(recordStereo, recordMono);
+	}
+	unsigned bpp = 0;
+	if (recordVideo) {
+		setupVideo();
+		bpp = postProcessors.front()->getBpp();
+	}
+	try {
+		shmWriter = std::make_unique<ShmWriter>(
+			name, recordVideo ? frameWidth : 0, frameHeight, bpp,
+			recordAudio ? (stereo ? 2 : 1) : 0, sampleRate);
+	} catch (MSXException& e) {
+		postProcessors.clear();
+		mixer = nullptr;
+		throw CommandException("Can't start exporting: ", e.getMessage());
+	}
+	for (auto* pp : postProcessors) {
+		pp->setRecorder(this);
+	}
+	if (mixer) mixer->setRecorder(this);
+}
+
+bool AviRecorder::isRecording() const
+{
+	return aviWriter || wavWriter || shmWriter;
+}
+
 void AviRecorder::stop()
 {
 	for (auto* pp : postProcessors) {
@@ -114,9 +161,10 @@ void AviRecorder::stop()
 	sampleRate = 0;
 	aviWriter.reset();
 	wavWriter.reset();
+	shmWriter.reset();
 }
 
-void AviRecorder::addWave(unsigned num, int16_t* data)
+void AviRecorder::addWave(unsigned num, int16_t* data, EmuTime::param time)
 {
 	if (!warnedSampleRate && (mixer->getSampleRate() != sampleRate)) {
 		warnedSampleRate = true;
@@ -128,6 +176,8 @@ void AviRecorder::addWave(unsigned num, int16_t* data)
 	if (stereo) {
 		if (wavWriter) {
 			wavWriter->write(data, 2, num);
+		} else if (shmWriter) {
+			shmWriter->addAudio(data, num, time);
 		} else {
 			assert(aviWriter);
 			audioBuf.insert(end(audioBuf), data, data + 2 * num);
@@ -153,6 +203,8 @@ void AviRecorder::addWave(unsigned num, int16_t* data)
 
 		if (wavWriter) {
 			wavWriter->write(buf, 1, num);
+		} else if (shmWriter) {
+			shmWriter->addAudio(buf, num, time);
 		} else {
 			assert(aviWriter);
 			audioBuf.insert(end(audioBuf), buf, buf + num);
@@ -163,6 +215,12 @@ void AviRecorder::addWave(unsigned num, int16_t* data)
 void AviRecorder::addImage(FrameSource* frame, EmuTime::param time)
 {
 	assert(!wavWriter);
+	if (shmWriter) {
+		// first pass the audio up to this frame
+		if (mixer) mixer->updateStream(time);
+		shmWriter->addFrame(frame, time);
+		return;
+	}
 	if (duration != EmuDuration::infinity) {
 		if (!warnedFps && ((time - prevTime) != duration)) {
 			warnedFps = true;
@@ -198,6 +256,7 @@ void AviRecorder::processStart(span<const TclObject> tokens, TclObject& result)
 	bool recordVideo = true;
 	bool recordMono = false;
 	bool recordStereo = false;
+	bool shm = false;
 	frameWidth = 320;
 	frameHeight = 240;
 
@@ -230,6 +289,8 @@ void AviRecorder::processStart(span<const TclObject> tokens, TclObject& result)
 			} else if (token == "-triplesize") {
 				frameWidth = 960;
 				frameHeight = 720;
+			} else if (token == "-shm") {
+				shm = true;
 			} else {
 				throw CommandException("Invalid option: ", token);
 			}
@@ -257,12 +318,28 @@ void AviRecorder::processStart(span<const TclObject> tokens, TclObject& result)
 		throw SyntaxError();
 	}
 
+	if (shm) {
+		if (isRecording()) {
+			result = "Already recording.";
+			return;
+		}
+		if (filename.empty()) {
+			filename = strCat('/', prefix, '-', int(getpid()));
+		} else if (filename[0] != '/') {
+			filename = '/' + filename;
+		}
+		startShm(recordAudio, recordVideo, recordMono, recordStereo,
+		         filename);
+		result = "Exporting to shared memory " + filename;
+		return;
+	}
+
 	string directory = recordVideo ? "videos" : "soundlogs";
 	string extension = recordVideo ? ".avi"   : ".wav";
 	filename = FileOperations::parseCommandFileArgument(
 		filename, directory, prefix, extension);
 
-	if (aviWriter || wavWriter) {
+	if (isRecording()) {
 		result = "Already recording.";
 	} else {
 		start(recordAudio, recordVideo, recordMono, recordStereo,
@@ -281,7 +358,7 @@ void AviRecorder::processStop(span<const TclObject> tokens)
 
 void AviRecorder::processToggle(span<const TclObject> tokens, TclObject& result)
 {
-	if (aviWriter || wavWriter) {
+	if (isRecording()) {
 		// drop extra tokens
 		processStop(tokens.first<2>());
 	} else {
@@ -294,7 +371,16 @@ void AviRecorder::status(span<const TclObject> tokens, TclObject& result) const
 	if (tokens.size() != 2) {
 		throw SyntaxError();
 	}
-	result.addDictKeyValue("status", (aviWriter || wavWriter) ? "recording" : "idle");
+	result.addDictKeyValue("status", isRecording() ? "recording" : "idle");
+	if (wavWriter) {
+		result.addDictKeyValue("overruns", int(wavWriter->getOverruns()));
+		if (!wavWriter->getError().empty()) {
+			result.addDictKeyValue("error", wavWriter->getError());
+		}
+	}
+	if (shmWriter) {
+		result.addDictKeyValue("shm", shmWriter->getName());
+	}
 }
 
 // class AviRecorder::Cmd
@@ -330,6 +416,8 @@ string AviRecorder::Cmd::help(const vector<string>& /*tokens*/) const
 	       "record start              Record to file 'openmsxNNNN.avi'\n"
 	       "record start <filename>   Record to given file\n"
 	       "record start -prefix foo  Record to file 'fooNNNN.avi'\n"
+	       "record start -shm [name]  Export to POSIX shared memory '/name'\n"
+	       "                          (default '/openmsx-<pid>') instead of a file\n"
 	       "record stop               Stop recording\n"
 	       "record toggle             Toggle recording (useful as keybinding)\n"
 	       "record status             Query recording state\n"
@@ -350,7 +438,7 @@ void AviRecorder::Cmd::tabCompletion(vector<string>& tokens) const
 	} else if ((tokens.size() >= 3) && (tokens[1] == "start")) {
 		static const char* const options[] = {
 			"-prefix", "-videoonly", "-audioonly", "-doublesize", "-triplesize",
-			"-mono", "-stereo",
+			"-mono", "-stereo", "-shm",
 		};
 		completeFileName(tokens, userFileContext(), options);
 	}
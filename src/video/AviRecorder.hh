@@ -13,6 +13,7 @@ namespace openmsx {
 class Reactor;
 class AviWriter;
 class Wav16Writer;
+class ShmWriter;
 class Filename;
 class PostProcessor;
 class FrameSource;
@@ -25,7 +26,7 @@ public:
 	explicit AviRecorder(Reactor& reactor);
 	~AviRecorder();
 
-	void addWave(unsigned num, int16_t* data);
+	void addWave(unsigned num, int16_t* data, EmuTime::param time);
 	void addImage(FrameSource* frame, EmuTime::param time);
 	void stop();
 	unsigned getFrameHeight() const;
@@ -33,6 +34,11 @@ public:
 private:
 	void start(bool recordAudio, bool recordVideo, bool recordMono,
 		   bool recordStereo, const Filename& filename);
+	void startShm(bool recordAudio, bool recordVideo, bool recordMono,
+	              bool recordStereo, const std::string& name);
+	void setupAudio(bool recordStereo, bool recordMono);
+	void setupVideo();
+	bool isRecording() const;
 	void status(span<const TclObject> tokens, TclObject& result) const;
 
 	void processStart (span<const TclObject> tokens, TclObject& result);
@@ -51,6 +57,7 @@ private:
 	std::vector<int16_t> audioBuf;
 	std::unique_ptr<AviWriter>   aviWriter; // can be nullptr
 	std::unique_ptr<Wav16Writer> wavWriter; // can be nullptr
+	std::unique_ptr<ShmWriter>   shmWriter; // can be nullptr
 	std::vector<PostProcessor*> postProcessors;
 	MSXMixer* mixer;
 	EmuDuration duration;
@@ -15,23 +15,33 @@ BitmapConverter<Pixel>::BitmapConverter(
 	: palette16(palette16_)
 	, palette256(palette256_)
 	, palette32768(palette32768_)
-	, dPaletteValid(false)
+	, dPaletteDirty(0xFFFF)
 {
 }
 
 template <class Pixel>
 void BitmapConverter<Pixel>::calcDPalette()
 {
-	dPaletteValid = true;
+	// Palette animations typically change only one or a few entries
+	// between two lines, so only recalculate the rows and columns of the
+	// changed entries.
+	unsigned dirty = dPaletteDirty;
+	dPaletteDirty = 0;
 	unsigned bits = sizeof(Pixel) * 8;
-	for (unsigned i = 0; i < 16; ++i) {
+	auto calc = [&](unsigned i, unsigned j) {
 		DPixel p0 = palette16[i];
-		for (unsigned j = 0; j < 16; ++j) {
-			DPixel p1 = palette16[j];
-			DPixel dp = OPENMSX_BIGENDIAN
-				  ? (p0 << bits) | p1
-				  : (p1 << bits) | p0;
-			dPalette[16 * i + j] = dp;
+		DPixel p1 = palette16[j];
+		dPalette[16 * i + j] = OPENMSX_BIGENDIAN
+		                     ? (p0 << bits) | p1
+		                     : (p1 << bits) | p0;
+	};
+	for (unsigned i = 0; i < 16; ++i) {
+		if (dirty & (1 << i)) {
+			for (unsigned j = 0; j < 16; ++j) calc(i, j);
+		} else {
+			for (unsigned d = dirty; d; d &= d - 1) {
+				calc(i, Math::findFirstSet(d) - 1);
+			}
 		}
 	}
 }
@@ -121,7 +131,7 @@ void BitmapConverter<Pixel>::renderGraphic4(
 		pixelPtr[2 * i + 3] = palette16[data1 & 15];
 	}*/
 
-	if (unlikely(!dPaletteValid)) {
+	if (unlikely(dPaletteDirty)) {
 		calcDPalette();
 	}
 
@@ -228,7 +238,7 @@ void BitmapConverter<Pixel>::renderGraphic6(
 		pixelPtr[4 * i + 2] = palette16[data1 >> 4];
 		pixelPtr[4 * i + 3] = palette16[data1 & 15];
 	}*/
-	if (unlikely(!dPaletteValid)) {
+	if (unlikely(dPaletteDirty)) {
 		calcDPalette();
 	}
 	auto out = reinterpret_cast<DPixel*>(pixelPtr);
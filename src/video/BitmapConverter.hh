@@ -70,7 +70,16 @@ public:
 	  */
 	inline void palette16Changed()
 	{
-		dPaletteValid = false;
+		dPaletteDirty = 0xFFFF;
+	}
+
+	/** Inform this class that only entry 'index' of the palette16 array
+	  * changed. Only the part of the double-pixel palette that depends on
+	  * that entry will be recalculated.
+	  */
+	inline void palette16Changed(unsigned index)
+	{
+		if (index < 16) dPaletteDirty |= 1 << index;
 	}
 
 private:
@@ -95,7 +104,10 @@ private:
 	using DPixel = typename DoublePixel<sizeof(Pixel)>::type;
 	DPixel dPalette[16 * 16];
 	DisplayMode mode;
-	bool dPaletteValid;
+	/** Bitmask of the palette16 entries (0..15) for which the rows and
+	  * columns in dPalette are out of date.
+	  */
+	unsigned dPaletteDirty;
 };
 
 } // namespace openmsx
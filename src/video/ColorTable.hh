@@ -0,0 +1,67 @@
+#ifndef COLORTABLE_HH
+#define COLORTABLE_HH
+
+#include <cstdint>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace openmsx {
+
+namespace detail {
+#ifdef __SSE2__
+inline __m128i set1Pixel(uint16_t p) { return _mm_set1_epi16(p); }
+inline __m128i set1Pixel(uint32_t p) { return _mm_set1_epi32(p); }
+inline __m128i cmpeqPixel(__m128i a, __m128i b, uint16_t) { return _mm_cmpeq_epi16(a, b); }
+inline __m128i cmpeqPixel(__m128i a, __m128i b, uint32_t) { return _mm_cmpeq_epi32(a, b); }
+#endif
+} // namespace detail
+
+/** Fill a table with the host colors for all combinations of red, green and
+  * blue levels. Entry '(r * numG + g) * numB + b' becomes
+  * 'rTab[r] | gTab[g] | bTab[b]', or 'keyClash' when that equals 'key'.
+  *
+  * This relies on the host pixel value of a color being the bitwise OR of
+  * the pixel values of its components, so the component tables should be
+  * filled with (the mapped values of) pure red, green and blue. That holds
+  * for all truecolor (15/16/32bpp) pixel formats. Compared to mapping every
+  * color separately, this reduces e.g. the 32768 entry V9958 table to 96
+  * mappings plus a (SSE2) loop of OR operations.
+  */
+template<typename Pixel>
+void fillColorTable(Pixel* __restrict out,
+                    const Pixel* rTab, int numR,
+                    const Pixel* gTab, int numG,
+                    const Pixel* bTab, int numB,
+                    Pixel key, Pixel keyClash)
+{
+	for (int r = 0; r < numR; ++r) {
+		for (int g = 0; g < numG; ++g) {
+			Pixel rg = rTab[r] | gTab[g];
+			int b = 0;
+#ifdef __SSE2__
+			const int N = 16 / sizeof(Pixel);
+			__m128i vRG    = detail::set1Pixel(rg);
+			__m128i vKey   = detail::set1Pixel(key);
+			__m128i vClash = detail::set1Pixel(keyClash);
+			for (/**/; (b + N) <= numB; b += N) {
+				__m128i p = _mm_or_si128(vRG, _mm_loadu_si128(
+					reinterpret_cast<const __m128i*>(bTab + b)));
+				__m128i k = detail::cmpeqPixel(p, vKey, Pixel());
+				p = _mm_or_si128(_mm_andnot_si128(k, p),
+				                 _mm_and_si128(k, vClash));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out + b), p);
+			}
+#endif
+			for (/**/; b < numB; ++b) {
+				Pixel p = rg | bTab[b];
+				out[b] = (p != key) ? p : keyClash;
+			}
+			out += numB;
+		}
+	}
+}
+
+} // namespace openmsx
+
+#endif
@@ -20,6 +20,8 @@ TODO:
 #include "MSXMotherBoard.hh"
 #include "Reactor.hh"
 #include "Timer.hh"
+#include "TclObject.hh"
+#include "outer.hh"
 #include "unreachable.hh"
 #include <algorithm>
 #include <cassert>
@@ -112,6 +114,9 @@ PixelRenderer::PixelRenderer(VDP& vdp_, Display& display)
 	, videoSourceSetting(vdp.getMotherBoard().getVideoSource())
 	, spriteChecker(vdp.getSpriteChecker())
 	, rasterizer(display.getVideoSystem().createRasterizer(vdp))
+	, statsEmuStart(EmuTime::zero)
+	, renderStatsInfo(vdp.getMotherBoard().getMachineInfoCommand(),
+	                  vdp.getName() + "_render_stats")
 {
 	// In case of loadstate we can't yet query any state from the VDP
 	// (because that object is not yet fully deserialized). But
@@ -123,6 +128,11 @@ PixelRenderer::PixelRenderer(VDP& vdp_, Display& display)
 	frameSkipCounter = 999; // force drawing of frame
 	prevRenderFrame = false;
 
+	framesRendered = 0;
+	framesSkipped = 0;
+	statsRealStart = 0; // start measuring on first frameEnd()
+	emuSpeed = 0.0;
+
 	renderSettings.getMaxFrameSkipSetting().attach(*this);
 	renderSettings.getMinFrameSkipSetting().attach(*this);
 }
@@ -146,6 +156,7 @@ void PixelRenderer::reInit()
 	renderFrame = false;
 
 	rasterizer->reset();
+	rasterizerStale = false;
 	displayEnabled = vdp.isDisplayEnabled();
 }
 
@@ -161,6 +172,7 @@ void PixelRenderer::frameStart(EmuTime::param time)
 		frameSkipCounter = 999;
 		renderFrame = false;
 		prevRenderFrame = false;
+		++framesSkipped;
 		return;
 	}
 	prevRenderFrame = renderFrame;
@@ -187,8 +199,17 @@ void PixelRenderer::frameStart(EmuTime::param time)
 			}
 		}
 	}
-	if (!renderFrame) return;
+	if (!renderFrame) {
+		++framesSkipped;
+		return;
+	}
+	++framesRendered;
 
+	if (rasterizerStale) {
+		// The VDP state changed during the skipped frame(s).
+		rasterizer->reset();
+		rasterizerStale = false;
+	}
 	rasterizer->frameStart(time);
 
 	accuracy = renderSettings.getAccuracy();
@@ -224,6 +245,7 @@ void PixelRenderer::frameEnd(EmuTime::param time)
 			skipEvent = true;
 		}
 	}
+	updateStats(time);
 	if (vdp.getMotherBoard().isActive() &&
 	    !vdp.getMotherBoard().isFastForwarding()) {
 		eventDistributor.distributeEvent(
@@ -238,7 +260,7 @@ void PixelRenderer::updateHorizontalScrollLow(
 	byte scroll, EmuTime::param time)
 {
 	if (displayEnabled) sync(time);
-	rasterizer->setHorizontalScrollLow(scroll);
+	if (updateRasterizer()) rasterizer->setHorizontalScrollLow(scroll);
 }
 
 void PixelRenderer::updateHorizontalScrollHigh(
@@ -251,7 +273,7 @@ void PixelRenderer::updateBorderMask(
 	bool masked, EmuTime::param time)
 {
 	if (displayEnabled) sync(time);
-	rasterizer->setBorderMask(masked);
+	if (updateRasterizer()) rasterizer->setBorderMask(masked);
 }
 
 void PixelRenderer::updateMultiPage(
@@ -264,7 +286,7 @@ void PixelRenderer::updateTransparency(
 	bool enabled, EmuTime::param time)
 {
 	if (displayEnabled) sync(time);
-	rasterizer->setTransparency(enabled);
+	if (updateRasterizer()) rasterizer->setTransparency(enabled);
 }
 
 void PixelRenderer::updateSuperimposing(
@@ -284,7 +306,7 @@ void PixelRenderer::updateBackgroundColor(
 	int color, EmuTime::param time)
 {
 	sync(time);
-	rasterizer->setBackgroundColor(color);
+	if (updateRasterizer()) rasterizer->setBackgroundColor(color);
 }
 
 void PixelRenderer::updateBlinkForegroundColor(
@@ -328,7 +350,7 @@ void PixelRenderer::updatePalette(
 			}
 		}
 	}
-	rasterizer->setPalette(index, grb);
+	if (updateRasterizer()) rasterizer->setPalette(index, grb);
 }
 
 void PixelRenderer::updateVerticalScroll(
@@ -341,7 +363,7 @@ void PixelRenderer::updateHorizontalAdjust(
 	int adjust, EmuTime::param time)
 {
 	if (displayEnabled) sync(time);
-	rasterizer->setHorizontalAdjust(adjust);
+	if (updateRasterizer()) rasterizer->setHorizontalAdjust(adjust);
 }
 
 void PixelRenderer::updateDisplayMode(
@@ -356,7 +378,7 @@ void PixelRenderer::updateDisplayMode(
 	|| mode.getByte() == DisplayMode::GRAPHIC7) {
 		sync(time, true);
 	}
-	rasterizer->setDisplayMode(mode);
+	if (updateRasterizer()) rasterizer->setDisplayMode(mode);
 }
 
 void PixelRenderer::updateNameBase(
@@ -600,6 +622,29 @@ void PixelRenderer::renderUntil(EmuTime::param time)
 	nextY = limitY;
 }
 
+inline bool PixelRenderer::updateRasterizer()
+{
+	if (renderFrame) return true;
+	rasterizerStale = true;
+	return false;
+}
+
+void PixelRenderer::updateStats(EmuTime::param time)
+{
+	auto now = Timer::getTime();
+	if ((statsRealStart == 0) || (time < statsEmuStart)) {
+		// First frame or time went backwards (e.g. loadstate).
+		statsRealStart = now;
+		statsEmuStart = time;
+		return;
+	}
+	auto realDelta = now - statsRealStart;
+	if (realDelta < 1000000) return; // measure over (at least) 1s
+	emuSpeed = (time - statsEmuStart).toDouble() * 1000000.0 / realDelta;
+	statsRealStart = now;
+	statsEmuStart = time;
+}
+
 void PixelRenderer::update(const Setting& setting)
 {
 	if (&setting == &renderSettings.getMinFrameSkipSetting() ||
@@ -611,4 +656,31 @@ void PixelRenderer::update(const Setting& setting)
 	}
 }
 
+
+// class RenderStatsInfo
+
+PixelRenderer::RenderStatsInfo::RenderStatsInfo(
+		InfoCommand& machineInfoCommand, const std::string& name_)
+	: InfoTopic(machineInfoCommand, name_)
+{
+}
+
+void PixelRenderer::RenderStatsInfo::execute(
+	span<const TclObject> /*tokens*/, TclObject& result) const
+{
+	auto& renderer = OUTER(PixelRenderer, renderStatsInfo);
+	result.addDictKeyValues("rendered", renderer.framesRendered,
+	                        "skipped", renderer.framesSkipped,
+	                        "emu_speed", renderer.emuSpeed);
+}
+
+std::string PixelRenderer::RenderStatsInfo::help(
+	const std::vector<std::string>& /*tokens*/) const
+{
+	return "Returns a dictionary with the number of frames that were "
+	       "rendered and skipped by this VDP's renderer, and the "
+	       "emulation speed (emulated seconds per real second, measured "
+	       "over the last second), e.g. useful during fast-forward.";
+}
+
 } // namespace openmsx
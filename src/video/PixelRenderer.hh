@@ -4,7 +4,10 @@
 #include "Renderer.hh"
 #include "Observer.hh"
 #include "RenderSettings.hh"
+#include "InfoTopic.hh"
+#include "EmuTime.hh"
 #include "openmsx.hh"
+#include <cstdint>
 #include <memory>
 
 namespace openmsx {
@@ -99,6 +102,18 @@ private:
 	  */
 	void renderUntil(EmuTime::param time);
 
+	/** Should a change in VDP state be passed to the rasterizer right away?
+	  * For skipped frames the rasterizer isn't informed about changes,
+	  * instead it's resynchronized with the VDP (see Rasterizer::reset())
+	  * at the start of the next frame that does get rendered. That way
+	  * skipped frames (e.g. during fast-forward or 'reverse goto') don't
+	  * do any rasterizer work at all.
+	  */
+	bool updateRasterizer();
+
+	/** Update the frame statistics, see RenderStatsInfo. */
+	void updateStats(EmuTime::param time);
+
 	/** The VDP of which the video output is being rendered.
 	  */
 	VDP& vdp;
@@ -148,6 +163,28 @@ private:
 	  */
 	bool renderFrame;
 	bool prevRenderFrame;
+
+	/** Did the VDP state change while the rasterizer was not informed?
+	  */
+	bool rasterizerStale;
+
+	/** Statistics: number of rendered and skipped frames, and the
+	  * emulation speed (emulated seconds per real second) measured over
+	  * (roughly) the last second.
+	  */
+	unsigned framesRendered;
+	unsigned framesSkipped;
+	uint64_t statsRealStart;
+	EmuTime statsEmuStart;
+	double emuSpeed;
+
+	struct RenderStatsInfo final : InfoTopic {
+		explicit RenderStatsInfo(InfoCommand& machineInfoCommand,
+		                         const std::string& name);
+		void execute(span<const TclObject> tokens,
+		             TclObject& result) const override;
+		std::string help(const std::vector<std::string>& tokens) const override;
+	} renderStatsInfo;
 };
 
 } // namespace openmsx
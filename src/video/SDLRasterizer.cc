@@ -6,6 +6,7 @@
 #include "Renderer.hh"
 #include "RenderSettings.hh"
 #include "PostProcessor.hh"
+#include "ColorTable.hh"
 #include "MemoryOps.hh"
 #include "VisibleSurface.hh"
 #include "build-info.hh"
@@ -239,10 +240,17 @@ void SDLRasterizer<Pixel>::setPalette(int index, int grb)
 {
 	// Update SDL colors in palette.
 	Pixel newColor = V9938_COLORS[(grb >> 4) & 7][grb >> 8][grb & 7];
+	if ((palBg[index] == newColor) && (palFg[index + 16] == newColor) &&
+	    ((index == 0) || (palFg[index] == newColor))) {
+		// Many programs rewrite the whole palette while only changing
+		// a few entries (or none at all), nothing to do then.
+		// (palFg[0] is derived from palBg, so it can't have changed.)
+		return;
+	}
 	palFg[index     ] = newColor;
 	palFg[index + 16] = newColor;
 	palBg[index     ] = newColor;
-	bitmapConverter.palette16Changed();
+	bitmapConverter.palette16Changed(index);
 
 	precalcColorIndex0(vdp.getDisplayMode(), vdp.getTransparency(),
 	                   vdp.isSuperimposing(), vdp.getBackgroundColor());
@@ -304,17 +312,18 @@ void SDLRasterizer<Pixel>::precalcPalette()
 			if (renderSettings.isColorMatrixIdentity()) {
 				// Most users use the "normal" monitor type; making this a
 				// special case speeds up palette precalculation a lot.
-				int intensity[32];
+				// The components are then independent, so only map
+				// pure red, green and blue and combine those.
+				Pixel r[32], g[32], b[32];
 				for (int i = 0; i < 32; ++i) {
-					intensity[i] =
+					int intensity =
 						int(255 * renderSettings.transformComponent(i / 31.0));
+					r[i] = screen.mapRGB255(ivec3(intensity, 0, 0));
+					g[i] = screen.mapRGB255(ivec3(0, intensity, 0));
+					b[i] = screen.mapRGB255(ivec3(0, 0, intensity));
 				}
-				for (int rgb = 0; rgb < (1 << 15); ++rgb) {
-					V9958_COLORS[rgb] = screen.mapKeyedRGB255<Pixel>(ivec3(
-						intensity[(rgb >> 10) & 31],
-						intensity[(rgb >>  5) & 31],
-						intensity[(rgb >>  0) & 31]));
-				}
+				fillColorTable(V9958_COLORS, r, 32, g, 32, b, 32,
+				               screen.getKeyColor<Pixel>(), getKeyColorClash());
 			} else {
 				for (int r = 0; r < 32; ++r) {
 					for (int g = 0; g < 32; ++g) {
@@ -344,22 +353,16 @@ void SDLRasterizer<Pixel>::precalcPalette()
 		} else {
 			// Precalculate palette for V9938 colors.
 			if (renderSettings.isColorMatrixIdentity()) {
-				int intensity[8];
+				Pixel r[8], g[8], b[8];
 				for (int i = 0; i < 8; ++i) {
-					intensity[i] =
+					int intensity =
 						int(255 * renderSettings.transformComponent(i / 7.0f));
+					r[i] = screen.mapRGB255(ivec3(intensity, 0, 0));
+					g[i] = screen.mapRGB255(ivec3(0, intensity, 0));
+					b[i] = screen.mapRGB255(ivec3(0, 0, intensity));
 				}
-				for (int r = 0; r < 8; ++r) {
-					for (int g = 0; g < 8; ++g) {
-						for (int b = 0; b < 8; ++b) {
-							V9938_COLORS[r][g][b] =
-								screen.mapKeyedRGB255<Pixel>(ivec3(
-									intensity[r],
-									intensity[g],
-									intensity[b]));
-						}
-					}
-				}
+				fillColorTable(&V9938_COLORS[0][0][0], r, 8, g, 8, b, 8,
+				               screen.getKeyColor<Pixel>(), getKeyColorClash());
 			} else {
 				for (int r = 0; r < 8; ++r) {
 					for (int g = 0; g < 8; ++g) {
@@ -389,6 +392,15 @@ void SDLRasterizer<Pixel>::precalcPalette()
 	}
 }
 
+template <class Pixel>
+Pixel SDLRasterizer<Pixel>::getKeyColorClash() const
+{
+	// Only 16bpp pixel formats can produce the key color, see
+	// OutputSurface::mapKeyedRGB255().
+	return (sizeof(Pixel) == 2) ? screen.getKeyColorClash<Pixel>()
+	                            : screen.getKeyColor<Pixel>();
+}
+
 template <class Pixel>
 void SDLRasterizer<Pixel>::precalcColorIndex0(DisplayMode mode,
 		bool transparency, const RawFrame* superimposing, byte bgcolorIndex)
@@ -406,7 +418,7 @@ void SDLRasterizer<Pixel>::precalcColorIndex0(DisplayMode mode,
 
 		if (palFg[0] != c) {
 			palFg[0] = c;
-			bitmapConverter.palette16Changed();
+			bitmapConverter.palette16Changed(0);
 		}
 	} else {
 		// TODO: superimposing
@@ -414,7 +426,7 @@ void SDLRasterizer<Pixel>::precalcColorIndex0(DisplayMode mode,
 		    (palFg[16] != palBg[tpIndex &  3])) {
 			palFg[ 0] = palBg[tpIndex >> 2];
 			palFg[16] = palBg[tpIndex &  3];
-			bitmapConverter.palette16Changed();
+			bitmapConverter.palette16Changed(0);
 		}
 	}
 }
@@ -75,6 +75,11 @@ private:
 	  */
 	void precalcPalette();
 
+	/** The pixel value that replaces the key color in the precalculated
+	  * palettes.
+	  */
+	Pixel getKeyColorClash() const;
+
 	/** Precalc foreground color index 0 (palFg[0]).
 	  * @param mode Current display mode.
 	  * @param transparency True iff transparency is enabled.
@@ -0,0 +1,222 @@
+#include "ShmWriter.hh"
+#include "FrameSource.hh"
+#include "MSXException.hh"
+#include "build-info.hh"
+#include "components.hh"
+#include "unreachable.hh"
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <new>
+#include <SDL.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+namespace openmsx {
+
+static size_t alignUp(size_t size)
+{
+	return (size + 63) & ~size_t(63); // cache line
+}
+
+static double toSeconds(EmuTime::param time)
+{
+	return (time - EmuTime::zero).toDouble();
+}
+
+ShmWriter::ShmWriter(const std::string& name_, unsigned width_, unsigned height_,
+                     unsigned bpp, unsigned channels_, unsigned sampleRate_)
+	: name(name_)
+	, width(width_), height(height_), pixelSize((bpp + 7) / 8)
+	, channels(channels_), sampleRate(sampleRate_)
+{
+#ifdef _WIN32
+	(void)name; (void)width; (void)height; (void)pixelSize;
+	throw MSXException("Shared memory export is not supported on this platform.");
+#else
+	size_t headerSize = alignUp(sizeof(ShmHeader));
+	size_t videoSlotSize = width
+		? alignUp(alignUp(sizeof(VideoSlot)) + width * height * pixelSize)
+		: 0;
+	size_t audioSlotSize = channels
+		? alignUp(alignUp(sizeof(AudioSlot)) +
+		          MAX_AUDIO_SAMPLES * channels * sizeof(int16_t))
+		: 0;
+	unsigned videoSlots = width    ? VIDEO_SLOTS : 0;
+	unsigned audioSlots = channels ? AUDIO_SLOTS : 0;
+	size = headerSize + videoSlots * videoSlotSize + audioSlots * audioSlotSize;
+
+	int fd = shm_open(name.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0600);
+	if (fd == -1) {
+		throw MSXException("Couldn't create shared memory '", name,
+		                   "': ", strerror(errno));
+	}
+	if (ftruncate(fd, size) == -1) {
+		int err = errno;
+		close(fd);
+		shm_unlink(name.c_str());
+		throw MSXException("Couldn't resize shared memory '", name,
+		                   "': ", strerror(err));
+	}
+	void* m = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd); // the mapping stays valid
+	if (m == MAP_FAILED) {
+		int err = errno;
+		shm_unlink(name.c_str());
+		throw MSXException("Couldn't map shared memory '", name,
+		                   "': ", strerror(err));
+	}
+	mem = static_cast<uint8_t*>(m);
+
+	// ftruncate() zero-filled the memory, so all sequence numbers and
+	// counters are already 0
+	auto* header = new (mem) ShmHeader;
+	memcpy(header->magic, "openMSX", 8);
+	header->version = VERSION;
+	header->pid = uint32_t(getpid());
+	header->videoSlots    = videoSlots;
+	header->videoSlotSize = uint32_t(videoSlotSize);
+	header->videoOffset   = uint32_t(headerSize);
+	header->audioSlots    = audioSlots;
+	header->audioSlotSize = uint32_t(audioSlotSize);
+	header->audioOffset   = uint32_t(headerSize + videoSlots * videoSlotSize);
+	header->notify.store(0, std::memory_order_relaxed);
+	header->waiters.store(0, std::memory_order_relaxed);
+	header->videoWritten.store(0, std::memory_order_relaxed);
+	header->audioWritten.store(0, std::memory_order_relaxed);
+#endif
+}
+
+ShmWriter::~ShmWriter()
+{
+#ifndef _WIN32
+	munmap(mem, size);
+	shm_unlink(name.c_str());
+#endif
+}
+
+void ShmWriter::signal()
+{
+	// Both are sequentially consistent: either a reader that is about to
+	// block sees the new 'notify' value (and FUTEX_WAIT returns
+	// immediately), or we see its 'waiters' increment and wake it.
+	auto& header = *reinterpret_cast<ShmHeader*>(mem);
+	header.notify.fetch_add(1);
+#ifdef __linux__
+	if (header.waiters.load()) {
+		syscall(SYS_futex, &header.notify, FUTEX_WAKE, INT_MAX,
+		        nullptr, nullptr, 0);
+	}
+#endif
+}
+
+template<typename Pixel>
+static const Pixel* getScaledLine(FrameSource* frame, unsigned height,
+                                  unsigned y, Pixel* buf)
+{
+	switch (height) {
+	case 240:
+		return frame->getLinePtr320_240(y, buf);
+	case 480:
+		return frame->getLinePtr640_480(y, buf);
+	case 720:
+		return frame->getLinePtr960_720(y, buf);
+	default:
+		UNREACHABLE; return nullptr;
+	}
+}
+
+void ShmWriter::addFrame(FrameSource* frame, EmuTime::param time)
+{
+	auto& header = *reinterpret_cast<ShmHeader*>(mem);
+	assert(header.videoSlots);
+	uint64_t n = header.videoWritten.load(std::memory_order_relaxed) + 1;
+	uint8_t* slotMem = mem + header.videoOffset +
+		((n - 1) % header.videoSlots) * header.videoSlotSize;
+	auto& slot = *reinterpret_cast<VideoSlot*>(slotMem);
+	slot.sequence.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	const auto& format = frame->getSDLPixelFormat();
+	slot.emuTime = toSeconds(time);
+	slot.width = width;
+	slot.height = height;
+	slot.pitch = width * pixelSize;
+	slot.bytesPerPixel = pixelSize;
+	slot.rMask = format.Rmask;
+	slot.gMask = format.Gmask;
+	slot.bMask = format.Bmask;
+	slot.aMask = format.Amask;
+
+	// Lines are written directly into the slot when getLinePtr*() uses the
+	// given buffer, otherwise they're copied from the returned pointer.
+	uint8_t* pixels = slotMem + alignUp(sizeof(VideoSlot));
+	unsigned pitch = width * pixelSize;
+	for (unsigned y = 0; y < height; ++y) {
+		uint8_t* dest = pixels + y * pitch;
+		const void* line;
+#if HAVE_32BPP
+		if (pixelSize == 4) {
+			line = getScaledLine(frame, height, y,
+			                     reinterpret_cast<uint32_t*>(dest));
+		} else
+#endif
+#if HAVE_16BPP
+		if (pixelSize == 2) {
+			line = getScaledLine(frame, height, y,
+			                     reinterpret_cast<uint16_t*>(dest));
+		} else
+#endif
+		{
+			UNREACHABLE; line = dest;
+		}
+		if (line != dest) memcpy(dest, line, pitch);
+	}
+
+	slot.sequence.store(n, std::memory_order_release);
+	header.videoWritten.store(n, std::memory_order_release);
+	signal();
+}
+
+void ShmWriter::addAudio(const int16_t* data, unsigned samples, EmuTime::param time)
+{
+	auto& header = *reinterpret_cast<ShmHeader*>(mem);
+	assert(header.audioSlots);
+	while (samples) {
+		unsigned num = std::min(samples, unsigned(MAX_AUDIO_SAMPLES));
+		uint64_t n = header.audioWritten.load(std::memory_order_relaxed) + 1;
+		uint8_t* slotMem = mem + header.audioOffset +
+			((n - 1) % header.audioSlots) * header.audioSlotSize;
+		auto& slot = *reinterpret_cast<AudioSlot*>(slotMem);
+		slot.sequence.store(0, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		// 'time' is the end of the fragment
+		slot.emuTime = toSeconds(time) - double(samples) / sampleRate;
+		slot.samples = num;
+		slot.channels = channels;
+		slot.sampleRate = sampleRate;
+		memcpy(slotMem + alignUp(sizeof(AudioSlot)), data,
+		       num * channels * sizeof(int16_t));
+
+		slot.sequence.store(n, std::memory_order_release);
+		header.audioWritten.store(n, std::memory_order_release);
+		signal();
+
+		data += num * channels;
+		samples -= num;
+	}
+}
+
+} // namespace openmsx
@@ -0,0 +1,102 @@
+#ifndef SHMWRITER_HH
+#define SHMWRITER_HH
+
+#include "EmuTime.hh"
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace openmsx {
+
+class FrameSource;
+
+/** Exports video frames and audio fragments to a POSIX shared memory object,
+  * so that other local processes can consume them without going through a
+  * file. Used by 'record start -shm'.
+  *
+  * The shared memory starts with a ShmHeader, followed by a ring of
+  * 'videoSlots' video slots and a ring of 'audioSlots' audio slots. Each
+  * slot starts with a slot header, followed by the pixels (lines of 'pitch'
+  * bytes) or the 16-bit (interleaved) samples. Item 'n' (counting from 1)
+  * is stored in slot '(n - 1) % numSlots'. The 'sequence' field of a slot is
+  * 0 while the slot is being written and 'n' afterwards, so a reader checks
+  * it before and after copying the data. 'videoWritten'/'audioWritten' count
+  * the items that are completely written.
+  *
+  * 'notify' is incremented after each item. On Linux a reader can block
+  * until the next item with a (shared, so no FUTEX_PRIVATE_FLAG) futex
+  * wait on it: increment 'waiters', load 'notify', check the counters and
+  * if there is nothing new call FUTEX_WAIT with the loaded value, then
+  * decrement 'waiters'. The writer only calls FUTEX_WAKE when 'waiters'
+  * is non-zero. On other systems readers should poll the counters.
+  */
+class ShmWriter
+{
+public:
+	static constexpr uint32_t VERSION = 1;
+	static const unsigned VIDEO_SLOTS = 4;
+	static const unsigned AUDIO_SLOTS = 32;
+	static const unsigned MAX_AUDIO_SAMPLES = 8192; // per fragment
+
+	struct ShmHeader {
+		char magic[8]; // "openMSX\0"
+		uint32_t version;
+		uint32_t pid;
+		uint32_t videoSlots;     // 0 when not exporting video
+		uint32_t videoSlotSize;  // in bytes, including the slot header
+		uint32_t videoOffset;    // of the first video slot
+		uint32_t audioSlots;     // 0 when not exporting audio
+		uint32_t audioSlotSize;
+		uint32_t audioOffset;
+		std::atomic<uint32_t> notify;  // futex word
+		std::atomic<uint32_t> waiters; // number of blocked readers
+		std::atomic<uint64_t> videoWritten;
+		std::atomic<uint64_t> audioWritten;
+	};
+	struct VideoSlot {
+		std::atomic<uint64_t> sequence;
+		double emuTime; // in seconds
+		uint32_t width;
+		uint32_t height;
+		uint32_t pitch;          // in bytes
+		uint32_t bytesPerPixel;  // 2 or 4, native endianness
+		uint32_t rMask, gMask, bMask, aMask;
+	};
+	struct AudioSlot {
+		std::atomic<uint64_t> sequence;
+		double emuTime; // of the first sample, in seconds
+		uint32_t samples;        // number of sample frames
+		uint32_t channels;       // 1 or 2
+		uint32_t sampleRate;
+		uint32_t reserved;
+	};
+
+	/** Creates (or replaces) the shared memory object with the given
+	  * name, should start with a '/'. Pass width == 0 to only export
+	  * audio and channels == 0 to only export video.
+	  */
+	ShmWriter(const std::string& name, unsigned width, unsigned height,
+	          unsigned bpp, unsigned channels, unsigned sampleRate);
+	~ShmWriter();
+
+	void addFrame(FrameSource* frame, EmuTime::param time);
+	void addAudio(const int16_t* data, unsigned samples, EmuTime::param time);
+
+	const std::string& getName() const { return name; }
+
+private:
+	void signal();
+
+	const std::string name;
+	uint8_t* mem = nullptr;
+	size_t size = 0;
+	const unsigned width;
+	const unsigned height;
+	const unsigned pixelSize;
+	const unsigned channels;
+	const unsigned sampleRate;
+};
+
+} // namespace openmsx
+
+#endif
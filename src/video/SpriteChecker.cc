@@ -9,8 +9,10 @@ TODO:
 */
 
 #include "SpriteChecker.hh"
+#include "SpriteYMatch.hh"
 #include "RenderSettings.hh"
 #include "BooleanSetting.hh"
+#include "Math.hh"
 #include "serialize.hh"
 #include <algorithm>
 #include <cassert>
@@ -22,6 +24,7 @@ SpriteChecker::SpriteChecker(VDP& vdp_, RenderSettings& renderSettings,
 	: vdp(vdp_), vram(vdp.getVRAM())
 	, limitSpritesSetting(renderSettings.getLimitSpritesSetting())
 	, frameStartTime(time)
+	, spriteYValid(false)
 {
 	vram.spriteAttribTable.setObserver(this);
 	vram.spritePatternTable.setObserver(this);
@@ -32,6 +35,7 @@ void SpriteChecker::reset(EmuTime::param time)
 	vdp.setSpriteStatus(0); // TODO 0x00 or 0x1F  (blueMSX has 0x1F)
 	collisionX = 0;
 	collisionY = 0;
+	spriteYValid = false;
 
 	frameStart(time);
 
@@ -78,6 +82,22 @@ inline SpriteChecker::SpritePattern SpriteChecker::calculatePatternPlanar(
 	return !vdp.isSpriteMag() ? pattern : doublePattern(pattern);
 }
 
+inline void SpriteChecker::updateSpriteY(
+	const byte* yPtr, unsigned stride, byte terminator)
+{
+	if (spriteYValid) return;
+	spriteYValid = true;
+	spriteYCount = 32;
+	for (int sprite = 0; sprite < 32; ++sprite) {
+		byte y = yPtr[stride * sprite];
+		if (y == terminator) {
+			spriteYCount = sprite;
+			break;
+		}
+		spriteY[sprite] = y;
+	}
+}
+
 void SpriteChecker::updateSprites1(int limit)
 {
 	if (vdp.spritesEnabledFast()) {
@@ -128,10 +148,14 @@ inline void SpriteChecker::checkSprites1(int minLine, int maxLine)
 	int fifthSpriteNum  = -1;  // no 5th sprite detected yet
 	int fifthSpriteLine = 999; // larger than any possible valid line
 
-	int sprite = 0;
-	for (/**/; sprite < 32; ++sprite) {
-		int y = attributePtr[4 * sprite + 0];
-		if (y == 208) break;
+	// Only visit the sprites that are visible on at least one of the lines.
+	updateSpriteY(attributePtr, 4, 208);
+	uint32_t visible = matchSpriteY(spriteY, spriteYCount,
+		minLine + displayDelta, maxLine - minLine, magSize);
+	while (visible) {
+		int sprite = Math::findFirstSet(visible) - 1;
+		visible &= visible - 1;
+		int y = spriteY[sprite];
 
 		for (int line = minLine; line < maxLine; ++line) {
 			// Calculate line number within the sprite.
@@ -178,7 +202,7 @@ inline void SpriteChecker::checkSprites1(int minLine, int maxLine)
 	}
 	if (~status & 0x40) {
 		// No 5th sprite detected, store number of latest sprite processed.
-		status = (status & 0x20) | std::min(sprite, 31);
+		status = (status & 0x20) | std::min(spriteYCount, 31);
 	}
 	vdp.setSpriteStatus(status);
 
@@ -285,16 +309,21 @@ inline void SpriteChecker::checkSprites2(int minLine, int maxLine)
 
 	// Because it gave a measurable performance boost, we duplicated the
 	// code for planar and non-planar modes.
-	int sprite = 0;
+	// Only the sprites that are visible on at least one of the lines are
+	// visited (see checkSprites1()).
 	if (planar) {
 		const byte* attributePtr0;
 		const byte* attributePtr1;
 		vram.spriteAttribTable.getReadAreaPlanar(
 			512, 32 * 4, attributePtr0, attributePtr1);
+		updateSpriteY(attributePtr0, 2, 216);
+		uint32_t visible = matchSpriteY(spriteY, spriteYCount,
+			minLine + displayDelta, maxLine - minLine, magSize);
 		// TODO: Verify CC implementation.
-		for (/**/; sprite < 32; ++sprite) {
-			int y = attributePtr0[2 * sprite + 0];
-			if (y == 216) break;
+		while (visible) {
+			int sprite = Math::findFirstSet(visible) - 1;
+			visible &= visible - 1;
+			int y = spriteY[sprite];
 
 			for (int line = minLine; line < maxLine; ++line) {
 				// Calculate line number within the sprite.
@@ -336,10 +365,14 @@ inline void SpriteChecker::checkSprites2(int minLine, int maxLine)
 	} else {
 		const byte* attributePtr0 =
 			vram.spriteAttribTable.getReadArea(512, 32 * 4);
+		updateSpriteY(attributePtr0, 4, 216);
+		uint32_t visible = matchSpriteY(spriteY, spriteYCount,
+			minLine + displayDelta, maxLine - minLine, magSize);
 		// TODO: Verify CC implementation.
-		for (/**/; sprite < 32; ++sprite) {
-			int y = attributePtr0[4 * sprite + 0];
-			if (y == 216) break;
+		while (visible) {
+			int sprite = Math::findFirstSet(visible) - 1;
+			visible &= visible - 1;
+			int y = spriteY[sprite];
 
 			for (int line = minLine; line < maxLine; ++line) {
 				// Calculate line number within the sprite.
@@ -405,7 +438,7 @@ inline void SpriteChecker::checkSprites2(int minLine, int maxLine)
 	}
 	if (~status & 0x40) {
 		// No 9th sprite detected, store number of latest sprite processed.
-		status = (status & 0x20) | std::min(sprite, 31);
+		status = (status & 0x20) | std::min(spriteYCount, 31);
 	}
 	vdp.setSpriteStatus(status);
 
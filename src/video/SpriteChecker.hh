@@ -240,10 +240,13 @@ public:
 
 	void updateVRAM(unsigned /*offset*/, EmuTime::param time) override {
 		checkUntil(time);
+		// The write happens after this call.
+		spriteYValid = false;
 	}
 
 	void updateWindow(bool /*enabled*/, EmuTime::param time) override {
 		sync(time);
+		spriteYValid = false;
 	}
 
 	template<typename Archive>
@@ -253,6 +256,7 @@ private:
 	/** Calculate 'updateSpritesMethod' and 'planar'.
 	  */
 	inline void setDisplayMode(DisplayMode mode) {
+		spriteYValid = false;
 		switch (mode.getSpriteMode(vdp.isMSX1VDP())) {
 		case 0:
 			updateSpritesMethod = nullptr;
@@ -290,6 +294,16 @@ private:
 	inline SpritePattern calculatePatternNP(unsigned patternNr, unsigned y);
 	inline SpritePattern calculatePatternPlanar(unsigned patternNr, unsigned y);
 
+	/** (Re)fill the spriteY[] cache, if needed.
+	  * @param yPtr Pointer to the Y-coordinate of sprite 0.
+	  * @param stride Distance (in bytes) between the Y-coordinates of
+	  *   two consecutive sprites.
+	  * @param terminator Y-coordinate that marks the end of the sprite
+	  *   attribute table (208 in sprite mode 1, 216 in sprite mode 2).
+	  */
+	inline void updateSpriteY(const byte* yPtr, unsigned stride,
+	                          byte terminator);
+
 	/** Check sprite collision and number of sprites per line.
 	  * This routine implements sprite mode 1 (MSX1).
 	  * Separated from display code to make MSX behaviour consistent
@@ -365,6 +379,16 @@ private:
 	  */
 	uint8_t spriteCount[313];
 
+	/** Y-coordinates of the sprites before the terminator, gathered
+	  * from the sprite attribute table so that all sprites can be matched
+	  * against the to-be-checked lines at once (see matchSpriteY()).
+	  * Only rebuilt after the sprite attribute or pattern table was
+	  * written or moved, or after a display mode change.
+	  */
+	byte spriteY[32];
+	int spriteYCount;
+	bool spriteYValid;
+
 	/** Is current display mode planar or not?
 	  * TODO: Introduce separate update methods for planar/nonplanar modes.
 	  */
@@ -0,0 +1,68 @@
+#ifndef SPRITEYMATCH_HH
+#define SPRITEYMATCH_HH
+
+#include "openmsx.hh"
+#include <cstdint>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace openmsx {
+
+/** Find the sprites that are (partly) visible on a range of lines.
+  * @param spriteY Y-coordinates of the 32 sprites, as stored in the sprite
+  *   attribute table. Must point to 32 bytes, but only the first 'count'
+  *   entries are used.
+  * @param count The number of sprites before the terminator (0..32).
+  * @param displayLine The display line (in VRAM coordinates, so including
+  *   vertical scroll) of the first line of the range.
+  * @param numLines The number of lines in the range, must be at least 1.
+  * @param magSize Height of the sprites in lines, corrected for
+  *   magnification.
+  * @return A bitmask where bit 'n' is set iff sprite 'n' is visible on at
+  *   least one line of the range.
+  *
+  * A sprite is visible on a line when '(line - y) & 0xFF' is smaller than
+  * 'magSize'. Over a range of lines that means: either the sprite is already
+  * visible on the first line, or the top of the sprite lies within the range.
+  * Both tests only need 8-bit (wrapping) arithmetic, which allows to check
+  * all sprites at once.
+  */
+inline uint32_t matchSpriteY(const byte* spriteY, int count,
+                             int displayLine, int numLines, int magSize)
+{
+	if (count == 0) return 0;
+	uint32_t countMask = (count == 32) ? ~0u : ((1u << count) - 1);
+	// Largest (inclusive) values for the in-sprite and till-top distances.
+	byte maxIn  = magSize - 1;
+	byte maxTop = (numLines > 256) ? 255 : (numLines - 1);
+#ifdef __SSE2__
+	__m128i line = _mm_set1_epi8(char(displayLine));
+	__m128i mIn  = _mm_set1_epi8(char(maxIn));
+	__m128i mTop = _mm_set1_epi8(char(maxTop));
+	__m128i zero = _mm_setzero_si128();
+	uint32_t result = 0;
+	for (int i = 0; i < 2; ++i) {
+		__m128i y = _mm_loadu_si128(
+			reinterpret_cast<const __m128i*>(spriteY + 16 * i));
+		// 'x <= max' (unsigned) is the same as 'saturate(x - max) == 0'
+		__m128i in  = _mm_subs_epu8(_mm_sub_epi8(line, y), mIn);
+		__m128i top = _mm_subs_epu8(_mm_sub_epi8(y, line), mTop);
+		__m128i vis = _mm_cmpeq_epi8(_mm_min_epu8(in, top), zero);
+		result |= uint32_t(_mm_movemask_epi8(vis)) << (16 * i);
+	}
+	return result & countMask;
+#else
+	uint32_t result = 0;
+	for (int i = 0; i < count; ++i) {
+		byte in  = displayLine - spriteY[i];
+		byte top = spriteY[i] - displayLine;
+		if ((in <= maxIn) || (top <= maxTop)) result |= 1u << i;
+	}
+	return result & countMask;
+#endif
+}
+
+} // namespace openmsx
+
+#endif
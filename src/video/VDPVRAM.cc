@@ -94,6 +94,22 @@ void VDPVRAM::PhysicalVRAMDebuggable::write(
 	vram.cpuWrite(address, value, time);
 }
 
+void VDPVRAM::PhysicalVRAMDebuggable::readBlock(unsigned start, span<byte> output)
+{
+	// Same as cpuRead() for each byte, but sync with the command engine
+	// only once.
+	auto& vram = OUTER(VDPVRAM, physicalVRAMDebug);
+	auto time = getMotherBoard().getCurrentTime();
+	assert(vram.vdp.isInsideFrame(time));
+	assert((start + output.size()) <= getSize());
+	vram.cmdEngine->sync(time);
+	vram.cmdEngine->stealAccessSlot(time);
+	#ifdef DEBUG
+	vram.vramTime = time;
+	#endif
+	memcpy(output.data(), &vram.data[start], output.size());
+}
+
 
 // class VDPVRAM
 
@@ -211,6 +227,11 @@ void VDPVRAM::updateVRMode(bool newVRmode, EmuTime::param time)
 	}
 	vrMode = newVRmode;
 	setSizeMask(time);
+	// The sprite checker caches sprite Y values. setSizeMask() doesn't
+	// notify it when the mask doesn't change, and the swap below doesn't
+	// go through the windows.
+	spriteAttribTable.updateWindow(time);
+	spritePatternTable.updateWindow(time);
 
 	if (vrMode) {
 		// switch from VR=0 to VR=1
@@ -238,7 +259,7 @@ void VDPVRAM::setRenderer(Renderer* newRenderer, EmuTime::param time)
 	bitmapVisibleWindow.setObserver(renderer);
 }
 
-void VDPVRAM::change4k8kMapping(bool mapping8k)
+void VDPVRAM::change4k8kMapping(bool mapping8k, EmuTime::param time)
 {
 	/* Sources:
 	 *  - http://www.msx.org/forumtopicl8624.html
@@ -282,6 +303,11 @@ void VDPVRAM::change4k8kMapping(bool mapping8k)
 	 * even in 4K mode, all 16K of VRAM can be accessed. The only
 	 * difference is in what addresses are used to store data.
 	 */
+	// like in updateVRMode(), the data is moved without going through
+	// the windows
+	spriteAttribTable.updateWindow(time);
+	spritePatternTable.updateWindow(time);
+
 	byte tmp[0x4000];
 	if (mapping8k) {
 		// from 8k/16k to 4k mapping
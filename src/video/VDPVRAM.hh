@@ -265,6 +265,15 @@ public:
 		return data[addr];
 	}
 
+	/** Notifies the observer that the VRAM contents were rearranged
+	  * without going through a window (see VDPVRAM::updateVRMode() and
+	  * change4k8kMapping()). Must be called before the change.
+	  * @param time The moment in emulated time this change occurs.
+	  */
+	inline void updateWindow(EmuTime::param time) {
+		observer->updateWindow(isEnabled(), time);
+	}
+
 	/** Is there an observer registered for this window?
 	  */
 	inline bool hasObserver() const {
@@ -541,7 +550,7 @@ public:
 	/** TMS99x8 VRAM can be mapped in two ways.
 	  * See implementation for more details.
 	  */
-	void change4k8kMapping(bool mapping8k);
+	void change4k8kMapping(bool mapping8k, EmuTime::param time);
 
 	template<typename Archive>
 	void serialize(Archive& ar, unsigned version);
@@ -627,6 +636,7 @@ private:
 		PhysicalVRAMDebuggable(VDP& vdp, unsigned actualSize);
 		byte read(unsigned address, EmuTime::param time) override;
 		void write(unsigned address, byte value, EmuTime::param time) override;
+		void readBlock(unsigned start, span<byte> output) override;
 	} physicalVRAMDebug;
 
 	// TODO: Renderer field can be removed, if updateDisplayMode
@@ -5,8 +5,12 @@
 #include "unreachable.hh"
 #include "build-info.hh"
 #include "components.hh"
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 namespace openmsx {
 
@@ -149,23 +153,78 @@ static void rasterBD16(
 			out += 1;
 		}
 	} else {
-		for (/**/; nrPixels > 0; --nrPixels) {
-			byte low  = vram.readVRAMBx(address++);
-			byte high = vram.readVRAMBx(address++);
-			*out++ = color.lookup32768((low + 256 * high) & 0x7FFF);
+		// The low bytes are stored in the lower and the high bytes in
+		// the upper half of VRAM (at the same offset), see
+		// V9990VRAM::transformBx().
+		const byte* data = vram.getData();
+		unsigned offset = (address / 2) & 0x3FFFF;
+		while (nrPixels > 0) {
+			unsigned num = std::min<unsigned>(nrPixels, 0x40000 - offset);
+			const byte* low  = data + offset;
+			const byte* high = data + offset + 0x40000;
+			unsigned i = 0;
+#ifdef __SSE2__
+			// Combine 8 low and high bytes into 15-bit color indices
+			// at once, only the palette lookup remains scalar.
+			const __m128i mask = _mm_set1_epi16(0x7FFF);
+			for (/**/; (i + 8) <= num; i += 8) {
+				__m128i l = _mm_loadl_epi64(
+					reinterpret_cast<const __m128i*>(low + i));
+				__m128i h = _mm_loadl_epi64(
+					reinterpret_cast<const __m128i*>(high + i));
+				__m128i idx = _mm_and_si128(_mm_unpacklo_epi8(l, h), mask);
+				alignas(16) uint16_t tmp[8];
+				_mm_store_si128(reinterpret_cast<__m128i*>(tmp), idx);
+				for (unsigned j = 0; j < 8; ++j) {
+					out[i + j] = color.lookup32768(tmp[j]);
+				}
+			}
+#endif
+			for (/**/; i < num; ++i) {
+				out[i] = color.lookup32768((low[i] + 256 * high[i]) & 0x7FFF);
+			}
+			out += num;
+			nrPixels -= num;
+			offset = 0;
 		}
 	}
 }
 
+// In the BD8 and BP6 modes consecutive pixels are alternately stored in the
+// lower and upper half of VRAM. Read them pairwise, that avoids the address
+// transformation per pixel.
+template<typename Pixel, typename Lookup>
+static inline void rasterBx8(
+	Lookup lookup, V9990VRAM& vram,
+	Pixel* __restrict out, unsigned address, int nrPixels)
+{
+	const byte* data = vram.getData();
+	address &= 0x7FFFF;
+	if ((address & 1) && (nrPixels > 0)) {
+		*out++ = lookup(data[0x40000 + address / 2]);
+		address = (address + 1) & 0x7FFFF;
+		--nrPixels;
+	}
+	unsigned offset = address / 2;
+	for (/**/; nrPixels >= 2; nrPixels -= 2) {
+		*out++ = lookup(data[offset + 0x00000]);
+		*out++ = lookup(data[offset + 0x40000]);
+		offset = (offset + 1) & 0x3FFFF;
+	}
+	if (nrPixels > 0) {
+		*out = lookup(data[offset]);
+	}
+}
+
 template<typename Pixel, typename ColorLookup>
 static void rasterBD8(
 	ColorLookup color, V9990& vdp, V9990VRAM& vram,
 	Pixel* __restrict out, unsigned x, unsigned y, int nrPixels)
 {
 	unsigned address = x + y * vdp.getImageWidth();
-	for (/**/; nrPixels > 0; --nrPixels) {
-		*out++ = color.lookup256(vram.readVRAMBx(address++));
-	}
+	rasterBx8(
+		[&](byte b) { return color.lookup256(b); },
+		vram, out, address, nrPixels);
 }
 
 template<typename Pixel, typename ColorLookup>
@@ -174,9 +233,9 @@ static void rasterBP6(
 	Pixel* __restrict out, unsigned x, unsigned y, int nrPixels)
 {
 	unsigned address = x + y * vdp.getImageWidth();
-	for (/**/; nrPixels > 0; --nrPixels) {
-		*out++ = color.lookup64(vram.readVRAMBx(address++) & 0x3F);
-	}
+	rasterBx8(
+		[&](byte b) { return color.lookup64(b & 0x3F); },
+		vram, out, address, nrPixels);
 }
 
 template<typename Pixel, typename ColorLookup>
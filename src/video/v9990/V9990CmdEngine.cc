@@ -2,6 +2,7 @@
 #include "V9990.hh"
 #include "V9990VRAM.hh"
 #include "V9990DisplayTiming.hh"
+#include "V9990LogOps.hh"
 #include "MSXMotherBoard.hh"
 #include "RenderSettings.hh"
 #include "BooleanSetting.hh"
@@ -11,6 +12,8 @@
 #include "serialize.hh"
 #include "likely.hh"
 #include "unreachable.hh"
+#include <algorithm>
+#include <cassert>
 #include <iostream>
 
 namespace openmsx {
@@ -315,6 +318,25 @@ inline void V9990CmdEngine::V9990P1::psetColor(
 	vram.writeVRAMDirect(addr, result);
 }
 
+inline unsigned V9990CmdEngine::V9990P1::psetColorRow(
+	V9990VRAM& vram, unsigned x, unsigned y, unsigned pitch,
+	int /*dx*/, unsigned /*num*/,
+	word color, word mask, const byte* lut, byte op)
+{
+	psetColor(vram, x, y, pitch, color, mask, lut, op);
+	return 1;
+}
+
+inline unsigned V9990CmdEngine::V9990P1::psetRow(
+	V9990VRAM& vram, unsigned sx, unsigned sy,
+	unsigned x, unsigned y, unsigned pitch, int /*dx*/, unsigned /*num*/,
+	word mask, const byte* lut, byte op)
+{
+	byte src = shift(point(vram, sx, sy, pitch), sx, x);
+	pset(vram, x, y, pitch, src, mask, lut, op);
+	return 1;
+}
+
 // P2 --------------------------------------------------------------
 inline unsigned V9990CmdEngine::V9990P2::getPitch(unsigned width)
 {
@@ -384,6 +406,25 @@ inline void V9990CmdEngine::V9990P2::psetColor(
 	vram.writeVRAMDirect(addr, result);
 }
 
+inline unsigned V9990CmdEngine::V9990P2::psetColorRow(
+	V9990VRAM& vram, unsigned x, unsigned y, unsigned pitch,
+	int /*dx*/, unsigned /*num*/,
+	word color, word mask, const byte* lut, byte op)
+{
+	psetColor(vram, x, y, pitch, color, mask, lut, op);
+	return 1;
+}
+
+inline unsigned V9990CmdEngine::V9990P2::psetRow(
+	V9990VRAM& vram, unsigned sx, unsigned sy,
+	unsigned x, unsigned y, unsigned pitch, int /*dx*/, unsigned /*num*/,
+	word mask, const byte* lut, byte op)
+{
+	byte src = shift(point(vram, sx, sy, pitch), sx, x);
+	pset(vram, x, y, pitch, src, mask, lut, op);
+	return 1;
+}
+
 // 2 bpp --------------------------------------------------------------
 inline unsigned V9990CmdEngine::V9990Bpp2::getPitch(unsigned width)
 {
@@ -452,6 +493,25 @@ inline void V9990CmdEngine::V9990Bpp2::psetColor(
 	vram.writeVRAMDirect(addr, result);
 }
 
+inline unsigned V9990CmdEngine::V9990Bpp2::psetColorRow(
+	V9990VRAM& vram, unsigned x, unsigned y, unsigned pitch,
+	int /*dx*/, unsigned /*num*/,
+	word color, word mask, const byte* lut, byte op)
+{
+	psetColor(vram, x, y, pitch, color, mask, lut, op);
+	return 1;
+}
+
+inline unsigned V9990CmdEngine::V9990Bpp2::psetRow(
+	V9990VRAM& vram, unsigned sx, unsigned sy,
+	unsigned x, unsigned y, unsigned pitch, int /*dx*/, unsigned /*num*/,
+	word mask, const byte* lut, byte op)
+{
+	byte src = shift(point(vram, sx, sy, pitch), sx, x);
+	pset(vram, x, y, pitch, src, mask, lut, op);
+	return 1;
+}
+
 // 4 bpp --------------------------------------------------------------
 inline unsigned V9990CmdEngine::V9990Bpp4::getPitch(unsigned width)
 {
@@ -520,6 +580,25 @@ inline void V9990CmdEngine::V9990Bpp4::psetColor(
 	vram.writeVRAMDirect(addr, result);
 }
 
+inline unsigned V9990CmdEngine::V9990Bpp4::psetColorRow(
+	V9990VRAM& vram, unsigned x, unsigned y, unsigned pitch,
+	int /*dx*/, unsigned /*num*/,
+	word color, word mask, const byte* lut, byte op)
+{
+	psetColor(vram, x, y, pitch, color, mask, lut, op);
+	return 1;
+}
+
+inline unsigned V9990CmdEngine::V9990Bpp4::psetRow(
+	V9990VRAM& vram, unsigned sx, unsigned sy,
+	unsigned x, unsigned y, unsigned pitch, int /*dx*/, unsigned /*num*/,
+	word mask, const byte* lut, byte op)
+{
+	byte src = shift(point(vram, sx, sy, pitch), sx, x);
+	pset(vram, x, y, pitch, src, mask, lut, op);
+	return 1;
+}
+
 // 8 bpp --------------------------------------------------------------
 inline unsigned V9990CmdEngine::V9990Bpp8::getPitch(unsigned width)
 {
@@ -585,6 +664,83 @@ inline void V9990CmdEngine::V9990Bpp8::psetColor(
 	vram.writeVRAMDirect(addr, result);
 }
 
+// In the 8bpp and 16bpp modes the pixels of one row are stored in at most two
+// contiguous VRAM ranges. These helpers clip a run of 'num' pixels starting at
+// 'x' (going in direction 'dx') so that it doesn't wrap around the image
+// width, and return the left-most x-coordinate of the (clipped) run.
+static inline unsigned clipRun(unsigned x, unsigned pitch, int dx, unsigned& num)
+{
+	unsigned xx = x & (pitch - 1);
+	if (dx > 0) {
+		num = std::min(num, pitch - xx);
+		return xx;
+	} else {
+		num = std::min(num, xx + 1);
+		return xx - (num - 1);
+	}
+}
+static inline unsigned clipRun(unsigned sx, unsigned x, unsigned pitch, int dx,
+                               unsigned& num, unsigned& sLeft)
+{
+	clipRun(sx, pitch, dx, num);
+	unsigned left = clipRun(x, pitch, dx, num);
+	sLeft = clipRun(sx, pitch, dx, num);
+	return left;
+}
+
+inline unsigned V9990CmdEngine::V9990Bpp8::psetColorRow(
+	V9990VRAM& vram, unsigned x, unsigned y, unsigned pitch,
+	int dx, unsigned num,
+	word color, word mask, const byte* lut, byte op)
+{
+	// Each pixel only depends on itself, so the run can be processed
+	// from left to right (also when dx < 0).
+	unsigned lin = clipRun(x, pitch, dx, num) + y * pitch;
+	// Even (linear) addresses are in the lower, odd addresses in the upper
+	// half of VRAM, see V9990VRAM::transformBx(). A row never straddles
+	// the end of VRAM because the pitch is a power of 2.
+	byte* data = vram.getWriteBackdoor();
+	for (unsigned bank = 0; bank < 2; ++bank) {
+		unsigned first = (bank - lin) & 1;
+		if (first >= num) continue;
+		unsigned addr = V9990VRAM::transformBx(lin + first) & 0x7FFFF;
+		V9990LogOps::fillRow8(
+			data + addr, (num - first + 1) / 2,
+			bank ? (color >> 8) : (color & 0xFF),
+			bank ? (mask  >> 8) : (mask  & 0xFF), op, lut);
+	}
+	return num;
+}
+
+inline unsigned V9990CmdEngine::V9990Bpp8::psetRow(
+	V9990VRAM& vram, unsigned sx, unsigned sy,
+	unsigned x, unsigned y, unsigned pitch, int dx, unsigned num,
+	word mask, const byte* lut, byte op)
+{
+	unsigned sLeft;
+	unsigned dLeft = clipRun(sx, x, pitch, dx, num, sLeft);
+	unsigned sLin = (sLeft + sy * pitch) & 0x7FFFF;
+	unsigned dLin = (dLeft + y  * pitch) & 0x7FFFF;
+	if ((num == 1) || ((sLin < dLin + num) && (dLin < sLin + num))) {
+		// Overlapping source and destination: the result depends on
+		// the order in which the pixels are processed, so do it pixel
+		// per pixel.
+		pset(vram, x, y, pitch, point(vram, sx, sy, pitch), mask, lut, op);
+		return 1;
+	}
+	byte* data = vram.getWriteBackdoor();
+	for (unsigned bank = 0; bank < 2; ++bank) {
+		unsigned first = (bank - dLin) & 1;
+		if (first >= num) continue;
+		unsigned dAddr = V9990VRAM::transformBx(dLin + first) & 0x7FFFF;
+		unsigned sAddr = V9990VRAM::transformBx(sLin + first) & 0x7FFFF;
+		V9990LogOps::copyRow8(
+			data + dAddr, data + sAddr, (num - first + 1) / 2,
+			bank ? (mask >> 8) : (mask & 0xFF), op, lut);
+	}
+	return num;
+}
+
 // 16 bpp -------------------------------------------------------------
 inline unsigned V9990CmdEngine::V9990Bpp16::getPitch(unsigned width)
 {
@@ -657,6 +813,41 @@ inline void V9990CmdEngine::V9990Bpp16::psetColor(
 	vram.writeVRAMDirect(addr + 0x40000, result >> 8);
 }
 
+inline unsigned V9990CmdEngine::V9990Bpp16::psetColorRow(
+	V9990VRAM& vram, unsigned x, unsigned y, unsigned pitch,
+	int dx, unsigned num,
+	word color, word mask, const byte* lut, byte op)
+{
+	// Low bytes are stored in the lower, high bytes in the upper half of
+	// VRAM (at the same offset).
+	unsigned addr = addressOf(clipRun(x, pitch, dx, num), y, pitch);
+	byte* data = vram.getWriteBackdoor();
+	V9990LogOps::fillRow16(data + addr, data + addr + 0x40000, num,
+	                       color, mask, op, lut);
+	return num;
+}
+
+inline unsigned V9990CmdEngine::V9990Bpp16::psetRow(
+	V9990VRAM& vram, unsigned sx, unsigned sy,
+	unsigned x, unsigned y, unsigned pitch, int dx, unsigned num,
+	word mask, const byte* lut, byte op)
+{
+	unsigned sLeft;
+	unsigned dLeft = clipRun(sx, x, pitch, dx, num, sLeft);
+	unsigned sAddr = addressOf(sLeft, sy, pitch);
+	unsigned dAddr = addressOf(dLeft, y,  pitch);
+	if ((num == 1) || ((sAddr < dAddr + num) && (dAddr < sAddr + num))) {
+		// overlap, see V9990Bpp8::psetRow()
+		pset(vram, x, y, pitch, point(vram, sx, sy, pitch), mask, lut, op);
+		return 1;
+	}
+	byte* data = vram.getWriteBackdoor();
+	V9990LogOps::copyRow16(data + dAddr, data + dAddr + 0x40000,
+	                       data + sAddr, data + sAddr + 0x40000,
+	                       num, mask, op, lut);
+	return num;
+}
+
 // ====================================================================
 /** Constructor
   */
@@ -927,6 +1118,15 @@ EmuDuration V9990CmdEngine::getTiming(const unsigned table[4][3][4]) const
 	return Clock<V9990DisplayTiming::UC_TICKS_PER_SECOND>::duration(x);
 }
 
+unsigned V9990CmdEngine::getNumPixels(
+	EmuTime::param limit, EmuDuration::param delta, unsigned max) const
+{
+	assert(engineTime < limit);
+	auto remaining = limit - engineTime;
+	if (remaining >= delta * max) return max;
+	return remaining.divUp(delta);
+}
+
 
 // STOP
 void V9990CmdEngine::startSTOP(EmuTime::param time)
@@ -1020,19 +1220,22 @@ void V9990CmdEngine::startLMMV(EmuTime::param time)
 template<typename Mode>
 void V9990CmdEngine::executeLMMV(EmuTime::param limit)
 {
-	// TODO can be optimized a lot
-
 	auto delta = getTiming(LMMV_TIMING);
 	unsigned pitch = Mode::getPitch(vdp.getImageWidth());
 	int dx = (ARG & DIX) ? -1 : 1;
 	int dy = (ARG & DIY) ? -1 : 1;
 	const byte* lut = Mode::getLogOpLUT(LOG);
 	while (engineTime < limit) {
-		engineTime += delta;
-		Mode::psetColor(vram, DX, DY, pitch, fgCol, WM, lut, LOG);
-
-		DX += dx;
-		if (!--(ANX)) {
+		// Depending on the mode this processes a single pixel or a
+		// (part of a) row of pixels. The timing is still per pixel.
+		unsigned n = Mode::psetColorRow(
+			vram, DX, DY, pitch, dx, getNumPixels(limit, delta, ANX),
+			fgCol, WM, lut, LOG);
+		engineTime += delta * n;
+
+		DX += n * dx;
+		ANX -= n;
+		if (!ANX) {
 			DX -= (NX * dx);
 			DY += dy;
 			if (!--(ANY)) {
@@ -1112,22 +1315,22 @@ void V9990CmdEngine::startLMMM(EmuTime::param time)
 template<typename Mode>
 void V9990CmdEngine::executeLMMM(EmuTime::param limit)
 {
-	// TODO can be optimized a lot
-
 	auto delta = getTiming(LMMM_TIMING);
 	unsigned pitch = Mode::getPitch(vdp.getImageWidth());
 	int dx = (ARG & DIX) ? -1 : 1;
 	int dy = (ARG & DIY) ? -1 : 1;
 	const byte* lut = Mode::getLogOpLUT(LOG);
 	while (engineTime < limit) {
-		engineTime += delta;
-		auto src = Mode::point(vram, SX, SY, pitch);
-		src = Mode::shift(src, SX, DX);
-		Mode::pset(vram, DX, DY, pitch, src, WM, lut, LOG);
-
-		DX += dx;
-		SX += dx;
-		if (!--(ANX)) {
+		// single pixel or row of pixels, see executeLMMV()
+		unsigned n = Mode::psetRow(
+			vram, SX, SY, DX, DY, pitch, dx,
+			getNumPixels(limit, delta, ANX), WM, lut, LOG);
+		engineTime += delta * n;
+
+		DX += n * dx;
+		SX += n * dx;
+		ANX -= n;
+		if (!ANX) {
 			DX -= (NX * dx);
 			SX -= (NX * dx);
 			DY += dy;
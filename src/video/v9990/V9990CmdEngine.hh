@@ -98,6 +98,14 @@ private:
 		static inline void psetColor(
 			V9990VRAM& vram, unsigned x, unsigned y, unsigned pitch,
 			word color, word mask, const byte* lut, byte op);
+		static inline unsigned psetColorRow(
+			V9990VRAM& vram, unsigned x, unsigned y, unsigned pitch,
+			int dx, unsigned num,
+			word color, word mask, const byte* lut, byte op);
+		static inline unsigned psetRow(
+			V9990VRAM& vram, unsigned sx, unsigned sy,
+			unsigned x, unsigned y, unsigned pitch, int dx, unsigned num,
+			word mask, const byte* lut, byte op);
 	};
 
 	class V9990P2 {
@@ -119,6 +127,14 @@ private:
 		static inline void psetColor(
 			V9990VRAM& vram, unsigned x, unsigned y, unsigned pitch,
 			word color, word mask, const byte* lut, byte op);
+		static inline unsigned psetColorRow(
+			V9990VRAM& vram, unsigned x, unsigned y, unsigned pitch,
+			int dx, unsigned num,
+			word color, word mask, const byte* lut, byte op);
+		static inline unsigned psetRow(
+			V9990VRAM& vram, unsigned sx, unsigned sy,
+			unsigned x, unsigned y, unsigned pitch, int dx, unsigned num,
+			word mask, const byte* lut, byte op);
 	};
 
 	class V9990Bpp2 {
@@ -140,6 +156,14 @@ private:
 		static inline void psetColor(
 			V9990VRAM& vram, unsigned x, unsigned y, unsigned pitch,
 			word color, word mask, const byte* lut, byte op);
+		static inline unsigned psetColorRow(
+			V9990VRAM& vram, unsigned x, unsigned y, unsigned pitch,
+			int dx, unsigned num,
+			word color, word mask, const byte* lut, byte op);
+		static inline unsigned psetRow(
+			V9990VRAM& vram, unsigned sx, unsigned sy,
+			unsigned x, unsigned y, unsigned pitch, int dx, unsigned num,
+			word mask, const byte* lut, byte op);
 	};
 
 	class V9990Bpp4 {
@@ -161,6 +185,14 @@ private:
 		static inline void psetColor(
 			V9990VRAM& vram, unsigned x, unsigned y, unsigned pitch,
 			word color, word mask, const byte* lut, byte op);
+		static inline unsigned psetColorRow(
+			V9990VRAM& vram, unsigned x, unsigned y, unsigned pitch,
+			int dx, unsigned num,
+			word color, word mask, const byte* lut, byte op);
+		static inline unsigned psetRow(
+			V9990VRAM& vram, unsigned sx, unsigned sy,
+			unsigned x, unsigned y, unsigned pitch, int dx, unsigned num,
+			word mask, const byte* lut, byte op);
 	};
 
 	class V9990Bpp8 {
@@ -182,6 +214,14 @@ private:
 		static inline void psetColor(
 			V9990VRAM& vram, unsigned x, unsigned y, unsigned pitch,
 			word color, word mask, const byte* lut, byte op);
+		static inline unsigned psetColorRow(
+			V9990VRAM& vram, unsigned x, unsigned y, unsigned pitch,
+			int dx, unsigned num,
+			word color, word mask, const byte* lut, byte op);
+		static inline unsigned psetRow(
+			V9990VRAM& vram, unsigned sx, unsigned sy,
+			unsigned x, unsigned y, unsigned pitch, int dx, unsigned num,
+			word mask, const byte* lut, byte op);
 	};
 
 	class V9990Bpp16 {
@@ -203,6 +243,14 @@ private:
 		static inline void psetColor(
 			V9990VRAM& vram, unsigned x, unsigned y, unsigned pitch,
 			word color, word mask, const byte* lut, byte op);
+		static inline unsigned psetColorRow(
+			V9990VRAM& vram, unsigned x, unsigned y, unsigned pitch,
+			int dx, unsigned num,
+			word color, word mask, const byte* lut, byte op);
+		static inline unsigned psetRow(
+			V9990VRAM& vram, unsigned sx, unsigned sy,
+			unsigned x, unsigned y, unsigned pitch, int dx, unsigned num,
+			word mask, const byte* lut, byte op);
 	};
 
 	void startSTOP  (EmuTime::param time);
@@ -315,6 +363,13 @@ private:
 	void setCommandMode();
 	EmuDuration getTiming(const unsigned table[4][3][4]) const;
 
+	/** The number of pixels (at most 'max') that can be processed before
+	  * 'limit' is reached, when each pixel takes 'delta'. Must only be
+	  * called when engineTime < limit (so the result is at least 1).
+	  */
+	unsigned getNumPixels(EmuTime::param limit, EmuDuration::param delta,
+	                      unsigned max) const;
+
 	inline unsigned getWrappedNX() const {
 		return NX ? NX : 2048;
 	}
@@ -0,0 +1,226 @@
+#include "V9990LogOps.hh"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace openmsx {
+namespace V9990LogOps {
+
+// The lower 4 bits of the LOG register form a truth table: bit 'n' is the
+// result for (src, dst) == (n >> 1, n & 1). These are the operations that
+// have a dedicated implementation.
+static const byte OP_IMP = 0x0C;
+static const byte OP_AND = 0x08;
+static const byte OP_OR  = 0x0E;
+static const byte OP_XOR = 0x06;
+static const byte TRANSPARENT = 0x10;
+
+struct ImpOp {
+	byte operator()(byte s, byte /*d*/) const { return s; }
+#ifdef __SSE2__
+	__m128i operator()(__m128i s, __m128i /*d*/) const { return s; }
+#endif
+};
+struct AndOp {
+	byte operator()(byte s, byte d) const { return s & d; }
+#ifdef __SSE2__
+	__m128i operator()(__m128i s, __m128i d) const { return _mm_and_si128(s, d); }
+#endif
+};
+struct OrOp {
+	byte operator()(byte s, byte d) const { return s | d; }
+#ifdef __SSE2__
+	__m128i operator()(__m128i s, __m128i d) const { return _mm_or_si128(s, d); }
+#endif
+};
+struct XorOp {
+	byte operator()(byte s, byte d) const { return s ^ d; }
+#ifdef __SSE2__
+	__m128i operator()(__m128i s, __m128i d) const { return _mm_xor_si128(s, d); }
+#endif
+};
+
+template<bool TRANSP_, typename Op_> struct Tag {
+	static const bool TRANSP = TRANSP_;
+	using Op = Op_;
+};
+
+// Calls 'f' with a Tag<> that corresponds to 'op'. Returns false (without
+// calling 'f') when there's no dedicated implementation for 'op'.
+template<typename Func> static inline bool dispatch(byte op, Func f)
+{
+	bool transp = (op & TRANSPARENT) != 0;
+	switch (op & 0x0F) {
+	case OP_IMP: transp ? f(Tag<true, ImpOp>()) : f(Tag<false, ImpOp>()); return true;
+	case OP_AND: transp ? f(Tag<true, AndOp>()) : f(Tag<false, AndOp>()); return true;
+	case OP_OR:  transp ? f(Tag<true, OrOp >()) : f(Tag<false, OrOp >()); return true;
+	case OP_XOR: transp ? f(Tag<true, XorOp>()) : f(Tag<false, XorOp>()); return true;
+	default: return false;
+	}
+}
+
+static inline byte select(byte d, byte r, byte mask)
+{
+	return (d & ~mask) | (r & mask);
+}
+
+#ifdef __SSE2__
+static inline __m128i select(__m128i d, __m128i r, __m128i mask)
+{
+	return _mm_xor_si128(_mm_and_si128(_mm_xor_si128(d, r), mask), d);
+}
+static inline __m128i load(const byte* p)
+{
+	return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+static inline void store(byte* p, __m128i v)
+{
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(p), v);
+}
+#endif
+
+
+template<typename Op>
+static void fillRowImpl(byte* dst, size_t num, byte src, byte mask, Op op)
+{
+	size_t i = 0;
+#ifdef __SSE2__
+	__m128i s = _mm_set1_epi8(char(src));
+	__m128i m = _mm_set1_epi8(char(mask));
+	for (/**/; (i + 16) <= num; i += 16) {
+		__m128i d = load(dst + i);
+		store(dst + i, select(d, op(s, d), m));
+	}
+#endif
+	for (/**/; i < num; ++i) {
+		dst[i] = select(dst[i], op(src, dst[i]), mask);
+	}
+}
+
+static void fillRowLUT(byte* dst, size_t num, byte src, byte mask,
+                       const byte* lut)
+{
+	for (size_t i = 0; i < num; ++i) {
+		dst[i] = select(dst[i], lut[256 * dst[i] + src], mask);
+	}
+}
+
+void fillRow8(byte* dst, size_t num, byte src, byte mask,
+              byte op, const byte* lut)
+{
+	if (dispatch(op, [&](auto tag) {
+		using T = decltype(tag);
+		// For a constant source, transparency simply means: do nothing.
+		if (T::TRANSP && (src == 0)) return;
+		fillRowImpl(dst, num, src, mask, typename T::Op());
+	})) return;
+	fillRowLUT(dst, num, src, mask, lut);
+}
+
+void fillRow16(byte* dstLo, byte* dstHi, size_t num, word src, word mask,
+               byte op, const byte* lut)
+{
+	if ((op & TRANSPARENT) && (src == 0)) return;
+	if (dispatch(op, [&](auto tag) {
+		using T = decltype(tag);
+		fillRowImpl(dstLo, num, src & 0xFF, mask & 0xFF, typename T::Op());
+		fillRowImpl(dstHi, num, src >> 8,   mask >> 8,   typename T::Op());
+	})) return;
+	fillRowLUT(dstLo, num, src & 0xFF, mask & 0xFF, lut);
+	fillRowLUT(dstHi, num, src >> 8,   mask >> 8,   lut);
+}
+
+
+template<bool TRANSP, typename Op>
+static void copyRow8Impl(byte* dst, const byte* src, size_t num, byte mask, Op op)
+{
+	size_t i = 0;
+#ifdef __SSE2__
+	__m128i m = _mm_set1_epi8(char(mask));
+	__m128i zero = _mm_setzero_si128();
+	for (/**/; (i + 16) <= num; i += 16) {
+		__m128i s = load(src + i);
+		__m128i d = load(dst + i);
+		__m128i r = op(s, d);
+		if (TRANSP) r = select(r, d, _mm_cmpeq_epi8(s, zero));
+		store(dst + i, select(d, r, m));
+	}
+#endif
+	for (/**/; i < num; ++i) {
+		byte s = src[i];
+		byte d = dst[i];
+		if (TRANSP && (s == 0)) continue;
+		dst[i] = select(d, op(s, d), mask);
+	}
+}
+
+void copyRow8(byte* dst, const byte* src, size_t num, byte mask,
+              byte op, const byte* lut)
+{
+	if (dispatch(op, [&](auto tag) {
+		using T = decltype(tag);
+		copyRow8Impl<T::TRANSP>(dst, src, num, mask, typename T::Op());
+	})) return;
+	for (size_t i = 0; i < num; ++i) {
+		dst[i] = select(dst[i], lut[256 * dst[i] + src[i]], mask);
+	}
+}
+
+
+template<bool TRANSP, typename Op>
+static void copyRow16Impl(byte* dstLo, byte* dstHi,
+                          const byte* srcLo, const byte* srcHi,
+                          size_t num, word mask, Op op)
+{
+	size_t i = 0;
+#ifdef __SSE2__
+	__m128i mLo = _mm_set1_epi8(char(mask & 0xFF));
+	__m128i mHi = _mm_set1_epi8(char(mask >> 8));
+	__m128i zero = _mm_setzero_si128();
+	for (/**/; (i + 16) <= num; i += 16) {
+		__m128i sLo = load(srcLo + i);
+		__m128i sHi = load(srcHi + i);
+		__m128i dLo = load(dstLo + i);
+		__m128i dHi = load(dstHi + i);
+		__m128i rLo = op(sLo, dLo);
+		__m128i rHi = op(sHi, dHi);
+		if (TRANSP) {
+			__m128i t = _mm_and_si128(_mm_cmpeq_epi8(sLo, zero),
+			                          _mm_cmpeq_epi8(sHi, zero));
+			rLo = select(rLo, dLo, t);
+			rHi = select(rHi, dHi, t);
+		}
+		store(dstLo + i, select(dLo, rLo, mLo));
+		store(dstHi + i, select(dHi, rHi, mHi));
+	}
+#endif
+	for (/**/; i < num; ++i) {
+		byte sLo = srcLo[i];
+		byte sHi = srcHi[i];
+		if (TRANSP && ((sLo | sHi) == 0)) continue;
+		dstLo[i] = select(dstLo[i], op(sLo, dstLo[i]), mask & 0xFF);
+		dstHi[i] = select(dstHi[i], op(sHi, dstHi[i]), mask >> 8);
+	}
+}
+
+void copyRow16(byte* dstLo, byte* dstHi,
+               const byte* srcLo, const byte* srcHi, size_t num, word mask,
+               byte op, const byte* lut)
+{
+	if (dispatch(op, [&](auto tag) {
+		using T = decltype(tag);
+		copyRow16Impl<T::TRANSP>(dstLo, dstHi, srcLo, srcHi, num, mask,
+		                         typename T::Op());
+	})) return;
+	bool transp = (op & TRANSPARENT) != 0;
+	for (size_t i = 0; i < num; ++i) {
+		byte sLo = srcLo[i];
+		byte sHi = srcHi[i];
+		if (transp && ((sLo | sHi) == 0)) continue;
+		dstLo[i] = select(dstLo[i], lut[256 * dstLo[i] + sLo], mask & 0xFF);
+		dstHi[i] = select(dstHi[i], lut[256 * dstHi[i] + sHi], mask >> 8);
+	}
+}
+
+} // namespace V9990LogOps
+} // namespace openmsx
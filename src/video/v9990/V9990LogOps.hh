@@ -0,0 +1,54 @@
+#ifndef V9990LOGOPS_HH
+#define V9990LOGOPS_HH
+
+#include "openmsx.hh"
+#include <cstddef>
+
+namespace openmsx {
+
+/** Row-at-a-time versions of the logical operations of the V9990 command
+  * engine.
+  *
+  * In the 8bpp and 16bpp modes the pixels of a horizontal run are stored
+  * in (at most two) contiguous VRAM ranges. That allows the LMMV and LMMM
+  * commands to process such a run in one go, instead of pixel per pixel.
+  *
+  * 'op' is the value of the LOG register: the lower 4 bits select one of
+  * the 16 logical operations, bit 4 enables transparency. 'lut' is the
+  * 256x256 lookup table for that operation (see getLogOpLUT() in
+  * V9990CmdEngine.cc). The common operations (IMP, AND, OR, XOR) have a
+  * dedicated (SSE2) implementation, the other operations use 'lut'.
+  */
+namespace V9990LogOps {
+
+/** 8bpp: dst[i] = (dst[i] & ~mask) | (op(src, dst[i]) & mask)
+  * The lookup table must already handle transparency (that's the case for
+  * the 8bpp tables in the command engine).
+  */
+void fillRow8(byte* dst, size_t num, byte src, byte mask,
+              byte op, const byte* lut);
+
+/** Like fillRow8(), but with a different source value per pixel.
+  * The 'src' and 'dst' ranges should not overlap.
+  */
+void copyRow8(byte* dst, const byte* src, size_t num, byte mask,
+              byte op, const byte* lut);
+
+/** 16bpp: the low and high bytes of the pixels are stored in separate
+  * planes. Transparency only applies when the full 16-bit source value is
+  * zero, so here the lookup table should NOT handle transparency.
+  */
+void fillRow16(byte* dstLo, byte* dstHi, size_t num, word src, word mask,
+               byte op, const byte* lut);
+
+/** Like fillRow16(), but with a different source value per pixel.
+  * The source and destination ranges should not overlap.
+  */
+void copyRow16(byte* dstLo, byte* dstHi,
+               const byte* srcLo, const byte* srcHi, size_t num, word mask,
+               byte op, const byte* lut);
+
+} // namespace V9990LogOps
+} // namespace openmsx
+
+#endif
@@ -78,6 +78,16 @@ public:
 		data.write(address, value);
 	}
 
+	/** Direct access to the VRAM data, for bulk operations. See
+	  * TrackedRam::getWriteBackdoor().
+	  */
+	inline const byte* getData() const {
+		return &data[0];
+	}
+	inline byte* getWriteBackdoor() {
+		return data.getWriteBackdoor();
+	}
+
 	byte readVRAMCPU(unsigned address, EmuTime::param time);
 	void writeVRAMCPU(unsigned address, byte val, EmuTime::param time);
 